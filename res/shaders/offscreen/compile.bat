@@ -2,5 +2,6 @@
 
 C:\VulkanSDK\1.2.182.0\Bin\glslc.exe hdr.vert -o hdr_vert.spv
 C:\VulkanSDK\1.2.182.0\Bin\glslc.exe hdr.frag -o hdr_frag.spv
+C:\VulkanSDK\1.2.182.0\Bin\glslc.exe hdr_input.frag -o hdr_input_frag.spv
 
 pause
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 460 core
+
+layout(location = 0) out vec4 OutputColor;
+
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput HdrColor;
+
+void main()
+{
+    vec3 color = subpassLoad(HdrColor).xyz;
+
+    //Tone mapping
+    const float exposure = 1.0f;
+    color = vec3(1.0f) - exp(-color * exposure);
+
+    OutputColor = vec4(color, 1.0f);
+}
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
 
-#ifdef LIB
-	#define API __declspec(dllexport)
+#ifdef _WIN32
+	#ifdef LIB
+		#define API __declspec(dllexport)
+	#else
+		#define API __declspec(dllimport)
+	#endif
 #else
-	#define API __declspec(dllimport)
+	//Symbols are visible by default outside of windows
+	#define API
 #endif
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "engine/engine.h"
+#include "bench/bench_scene.h"
+
+#include <sstream>
+#include <iomanip>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+struct FrameTimeStats
+{
+	float Average = 0.0f;
+	float P50 = 0.0f;
+	float P95 = 0.0f;
+	float P99 = 0.0f;
+};
+
+FrameTimeStats ComputeFrameTimeStats(std::vector<float> samples)
+{
+	FrameTimeStats stats;
+
+	if (samples.empty())
+		return stats;
+
+	std::sort(samples.begin(), samples.end());
+
+	auto percentile = [&](const float p)
+	{
+		return samples[static_cast<size_t>(p * (samples.size() - 1) + 0.5f)];
+	};
+
+	float sum = 0.0f;
+	for (auto s : samples)
+		sum += s;
+
+	stats.Average = sum / samples.size();
+	stats.P50 = percentile(0.50f);
+	stats.P95 = percentile(0.95f);
+	stats.P99 = percentile(0.99f);
+
+	return stats;
+}
+
+//Resident set size, nothing on platforms without procfs
+std::optional<uint64_t> GetProcessMemory()
+{
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+
+	uint64_t size, resident;
+	if (statm >> size >> resident)
+		return resident * sysconf(_SC_PAGESIZE);
+#endif
+
+	return std::nullopt;
+}
+
+void WriteStats(std::ostream& out, const char* name, const FrameTimeStats& stats)
+{
+	out << "\"" << name << "\":{\"avg\":" << stats.Average << ",\"p50\":" << stats.P50
+		<< ",\"p95\":" << stats.P95 << ",\"p99\":" << stats.P99 << "}";
+}
+
+template<typename T>
+void WriteOptional(std::ostream& out, const char* name, const std::optional<T>& value)
+{
+	out << "\"" << name << "\":";
+
+	if (value)
+		out << *value;
+	else
+		out << "null";
+}
+
+bool IsDisplayAvailable()
+{
+#ifdef __linux__
+	return std::getenv("DISPLAY") || std::getenv("WAYLAND_DISPLAY");
+#else
+	return true;
+#endif
+}
+
+//VRenderBench SCENE [--frames N] [--resolution W H] [--headless] [--workers N] [--no-render-thread] [--assert-no-alloc] [--out FILE]
+//                   [--save-scene FILE]
+//Flies the camera along the scene path and prints frame time percentiles as json. --save-scene writes the built scene
+//as a scene file to load with a scenefile entry
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: VRenderBench SCENE [--frames N] [--resolution W H] [--headless] [--workers N] [--no-render-thread] [--assert-no-alloc] [--out FILE] [--save-scene FILE]\n");
+		return 1;
+	}
+
+	//Engine changes the working directory on startup
+	auto scenePath = std::filesystem::absolute(argv[1]).string();
+	std::string outPath;
+	std::string saveScenePath;
+
+	std::optional<uint32_t> framesOverride;
+	uint32_t workersCount = 0;
+	bool headless = !IsDisplayAvailable();
+	bool assertNoAllocations = false;
+	bool renderThread = true;
+
+	uint16_t width = 1280;
+	uint16_t height = 720;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--headless")
+			headless = true;
+		else if (arg == "--frames" && i + 1 < argc)
+			framesOverride = std::stoul(argv[++i]);
+		else if (arg == "--resolution" && i + 2 < argc)
+		{
+			width = std::stoul(argv[++i]);
+			height = std::stoul(argv[++i]);
+		}
+		else if (arg == "--workers" && i + 1 < argc)
+			workersCount = std::stoul(argv[++i]);
+		else if (arg == "--no-render-thread")
+			renderThread = false;
+		else if (arg == "--assert-no-alloc")
+			assertNoAllocations = true;
+		else if (arg == "--out" && i + 1 < argc)
+			outPath = std::filesystem::absolute(argv[++i]).string();
+		else if (arg == "--save-scene" && i + 1 < argc)
+			saveScenePath = std::filesystem::absolute(argv[++i]).string();
+	}
+
+	app::Engine engine;
+	engine.Headless = headless;
+	engine.WindowWidth = width;
+	engine.WindowHeight = height;
+	engine.WorkerThreadsCount = workersCount;
+	engine.UseRenderThread = renderThread;
+
+	if (!engine.StartupEngine())
+		return 1;
+
+	auto description = bench::LoadSceneDescription(scenePath);
+	if (!description)
+	{
+		engine.CleanupEngine();
+		return 1;
+	}
+
+	if (framesOverride)
+		description->FramesCount = *framesOverride;
+
+	engine.AssetManager.LoadAssetsFromFolder("res/assets"_ep);
+
+	bench::BenchScene scene;
+	if (!scene.Build(engine, *description))
+	{
+		engine.CleanupEngine();
+		return 1;
+	}
+
+	if (!saveScenePath.empty() && !engine.SceneManager.SaveScene(saveScenePath, scene.GetMaterials()))
+	{
+		engine.CleanupEngine();
+		return 1;
+	}
+
+	const auto& extent = engine.VulkanApp.SwapChainExtent;
+
+	render::Camera camera;
+	camera.SetupAsPerspective(description->Path[0].Position, 45.0f, (float)extent.width / extent.height, 5.0f, 0.1f, 1000.0f);
+
+	engine.SceneManager.Register(camera);
+	engine.SceneManager.SetActiveCamera(0);
+
+	const uint32_t framesCount = description->FramesCount;
+
+	std::vector<float> cpuTimes;
+	std::vector<float> gpuTimes;
+	std::vector<float> latencies;
+	cpuTimes.reserve(framesCount);
+	gpuTimes.reserve(framesCount);
+	latencies.reserve(framesCount);
+
+	uint32_t frame = 0;
+
+	//Wrapped once so measured frames don't construct the callback
+	std::function<void()> flyCamera = [&]()
+	{
+		float t = framesCount > 1 ? (float)frame / (framesCount - 1) : 0.0f;
+		auto w = bench::SamplePath(description->Path, t);
+
+		camera.Position = w.Position;
+		camera.SetRotation(w.Yaw, w.Pitch);
+	};
+
+#ifdef VRENDER_TRACK_ALLOCATIONS
+	debug::GlobalAllocationTracker.AssertSteadyState = assertNoAllocations;
+	debug::GlobalAllocationTracker.WarmupFrames = debug::GlobalAllocationTracker.GetFramesCount() + description->WarmupFrames;
+#else
+	if (assertNoAllocations)
+		printf("--assert-no-alloc needs VRENDER_TRACK_ALLOCATIONS, ignored\n");
+#endif
+
+	//Warmup lets uploads and compute jobs finish before anything is measured
+	engine.RunFrames(description->WarmupFrames, flyCamera);
+
+	engine.Jobs.ResetStats();
+
+	utils::Timer timer;
+
+#ifdef VRENDER_TRACK_ALLOCATIONS
+	uint64_t allocationsBegin = debug::GlobalAllocationTracker.GetTotal().Count;
+#endif
+
+	for (; frame < framesCount; ++frame)
+	{
+		//Waits for the render thread, so the readbacks below don't race with it
+		timer.Start();
+		engine.RunFrames(1, flyCamera);
+		cpuTimes.push_back(timer.GetElapsedTime());
+
+		auto gpuTime = engine.RenderManager.GetQueueTimings().Graphics;
+		gpuTimes.push_back((gpuTime.End - gpuTime.Begin) / 1e6f);
+
+		latencies.push_back(engine.RenderManager.GetSnapshotLatency());
+	}
+
+	std::optional<float> allocationsPerFrame;
+#ifdef VRENDER_TRACK_ALLOCATIONS
+	allocationsPerFrame = (float)(debug::GlobalAllocationTracker.GetTotal().Count - allocationsBegin) / std::max(framesCount, 1u);
+#endif
+
+	auto drawStats = engine.RenderManager.GetDrawStats();
+	auto deviceMemory = vk::GetDeviceMemoryUsage(engine.VulkanApp);
+
+	std::optional<uint64_t> deviceMemoryUsed;
+	if (deviceMemory)
+		deviceMemoryUsed = deviceMemory->Used;
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(3);
+
+	json << "{\"scene\":\"" << std::filesystem::path(scenePath).filename().string() << "\""
+		 << ",\"device\":\"" << engine.VulkanApp.DeviceProperties.deviceName << "\""
+		 << ",\"headless\":" << (headless ? "true" : "false")
+		 << ",\"render_thread\":" << (renderThread ? "true" : "false")
+		 << ",\"frames\":" << framesCount << ",";
+
+	WriteStats(json, "cpu_frame_ms", ComputeFrameTimeStats(cpuTimes));
+	json << ",";
+	WriteStats(json, "gpu_frame_ms", ComputeFrameTimeStats(gpuTimes));
+	json << ",";
+	WriteStats(json, "snapshot_latency_ms", ComputeFrameTimeStats(latencies));
+
+	json << ",\"draws\":" << drawStats.DrawsCount << ",\"vertices\":" << drawStats.VerticesCount << ",";
+
+	WriteOptional(json, "device_memory_bytes", deviceMemoryUsed);
+	json << ",";
+	WriteOptional(json, "process_memory_bytes", GetProcessMemory());
+	json << ",";
+	WriteOptional(json, "allocations_per_frame", allocationsPerFrame);
+
+	json << ",\"gpu_scopes\":[";
+
+	auto scopes = engine.RenderManager.GetGpuStats();
+	for (size_t i = 0; i < scopes.size(); ++i)
+	{
+		const auto& s = scopes[i];
+
+		if (i > 0)
+			json << ",";
+
+		json << "{\"name\":\"" << s.Name << "\",\"avg\":" << s.Average << ",\"p50\":" << s.P50
+			 << ",\"p95\":" << s.P95 << ",\"p99\":" << s.P99 << "}";
+	}
+
+	json << "],\"workers\":[";
+
+	//Measured frames only, stats were reset after the warmup
+	auto workers = engine.Jobs.GetStats();
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		const auto& w = workers[i];
+
+		if (i > 0)
+			json << ",";
+
+		json << "{\"jobs\":" << w.Jobs << ",\"steals\":" << w.Steals << ",\"idle_ms\":" << w.IdleTime / 1e6 << "}";
+	}
+
+	json << "]}";
+
+	engine.CleanupEngine();
+
+	printf("%s\n", json.str().c_str());
+
+	if (!outPath.empty())
+	{
+		std::ofstream out(outPath, std::ios::trunc);
+		out << json.str();
+
+		if (!out.good())
+			return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
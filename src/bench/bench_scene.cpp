@@ -0,0 +1,296 @@
+#include "bench_scene.h"
+
+#include <sstream>
+
+namespace bench
+{
+	inline std::string ToPlatformPath(const std::string& path)
+	{
+		return std::filesystem::path(path).make_preferred().string();
+	}
+
+	std::optional<SceneDescription> LoadSceneDescription(const std::string& filepath)
+	{
+		std::ifstream file(filepath);
+		if (!file.is_open())
+		{
+			LOGE("Couldn't open scene description %s!", filepath.c_str());
+			return std::nullopt;
+		}
+
+		SceneDescription description;
+
+		std::string line;
+		uint32_t lineNumber = 0;
+
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+
+			auto comment = line.find('#');
+			if (comment != std::string::npos)
+				line.erase(comment);
+
+			std::istringstream stream(line);
+
+			std::string entry;
+			if (!(stream >> entry))
+				continue;
+
+			bool valid = true;
+
+			if (entry == "frames")
+			{
+				valid = static_cast<bool>(stream >> description.FramesCount);
+			}
+			else if (entry == "warmup")
+			{
+				valid = static_cast<bool>(stream >> description.WarmupFrames);
+			}
+			else if (entry == "skybox")
+			{
+				valid = static_cast<bool>(stream >> description.Skybox);
+			}
+			else if (entry == "material")
+			{
+				MaterialDescription m;
+				valid = static_cast<bool>(stream >> m.Name >> m.Albedo >> m.Normal >> m.MetalRoughness >> m.Ao);
+
+				description.Materials.push_back(m);
+			}
+			else if (entry == "mesh")
+			{
+				MeshDescription m;
+				valid = static_cast<bool>(stream >> m.Model >> m.Material >> m.Position.x >> m.Position.y >> m.Position.z);
+
+				if (!(stream >> m.Scale))
+					m.Scale = 1.0f;
+
+				description.Meshes.push_back(m);
+			}
+			else if (entry == "pointlight")
+			{
+				LightDescription l;
+				valid = static_cast<bool>(stream >> l.Position.x >> l.Position.y >> l.Position.z
+											   >> l.Color.x >> l.Color.y >> l.Color.z);
+
+				description.PointLights.push_back(l);
+			}
+			else if (entry == "model")
+			{
+				std::string model;
+				valid = static_cast<bool>(stream >> model);
+
+				description.GeneratorModels.push_back(model);
+			}
+			else if (entry == "generate")
+			{
+				scene::GeneratorSettings g;
+				valid = static_cast<bool>(stream >> g.Seed >> g.MeshesCount >> g.Depth >> g.Branching
+											   >> g.PointLightsCount >> g.SpotlightsCount >> g.Extent);
+
+				description.Generator = g;
+			}
+			else if (entry == "scenefile")
+			{
+				std::string file;
+				valid = static_cast<bool>(stream >> file);
+
+				description.SceneFile = (std::filesystem::path(filepath).parent_path() / ToPlatformPath(file)).string();
+			}
+			else if (entry == "cellsize")
+			{
+				float size;
+				valid = static_cast<bool>(stream >> size) && size > 0.0f;
+
+				description.CellSize = size;
+			}
+			else if (entry == "cell")
+			{
+				CellDescription c;
+				std::string file;
+				valid = static_cast<bool>(stream >> c.Coords.x >> c.Coords.y >> file);
+
+				c.File = (std::filesystem::path(filepath).parent_path() / ToPlatformPath(file)).string();
+
+				description.Cells.push_back(c);
+			}
+			else if (entry == "waypoint")
+			{
+				CameraWaypoint w;
+				valid = static_cast<bool>(stream >> w.Position.x >> w.Position.y >> w.Position.z >> w.Yaw >> w.Pitch);
+
+				w.Yaw = glm::radians(w.Yaw);
+				w.Pitch = glm::radians(w.Pitch);
+
+				description.Path.push_back(w);
+			}
+			else
+			{
+				valid = false;
+			}
+
+			if (!valid)
+			{
+				LOGE("Invalid entry at line %d of %s!", lineNumber, filepath.c_str());
+				return std::nullopt;
+			}
+		}
+
+		if (description.Path.empty())
+		{
+			LOGE("Scene description %s has no camera waypoints!", filepath.c_str());
+			return std::nullopt;
+		}
+
+		return description;
+	}
+
+	CameraWaypoint SamplePath(const std::vector<CameraWaypoint>& path, const float t)
+	{
+		if (path.size() == 1)
+			return path[0];
+
+		float position = std::clamp(t, 0.0f, 1.0f) * (path.size() - 1);
+
+		size_t segment = std::min(static_cast<size_t>(position), path.size() - 2);
+		float f = position - segment;
+
+		const auto& a = path[segment];
+		const auto& b = path[segment + 1];
+
+		CameraWaypoint w;
+		w.Position = glm::mix(a.Position, b.Position, f);
+		w.Yaw = glm::mix(a.Yaw, b.Yaw, f);
+		w.Pitch = glm::mix(a.Pitch, b.Pitch, f);
+
+		return w;
+	}
+
+	bool BenchScene::Build(app::Engine& engine, const SceneDescription& description)
+	{
+		auto& rm = engine.RenderManager;
+
+		if (!description.Skybox.empty())
+		{
+			rm.SetupIBL(ToPlatformPath(description.Skybox));
+
+			auto hdrMaterial = std::make_shared<render::HdrMaterial>();
+			hdrMaterial->HdrTexture.Image = rm.GetIblCubemap();
+
+			Materials.Add("skybox", hdrMaterial);
+		}
+
+		if (!description.Skybox.empty() && description.SceneFile.empty())
+		{
+			auto skybox = Store.Get(Store.Create<scene::MeshRenderable>());
+			skybox->Mesh = ToPlatformPath("models/cube.obj");
+			skybox->Material = Materials.Find("skybox");
+			skybox->Render.DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+			skybox->Render.FacesCullMode = VK_CULL_MODE_FRONT_BIT;
+			skybox->Render.FrustumCulled = false;
+		}
+
+		for (const auto& m : description.Materials)
+		{
+			auto material = std::make_shared<render::PbrMaterial>();
+			material->Textures.Albedo.Image = ToPlatformPath(m.Albedo);
+			material->Textures.Normal.Image = ToPlatformPath(m.Normal);
+
+			material->Textures.Metallic.Image = ToPlatformPath(m.MetalRoughness);
+			material->Textures.Metallic.Channels = { IC::B, IC::B, IC::B, IC::B };
+
+			material->Textures.Roughness.Image = ToPlatformPath(m.MetalRoughness);
+			material->Textures.Roughness.Channels = { IC::G, IC::G, IC::G, IC::G };
+
+			material->Textures.Ao.Image = ToPlatformPath(m.Ao);
+
+			if (!description.Skybox.empty())
+				material->Textures.IrradianceMap.Image = rm.GetIrradianceMap();
+
+			Materials.Add(m.Name, material);
+		}
+
+		for (const auto& m : description.Meshes)
+		{
+			auto material = Materials.Find(m.Material);
+			if (!material)
+			{
+				LOGE("Unknown material %s!", m.Material.c_str());
+				return false;
+			}
+
+			auto mesh = Store.Get(Store.Create<scene::MeshRenderable>());
+			mesh->Mesh = ToPlatformPath(m.Model);
+			mesh->Material = material;
+			mesh->SetPosition(m.Position);
+			mesh->SetScale(glm::vec3(m.Scale));
+		}
+
+		size_t lightsCount = description.PointLights.size();
+		if (description.Generator)
+			lightsCount += description.Generator->PointLightsCount;
+
+		if (lightsCount > manager::MaxPointLights)
+		{
+			LOGE("Scene has more than %d point lights!", manager::MaxPointLights);
+			return false;
+		}
+
+		for (const auto& l : description.PointLights)
+		{
+			auto light = Store.Get(Store.Create<scene::PointLight>());
+			light->SetPosition(l.Position);
+			light->Color = l.Color;
+		}
+
+		if (description.Generator)
+		{
+			auto settings = *description.Generator;
+
+			for (const auto& m : description.GeneratorModels)
+				settings.Meshes.push_back(ToPlatformPath(m));
+
+			//Declaration order keeps the picks deterministic
+			for (const auto& m : description.Materials)
+				settings.Materials.push_back(Materials.Find(m.Name));
+
+			if (!Generated.Generate(settings))
+				return false;
+
+			Root.AttachChild(&Generated.GetRoot());
+		}
+
+		if (!description.SceneFile.empty())
+		{
+			if (!Loaded.Load(description.SceneFile, Materials))
+				return false;
+
+			Root.AttachChild(&Loaded.GetRoot());
+		}
+
+		if (!description.Cells.empty())
+		{
+			auto& partition = engine.WorldPartition;
+
+			if (description.CellSize)
+				partition.CellSize = *description.CellSize;
+
+			for (const auto& c : description.Cells)
+			{
+				if (!partition.AddCell(c.Coords, c.File, Materials))
+					return false;
+			}
+
+			Root.AttachChild(&partition.GetRoot());
+		}
+
+		//Pool order is creation order, same as the description
+		Store.GetPool<scene::MeshRenderable>().ForEach([&](scene::MeshRenderable& m) { Root.AttachChild(&m); });
+		Store.GetPool<scene::PointLight>().ForEach([&](scene::PointLight& l) { Root.AttachChild(&l); });
+
+		engine.SceneManager.SetRoot(&Root);
+
+		return true;
+	}
+}
\ No newline at end of file
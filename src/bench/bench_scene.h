@@ -0,0 +1,110 @@
+#pragma once
+#include "vrender.h"
+
+#include <optional>
+
+#include "engine/engine.h"
+#include "scene/scene_file.h"
+#include "scene/scene_generator.h"
+
+namespace bench
+{
+	struct CameraWaypoint
+	{
+		glm::vec3 Position;
+		//Radians
+		float Yaw;
+		float Pitch;
+	};
+
+	struct MaterialDescription
+	{
+		std::string Name;
+
+		std::string Albedo;
+		std::string Normal;
+		std::string MetalRoughness;
+		std::string Ao;
+	};
+
+	struct MeshDescription
+	{
+		std::string Model;
+		std::string Material;
+
+		glm::vec3 Position;
+		float Scale;
+	};
+
+	struct LightDescription
+	{
+		glm::vec3 Position;
+		glm::vec3 Color;
+	};
+
+	struct CellDescription
+	{
+		glm::ivec2 Coords;
+		std::string File;
+	};
+
+	//Text file with one entry per line, '#' starts a comment:
+	//frames N, warmup N, skybox HDR,
+	//material NAME ALBEDO NORMAL METAL_ROUGHNESS AO, mesh MODEL MATERIAL X Y Z [SCALE],
+	//pointlight X Y Z R G B, waypoint X Y Z YAW PITCH (degrees),
+	//model MODEL, generate SEED MESHES DEPTH BRANCHING POINTLIGHTS SPOTLIGHTS EXTENT, scenefile FILE,
+	//cellsize SIZE, cell X Z FILE.
+	//Generated meshes pick from every model and material entry. Scene files resolve materials by their entry names,
+	//the skybox material is named skybox and the skybox mesh is expected in the file. Cells are scene files
+	//streamed around the camera by the world partition.
+	//Scene and cell files are relative to the description, other paths to the assets folder
+	struct SceneDescription
+	{
+		uint32_t FramesCount = 600;
+		uint32_t WarmupFrames = 30;
+
+		std::string Skybox;
+
+		std::vector<MaterialDescription> Materials;
+		std::vector<MeshDescription> Meshes;
+		std::vector<LightDescription> PointLights;
+
+		std::vector<std::string> GeneratorModels;
+		std::optional<scene::GeneratorSettings> Generator;
+
+		std::string SceneFile;
+
+		std::optional<float> CellSize;
+		std::vector<CellDescription> Cells;
+
+		std::vector<CameraWaypoint> Path;
+	};
+
+	std::optional<SceneDescription> LoadSceneDescription(const std::string& filepath);
+
+	//Linear interpolation between waypoints, t goes from 0 to 1 over the whole path
+	CameraWaypoint SamplePath(const std::vector<CameraWaypoint>& path, const float t);
+
+	//Owns every node handed to the scene manager, so it has to outlive the run
+	class BenchScene
+	{
+	private:
+		scene::Node Root;
+
+		scene::GeneratedScene Generated;
+		scene::LoadedScene Loaded;
+
+		//Declared last, so pooled nodes are detached while the roots still exist
+		scene::SceneStore Store;
+
+		scene::MaterialLibrary Materials;
+	public:
+		bool Build(app::Engine& engine, const SceneDescription& description);
+
+		//Every material of the description under its name, for saving the built scene
+		inline const scene::MaterialLibrary& GetMaterials() const
+		{
+			return Materials;
+		}
+	};
+}
\ No newline at end of file
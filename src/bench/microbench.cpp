@@ -0,0 +1,686 @@
+#include "engine/engine.h"
+#include "scene/bvh.h"
+#include "scene/scene_file.h"
+#include "scene/scene_generator.h"
+#include "scene/scene_store.h"
+#include "scene/transform_batch.h"
+#include "utils/job_system.h"
+
+#include "assimp/mesh.h"
+
+#ifndef VRENDER_TRACK_ALLOCATIONS
+#error VRenderMicrobench counts allocations through the allocation tracker
+#endif
+
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace bench
+{
+	//Keeps the compiler from dropping results that are never read
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const void* volatile sink;
+		sink = &value;
+#endif
+	}
+
+	struct MicrobenchSettings
+	{
+		uint32_t Repetitions = 10;
+		//Iterations are doubled until one repetition takes at least this long
+		float MinRepetitionMs = 20.0f;
+
+		std::string Filter;
+	};
+
+	struct MicrobenchResult
+	{
+		std::string Name;
+
+		uint64_t Iterations = 0;
+
+		//Over the repetitions
+		double MedianNs = 0.0;
+		double MinNs = 0.0;
+		double StdDevNs = 0.0;
+
+		double AllocationsPerOp = 0.0;
+		//Items processed per second at the median time, an op may process many items
+		double ItemsPerSecond = 0.0;
+	};
+
+	//Runs body(iterations) and measures it per op, body has to perform iterations ops
+	class Microbench
+	{
+	private:
+		MicrobenchSettings Settings;
+
+		std::vector<MicrobenchResult> Results;
+
+		static double MeasureNs(const std::function<void(uint64_t)>& body, const uint64_t iterations)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			body(iterations);
+			auto end = std::chrono::steady_clock::now();
+
+			return std::chrono::duration<double, std::nano>(end - begin).count();
+		}
+	public:
+		inline explicit Microbench(const MicrobenchSettings& settings) : Settings(settings)
+		{
+		}
+
+		inline bool IsSelected(const std::string& name) const
+		{
+			return Settings.Filter.empty() || name.find(Settings.Filter) != std::string::npos;
+		}
+
+		void Run(const std::string& name, const uint64_t itemsPerOp, const std::function<void(uint64_t)>& body)
+		{
+			if (!IsSelected(name))
+				return;
+
+			//The first call also warms caches and lazy allocations up
+			uint64_t iterations = 1;
+			while (MeasureNs(body, iterations) < Settings.MinRepetitionMs * 1e6 && iterations < (1ull << 40))
+				iterations *= 2;
+
+			std::vector<double> samples;
+			uint64_t allocations = 0;
+
+			for (uint32_t i = 0; i < Settings.Repetitions; ++i)
+			{
+				uint64_t allocationsBegin = debug::GlobalAllocationTracker.GetTotal().Count;
+				double ns = MeasureNs(body, iterations);
+				allocations += debug::GlobalAllocationTracker.GetTotal().Count - allocationsBegin;
+
+				samples.push_back(ns / iterations);
+			}
+
+			std::sort(samples.begin(), samples.end());
+
+			double mean = 0.0;
+			for (auto s : samples)
+				mean += s;
+			mean /= samples.size();
+
+			double variance = 0.0;
+			for (auto s : samples)
+				variance += (s - mean) * (s - mean);
+			variance /= samples.size();
+
+			MicrobenchResult r;
+			r.Name = name;
+			r.Iterations = iterations;
+			r.MedianNs = samples[samples.size() / 2];
+			r.MinNs = samples.front();
+			r.StdDevNs = std::sqrt(variance);
+			r.AllocationsPerOp = static_cast<double>(allocations) / (iterations * Settings.Repetitions);
+			r.ItemsPerSecond = itemsPerOp * 1e9 / r.MedianNs;
+
+			printf("%-40s %14.1f ns/op %10.1f min %8.1f sd %10.2f allocs/op %14.0f items/s\n",
+				   r.Name.c_str(), r.MedianNs, r.MinNs, r.StdDevNs, r.AllocationsPerOp, r.ItemsPerSecond);
+
+			Results.push_back(r);
+		}
+
+		bool WriteJson(const std::string& filepath) const
+		{
+			std::ofstream out(filepath, std::ios::trunc);
+			out << std::fixed << std::setprecision(3) << "[";
+
+			for (size_t i = 0; i < Results.size(); ++i)
+			{
+				const auto& r = Results[i];
+
+				if (i > 0)
+					out << ",";
+
+				out << "{\"name\":\"" << r.Name << "\",\"iterations\":" << r.Iterations
+					<< ",\"ns_per_op\":" << r.MedianNs << ",\"min_ns_per_op\":" << r.MinNs
+					<< ",\"stddev_ns\":" << r.StdDevNs << ",\"allocs_per_op\":" << r.AllocationsPerOp
+					<< ",\"items_per_second\":" << r.ItemsPerSecond << "}";
+			}
+
+			out << "]";
+
+			return out.good();
+		}
+	};
+
+	//Formats like the engine printer but drops the output, so only the logger itself is measured
+	class NullPrinter : public app::StandardPrinter
+	{
+	public:
+		inline void OnReceive(const debug::LogSeverity, const std::string&) override
+		{
+		}
+	};
+
+	//Triangulated grid with every attribute ConvertMesh reads
+	std::unique_ptr<aiMesh> CreateGridMesh(const uint32_t size)
+	{
+		auto mesh = std::make_unique<aiMesh>();
+
+		uint32_t verticesCount = (size + 1) * (size + 1);
+
+		mesh->mNumVertices = verticesCount;
+		mesh->mVertices = new aiVector3D[verticesCount];
+		mesh->mNormals = new aiVector3D[verticesCount];
+		mesh->mTangents = new aiVector3D[verticesCount];
+		mesh->mBitangents = new aiVector3D[verticesCount];
+		mesh->mTextureCoords[0] = new aiVector3D[verticesCount];
+		mesh->mNumUVComponents[0] = 2;
+
+		for (uint32_t y = 0; y <= size; ++y)
+		{
+			for (uint32_t x = 0; x <= size; ++x)
+			{
+				uint32_t i = y * (size + 1) + x;
+				float u = static_cast<float>(x) / size;
+				float v = static_cast<float>(y) / size;
+
+				mesh->mVertices[i] = aiVector3D(u, 0.0f, v);
+				mesh->mNormals[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+				mesh->mTangents[i] = aiVector3D(1.0f, 0.0f, 0.0f);
+				mesh->mBitangents[i] = aiVector3D(0.0f, 0.0f, 1.0f);
+				mesh->mTextureCoords[0][i] = aiVector3D(u, v, 0.0f);
+			}
+		}
+
+		mesh->mNumFaces = size * size * 2;
+		mesh->mFaces = new aiFace[mesh->mNumFaces];
+
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				uint32_t i = y * (size + 1) + x;
+				uint32_t quad = y * size + x;
+
+				uint32_t corners[2][3] = { { i, i + size + 1, i + 1 }, { i + 1, i + size + 1, i + size + 2 } };
+
+				for (uint32_t t = 0; t < 2; ++t)
+				{
+					auto& face = mesh->mFaces[quad * 2 + t];
+					face.mNumIndices = 3;
+					face.mIndices = new unsigned int[3];
+					std::copy(corners[t], corners[t] + 3, face.mIndices);
+				}
+			}
+		}
+
+		return mesh;
+	}
+
+	scene::GeneratorSettings CreateHierarchySettings(const uint32_t meshesCount, const uint32_t depth, const uint32_t branching,
+													 const std::shared_ptr<render::BaseMaterial>& material)
+	{
+		scene::GeneratorSettings settings;
+		settings.Seed = 1;
+		settings.MeshesCount = meshesCount;
+		settings.Depth = depth;
+		settings.Branching = branching;
+		settings.Meshes = { std::string("models/cube.obj"), std::string("models/DamagedHelmet.blend") };
+		settings.Materials = { material };
+		settings.PointLightsCount = 0;
+
+		return settings;
+	}
+}
+
+//VRenderMicrobench [--filter NAME] [--repetitions N] [--min-time MS] [--json FILE]
+//Cpu only hot paths, no window or vulkan device is created
+int main(int argc, char** argv)
+{
+	bench::MicrobenchSettings settings;
+	std::string jsonPath;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--filter" && i + 1 < argc)
+			settings.Filter = argv[++i];
+		else if (arg == "--repetitions" && i + 1 < argc)
+			settings.Repetitions = std::max(1ul, std::stoul(argv[++i]));
+		else if (arg == "--min-time" && i + 1 < argc)
+			settings.MinRepetitionMs = std::stof(argv[++i]);
+		else if (arg == "--json" && i + 1 < argc)
+			jsonPath = std::filesystem::absolute(argv[++i]).string();
+	}
+
+	debug::GlobalLoggger.SetPrinter<bench::NullPrinter>();
+
+	std::filesystem::current_path(WORKING_DIR);
+
+	bench::Microbench mb(settings);
+
+	auto material = std::make_shared<render::PbrMaterial>();
+
+	//Wide: every mesh under one parent, deep: a chain of 64 groups above them, mixed: the generator default shape
+	struct Shape
+	{
+		const char* Name;
+		uint32_t Depth;
+		uint32_t Branching;
+	};
+
+	const Shape shapes[] = { { "wide", 0, 1 }, { "deep", 64, 1 }, { "mixed", 4, 4 } };
+
+	for (const auto& shape : shapes)
+	{
+		for (uint32_t meshesCount : { 1000u, 100000u })
+		{
+			auto suffix = std::string("/") + shape.Name + "/" + std::to_string(meshesCount);
+
+			if (!mb.IsSelected("GetNodesWithChannel" + suffix) && !mb.IsSelected("ComponentRegistry::Register" + suffix)
+				&& !mb.IsSelected("UpdateTransforms/dirty" + suffix) && !mb.IsSelected("UpdateTransforms/static" + suffix)
+				&& !mb.IsSelected("WorldMatrix" + suffix) && !mb.IsSelected("ComposeTransforms" + suffix))
+				continue;
+
+			scene::GeneratedScene generated;
+			if (!generated.Generate(bench::CreateHierarchySettings(meshesCount, shape.Depth, shape.Branching, material)))
+				continue;
+
+			auto& root = generated.GetRoot();
+
+			mb.Run("GetNodesWithChannel" + suffix, meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					auto meshes = root.GetNodesWithChannel<scene::MeshRenderable>();
+					bench::DoNotOptimize(meshes.data());
+				}
+			});
+
+			//Registering walks the subtree once, afterwards gathering is a reference to the dense array
+			mb.Run("ComponentRegistry::Register" + suffix, meshesCount, [&](uint64_t iterations)
+			{
+				scene::ComponentRegistry registry;
+
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					root.SetRegistry(&registry);
+					root.SetRegistry(nullptr);
+				}
+			});
+
+			//Moving the root dirties every node, the worst case of the per frame pass
+			mb.Run("UpdateTransforms/dirty" + suffix, meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					root.SetPosition(root.GetPosition());
+					root.UpdateTransforms();
+				}
+			});
+
+			mb.Run("UpdateTransforms/static" + suffix, meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+					root.UpdateTransforms();
+			});
+
+			auto meshes = root.GetNodesWithChannel<scene::MeshRenderable>();
+
+			//Same matrices UpdateMeshUBO reads, without the uniform buffer writes
+			mb.Run("WorldMatrix" + suffix, meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					for (auto m : meshes)
+						bench::DoNotOptimize(m->GetWorldMatrix());
+				}
+			});
+
+			//Batched path of UpdateMeshUBO, written to plain memory instead of the mapped object buffer
+			std::vector<glm::mat4> transforms(meshes.size());
+			scene::TransformBatch batch;
+
+			mb.Run("ComposeTransforms" + suffix, meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					batch.Clear();
+
+					for (size_t j = 0; j < meshes.size(); ++j)
+					{
+						auto m = meshes[j];
+						batch.Push(m->GetWorldPosition(), m->GetWorldScale(), m->GetWorldRotation(),
+								   reinterpret_cast<uint8_t*>(&transforms[j]));
+					}
+
+					scene::ComposeTransforms(batch);
+					bench::DoNotOptimize(transforms.data());
+				}
+			});
+		}
+	}
+
+	if (mb.IsSelected("Bvh") || mb.IsSelected("Frustum"))
+	{
+		const uint32_t meshesCount = 100000;
+
+		utils::JobSystem jobs;
+		jobs.Setup();
+
+		scene::GeneratedScene generated;
+		if (generated.Generate(bench::CreateHierarchySettings(meshesCount, 4, 4, material)))
+		{
+			auto& root = generated.GetRoot();
+
+			scene::ComponentRegistry registry;
+			root.SetRegistry(&registry);
+			root.UpdateTransforms();
+
+			scene::Bvh bvh;
+
+			mb.Run("Bvh::Build/" + std::to_string(meshesCount), meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+					bvh.Build(registry.GetMeshes(), jobs);
+			});
+
+			//Moving the root moves every mesh. Includes UpdateTransforms/dirty/mixed of the same size
+			mb.Run("Bvh::Refit/" + std::to_string(meshesCount), meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					root.SetPosition(root.GetPosition() + glm::vec3(0.01f));
+					root.UpdateTransforms();
+
+					bvh.Refit(jobs);
+				}
+			});
+
+			auto toClip = glm::perspective(glm::radians(45.0f), 1.77f, 0.1f, 1000.0f);
+			auto toCamera = glm::lookAt(glm::vec3(0.0f, 0.0f, -60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			auto frustum = scene::Frustum::FromMatrix(toClip * toCamera);
+
+			std::vector<uint32_t> result;
+			result.reserve(meshesCount);
+
+			mb.Run("Bvh::QueryFrustum/" + std::to_string(meshesCount), 1, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					bvh.QueryFrustum(frustum, result);
+					bench::DoNotOptimize(result.data());
+				}
+			});
+
+			//Same test against every mesh, what culling costs without the hierarchy
+			mb.Run("Frustum/brute_force/" + std::to_string(meshesCount), 1, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					result.clear();
+
+					for (uint32_t j = 0; j < bvh.GetSlotsCount(); ++j)
+					{
+						if (frustum.Overlaps(bvh.GetWorldBounds(j)))
+							result.push_back(j);
+					}
+
+					bench::DoNotOptimize(result.data());
+				}
+			});
+
+			mb.Run("Bvh::QuerySphere/" + std::to_string(meshesCount), 1, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					bvh.QuerySphere(glm::vec3(10.0f, 0.0f, 0.0f), 5.0f, result);
+					bench::DoNotOptimize(result.data());
+				}
+			});
+
+			//Rays from a sphere around the scene towards points inside it
+			std::mt19937_64 random(1);
+			auto randomFloat = [&]() { return static_cast<float>((random() >> 11) * 0x1.0p-53) * 2.0f - 1.0f; };
+
+			std::vector<std::pair<glm::vec3, glm::vec3>> rays(256);
+			for (auto& r : rays)
+			{
+				r.first = glm::normalize(glm::vec3(randomFloat(), randomFloat(), randomFloat())) * 100.0f;
+				r.second = glm::normalize(glm::vec3(randomFloat(), randomFloat(), randomFloat()) * 50.0f - r.first);
+			}
+
+			mb.Run("Bvh::Raycast/" + std::to_string(meshesCount), rays.size(), [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					for (const auto& r : rays)
+						bench::DoNotOptimize(bvh.Raycast(r.first, r.second));
+				}
+			});
+
+			const uint32_t churnCount = 1000;
+			const auto& meshes = registry.GetMeshes();
+
+			//Despawn and respawn of a thousand meshes, the bvh side of spawning at runtime without a rebuild
+			mb.Run("Bvh::Insert+Remove/" + std::to_string(meshesCount), churnCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					for (uint32_t j = 0; j < churnCount; ++j)
+						bvh.Remove(j);
+
+					for (uint32_t j = 0; j < churnCount; ++j)
+						bvh.Insert(j, meshes[j]);
+				}
+			});
+
+			root.SetRegistry(nullptr);
+		}
+
+		jobs.Cleanup();
+	}
+
+	if (mb.IsSelected("SceneFile") || mb.IsSelected("LoadedScene"))
+	{
+		const uint32_t meshesCount = 1000000;
+
+		auto path = (std::filesystem::temp_directory_path() / "vrender_microbench.vrscene").string();
+
+		scene::MaterialLibrary materials;
+		materials.Add("default", material);
+
+		//Written once and dropped, so only the loaded copy is in memory while it's measured
+		bool written;
+		{
+			scene::GeneratedScene generated;
+			written = generated.Generate(bench::CreateHierarchySettings(meshesCount, 4, 8, material))
+					  && scene::WriteSceneFile(path, generated.GetRoot(), materials);
+		}
+
+		if (written)
+		{
+			//Mapping and header checks only, constant in the scene size
+			mb.Run("SceneFile::Open", 1, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					scene::SceneFile file;
+					bench::DoNotOptimize(file.Open(path));
+				}
+			});
+
+			scene::LoadedScene loaded;
+
+			//File stays in the page cache after the write, so this is the instantiation without disk reads
+			mb.Run("LoadedScene::Load/" + std::to_string(meshesCount), meshesCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+					bench::DoNotOptimize(loaded.Load(path, materials));
+			});
+		}
+
+		std::filesystem::remove(path);
+	}
+
+	if (mb.IsSelected("NodePool"))
+	{
+		const uint32_t nodesCount = 100000;
+
+		scene::NodePool<scene::MeshRenderable> pool;
+		std::vector<scene::NodeHandle<scene::MeshRenderable>> handles(nodesCount);
+
+		//Freed slots are reused, so after the first iteration no chunks are allocated
+		mb.Run("NodePool::Create+Destroy", nodesCount, [&](uint64_t iterations)
+		{
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				for (auto& h : handles)
+					h = pool.Create();
+
+				for (auto h : handles)
+					pool.Destroy(h);
+			}
+		});
+
+		for (auto& h : handles)
+			h = pool.Create();
+
+		//Index and generation check, replaces the child map lookups
+		mb.Run("NodePool::Get", nodesCount, [&](uint64_t iterations)
+		{
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				for (auto h : handles)
+					bench::DoNotOptimize(pool.Get(h));
+			}
+		});
+	}
+
+	for (uint32_t size : { 16u, 256u })
+	{
+		auto grid = bench::CreateGridMesh(size);
+		uint64_t vertices = grid->mNumFaces * 3ull;
+
+		mb.Run("ConvertMesh/" + std::to_string(vertices), vertices, [&](uint64_t iterations)
+		{
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				auto data = manager::ConvertMesh(grid.get());
+				bench::DoNotOptimize(data.Positions.data());
+			}
+		});
+	}
+
+	if (mb.IsSelected("AssetManager"))
+	{
+		manager::AssetManager assets;
+		assets.LoadAssetsFromFolder("res/assets"_ep);
+
+		utils::HashString meshPath = std::string("models/DamagedHelmet.blend"_ep);
+		utils::HashString imagePath = std::string("textures/helmet/Default_albedo.jpg"_ep);
+
+		if (assets.IsMeshLoaded(meshPath))
+		{
+			uint64_t vertices = assets.GetMeshData(meshPath).Positions.size();
+
+			mb.Run("AssetManager::GetMeshData", vertices, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					auto data = assets.GetMeshData(meshPath);
+					bench::DoNotOptimize(data.Positions.data());
+				}
+			});
+		}
+
+		if (assets.IsImageLoaded(imagePath))
+		{
+			uint64_t pixels = assets.GetImageData(imagePath).PixelsData.size() / 4;
+
+			mb.Run("AssetManager::GetImageData", pixels, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+				{
+					auto data = assets.GetImageData(imagePath);
+					bench::DoNotOptimize(data.PixelsData.data());
+				}
+			});
+		}
+	}
+
+	const std::string path = "textures/helmet/Default_metalRoughness.jpg";
+
+	mb.Run("HashString/construct", 1, [&](uint64_t iterations)
+	{
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			utils::HashString hs(path);
+			bench::DoNotOptimize(hs.GetHash());
+		}
+	});
+
+	mb.Run("HashString/assign", 1, [&](uint64_t iterations)
+	{
+		utils::HashString hs;
+
+		for (uint64_t i = 0; i < iterations; ++i)
+		{
+			hs = path;
+			bench::DoNotOptimize(hs.GetHash());
+		}
+	});
+
+	//Called directly since the log macros are compiled out in release builds.
+	//Repeated messages are dropped by the spam check after the first one
+	mb.Run("Logger::Send/spam_filtered", 1, [&](uint64_t iterations)
+	{
+		for (uint64_t i = 0; i < iterations; ++i)
+			debug::GlobalLoggger.Send(debug::LogSeverity::Warning, "Couldn't find texture %s", path.c_str());
+	});
+
+	debug::GlobalLoggger.SetSpamSettings(0);
+
+	mb.Run("Logger::Send/formatted", 1, [&](uint64_t iterations)
+	{
+		for (uint64_t i = 0; i < iterations; ++i)
+			debug::GlobalLoggger.Send(debug::LogSeverity::Warning, "Frame %d took %fms", static_cast<int>(i), 16.6f);
+	});
+
+	if (mb.IsSelected("JobSystem"))
+	{
+		utils::JobSystem jobs;
+		jobs.Setup();
+
+		//One job per item, measures scheduling, stealing and the join rather than the work
+		for (uint32_t jobsCount : { 64u, 4096u })
+		{
+			std::vector<uint32_t> values(jobsCount);
+
+			auto touch = [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+					values[i]++;
+			};
+
+			mb.Run("JobSystem::ParallelFor/" + std::to_string(jobsCount), jobsCount, [&](uint64_t iterations)
+			{
+				for (uint64_t i = 0; i < iterations; ++i)
+					jobs.ParallelFor(jobsCount, 1, touch);
+
+				bench::DoNotOptimize(values.data());
+			});
+		}
+
+		jobs.Cleanup();
+	}
+
+	if (!jsonPath.empty() && !mb.WriteJson(jsonPath))
+		return 1;
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "alloc_tracker.h"
+
+#ifdef VRENDER_TRACK_ALLOCATIONS
+#include "debug.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	inline void* AllocateTracked(const size_t size)
+	{
+		debug::GlobalAllocationTracker.RecordAllocation(size);
+
+		if (void* ptr = std::malloc(size ? size : 1))
+			return ptr;
+
+		throw std::bad_alloc();
+	}
+
+	inline void* AllocateTrackedAligned(const size_t size, const std::align_val_t alignment)
+	{
+		debug::GlobalAllocationTracker.RecordAllocation(size);
+
+		auto align = static_cast<size_t>(alignment);
+
+#ifdef _MSC_VER
+		void* ptr = _aligned_malloc(size ? size : 1, align);
+#else
+		//Size has to be a multiple of the alignment
+		void* ptr = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+
+		if (ptr)
+			return ptr;
+
+		throw std::bad_alloc();
+	}
+
+	inline void FreeTrackedAligned(void* ptr)
+	{
+#ifdef _MSC_VER
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+//Array and nothrow versions forward to these
+void* operator new(size_t size)
+{
+	return AllocateTracked(size);
+}
+
+void* operator new[](size_t size)
+{
+	return AllocateTracked(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return AllocateTrackedAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return AllocateTrackedAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	FreeTrackedAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	FreeTrackedAligned(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+	FreeTrackedAligned(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+	FreeTrackedAligned(ptr);
+}
+
+namespace debug
+{
+	void AllocationTracker::RecordZone(const char* name, const AllocationStats& stats)
+	{
+		size_t start = (reinterpret_cast<uintptr_t>(name) >> 3) % MaxAllocationZones;
+
+		for (size_t i = 0; i < MaxAllocationZones; ++i)
+		{
+			auto& slot = Zones[(start + i) % MaxAllocationZones];
+
+			const char* current = slot.Name.load(std::memory_order_acquire);
+			if (!current && slot.Name.compare_exchange_strong(current, name, std::memory_order_acq_rel))
+				current = name;
+
+			if (current != name)
+				continue;
+
+			slot.FrameCount.fetch_add(stats.Count, std::memory_order_relaxed);
+			slot.FrameBytes.fetch_add(stats.Bytes, std::memory_order_relaxed);
+			slot.TotalCount.fetch_add(stats.Count, std::memory_order_relaxed);
+			slot.TotalBytes.fetch_add(stats.Bytes, std::memory_order_relaxed);
+
+			return;
+		}
+	}
+
+	void AllocationTracker::EndFrame()
+	{
+		auto total = GetTotal();
+
+		LastFrame = { total.Count - FrameBegin.Count, total.Bytes - FrameBegin.Bytes };
+		FrameBegin = total;
+
+		++FramesCount;
+
+		if (AssertSteadyState && FramesCount > WarmupFrames && LastFrame.Count > 0)
+			FailSteadyState();
+
+		for (auto& z : Zones)
+		{
+			z.FrameCount.store(0, std::memory_order_relaxed);
+			z.FrameBytes.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	std::vector<ZoneAllocationStats> AllocationTracker::GetTopZones(const size_t count, const bool lastFrame) const
+	{
+		std::vector<ZoneAllocationStats> zones;
+
+		for (const auto& z : Zones)
+		{
+			const char* name = z.Name.load(std::memory_order_acquire);
+			if (!name)
+				continue;
+
+			ZoneAllocationStats s;
+			s.Name = name;
+			s.Frame = { z.FrameCount.load(std::memory_order_relaxed), z.FrameBytes.load(std::memory_order_relaxed) };
+			s.Total = { z.TotalCount.load(std::memory_order_relaxed), z.TotalBytes.load(std::memory_order_relaxed) };
+
+			if ((lastFrame ? s.Frame.Count : s.Total.Count) > 0)
+				zones.push_back(s);
+		}
+
+		std::sort(zones.begin(), zones.end(),
+			[&](const ZoneAllocationStats& a, const ZoneAllocationStats& b)
+			{
+				return lastFrame ? a.Frame.Count > b.Frame.Count : a.Total.Count > b.Total.Count;
+			});
+
+		if (zones.size() > count)
+			zones.resize(count);
+
+		return zones;
+	}
+
+	void AllocationTracker::LogReport(const size_t count) const
+	{
+		auto total = GetTotal();
+		uint64_t frames = std::max<uint64_t>(FramesCount, 1);
+
+		LOGC("Allocations: %llu (%llu bytes) over %llu frames, last frame %llu (%llu bytes)",
+			 (unsigned long long)total.Count, (unsigned long long)total.Bytes, (unsigned long long)FramesCount,
+			 (unsigned long long)LastFrame.Count, (unsigned long long)LastFrame.Bytes);
+
+		for (const auto& z : GetTopZones(count, false))
+		{
+			LOGC("  %s: %.1f allocations/frame, %.1f bytes/frame",
+				 z.Name, (double)z.Total.Count / frames, (double)z.Total.Bytes / frames);
+		}
+	}
+
+	void AllocationTracker::FailSteadyState()
+	{
+		//Abort even in release, the mode is opted into explicitly
+		LOGE("Frame %llu allocated %llu times (%llu bytes) after the warmup!",
+			 (unsigned long long)FramesCount, (unsigned long long)LastFrame.Count, (unsigned long long)LastFrame.Bytes);
+
+		for (const auto& z : GetTopZones(10, true))
+			LOGE("  %s: %llu allocations, %llu bytes", z.Name, (unsigned long long)z.Frame.Count, (unsigned long long)z.Frame.Bytes);
+
+		fprintf(stderr, "Steady state frame %llu allocated %llu times\n",
+				(unsigned long long)FramesCount, (unsigned long long)LastFrame.Count);
+
+		std::abort();
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#ifdef VRENDER_TRACK_ALLOCATIONS
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace debug
+{
+	//Distinct zone names that get their own counters, allocations of further zones are counted as unzoned
+	constexpr uint32_t MaxAllocationZones = 1024;
+
+	struct AllocationStats
+	{
+		uint64_t Count = 0;
+		uint64_t Bytes = 0;
+	};
+
+	struct ZoneAllocationStats
+	{
+		const char* Name;
+
+		//Allocations made directly in the zone, not in its child zones
+		AllocationStats Frame;
+		AllocationStats Total;
+	};
+
+	//Counters of the calling thread, only ever touched by it so the hooks stay cheap
+	struct ThreadAllocations
+	{
+		uint64_t Count = 0;
+		uint64_t Bytes = 0;
+	};
+
+	inline thread_local ThreadAllocations CurrentThreadAllocations;
+
+	//Hooked into the global operator new, counts every heap allocation of the process.
+	//Nothing in here may allocate itself
+	class AllocationTracker
+	{
+	private:
+		struct ZoneSlot
+		{
+			std::atomic<const char*> Name = nullptr;
+
+			std::atomic<uint64_t> FrameCount = 0;
+			std::atomic<uint64_t> FrameBytes = 0;
+			std::atomic<uint64_t> TotalCount = 0;
+			std::atomic<uint64_t> TotalBytes = 0;
+		};
+
+		std::atomic<uint64_t> Count = 0;
+		std::atomic<uint64_t> Bytes = 0;
+
+		ZoneSlot Zones[MaxAllocationZones];
+
+		AllocationStats FrameBegin;
+		AllocationStats LastFrame;
+
+		uint64_t FramesCount = 0;
+
+		void FailSteadyState();
+	public:
+		//Aborts when a frame past the warmup allocates, e.g. to catch regressions in the frame loop
+		bool AssertSteadyState = false;
+		uint32_t WarmupFrames = 120;
+
+		inline void RecordAllocation(const size_t size)
+		{
+			Count.fetch_add(1, std::memory_order_relaxed);
+			Bytes.fetch_add(size, std::memory_order_relaxed);
+
+			CurrentThreadAllocations.Count++;
+			CurrentThreadAllocations.Bytes += size;
+		}
+
+		inline AllocationStats GetTotal() const
+		{
+			return { Count.load(std::memory_order_relaxed), Bytes.load(std::memory_order_relaxed) };
+		}
+
+		inline AllocationStats GetLastFrame() const
+		{
+			return LastFrame;
+		}
+
+		inline uint64_t GetFramesCount() const
+		{
+			return FramesCount;
+		}
+
+		//Zone names are string literals, so pointers identify them
+		void RecordZone(const char* name, const AllocationStats& stats);
+
+		//Closes the current frame, called from the main thread after the frame zones ended
+		void EndFrame();
+
+		//Sorted by allocations count, descending
+		std::vector<ZoneAllocationStats> GetTopZones(const size_t count, const bool lastFrame) const;
+
+		void LogReport(const size_t count) const;
+	};
+
+	inline AllocationTracker GlobalAllocationTracker;
+}
+
+#define ALLOC_END_FRAME() debug::GlobalAllocationTracker.EndFrame()
+#define ALLOC_LOG_REPORT(count) debug::GlobalAllocationTracker.LogReport(count)
+#else
+#define ALLOC_END_FRAME()
+#define ALLOC_LOG_REPORT(count)
+#endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 #include "logger.h"
+#include "profiler.h"
+#include "alloc_tracker.h"
 #include "utils/timer.h"
 
 #define FORCE_SEMICOLON_BLOCK(x)\
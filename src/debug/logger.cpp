@@ -32,11 +32,13 @@ namespace debug
 		auto formatedMessage = Printer->FormatMessage(format, args);
 		va_end(args);
 
+		std::lock_guard<std::mutex> lock(Mutex);
+
 		if (EnableSpamCheck)
 		{
 			uint32_t hash = std::hash<std::string>{}(formatedMessage);
 
-			auto& findRes = MessagesLookup.find(hash);
+			auto findRes = MessagesLookup.find(hash);
 			if (findRes == MessagesLookup.end())
 				MessagesLookup[hash] = 0;
 			else
@@ -1,6 +1,9 @@
 #pragma once
 #include <cstdlib>
+#include <memory>
+#include <vector>
 #include <fstream>
+#include <mutex>
 #include <type_traits>
 #include <cstdarg>
 #include <unordered_map>
@@ -38,6 +41,9 @@ namespace debug
 
 		std::unique_ptr<BasePrinter> Printer;
 
+		//Render thread and job workers log too
+		std::mutex Mutex;
+
 		std::string GenerateInfoString(const LogSeverity severity);
 	public:
 		inline bool Setup(const char* filepath)
@@ -56,6 +62,8 @@ namespace debug
 			if (!EnableSpamCheck)
 				return;
 
+			std::lock_guard<std::mutex> lock(Mutex);
+
 			std::vector<uint32_t> eraseQueue;
 
 			for (auto&[id, it] : MessagesLookup)
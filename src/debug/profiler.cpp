@@ -0,0 +1,43 @@
+#include "profiler.h"
+
+#ifdef VRENDER_PROFILE
+#include "utils/trace.h"
+
+namespace debug
+{
+	ThreadZones& Profiler::RegisterThread()
+	{
+		std::lock_guard<std::mutex> lock(ThreadsMutex);
+
+		auto zones = std::make_unique<ThreadZones>();
+		zones->Events = std::make_unique<ZoneEvent[]>(MaxThreadZones);
+		zones->Thread = Threads.size();
+
+		Threads.push_back(std::move(zones));
+
+		return *Threads.back();
+	}
+
+	bool Profiler::WriteTrace(const std::string& filepath)
+	{
+		std::vector<utils::TraceEvent> events;
+
+		{
+			std::lock_guard<std::mutex> lock(ThreadsMutex);
+
+			for (const auto& t : Threads)
+			{
+				uint32_t count = t->Count.load(std::memory_order_acquire);
+
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					const auto& e = t->Events[i];
+					events.push_back({ e.Name, e.Begin, e.End, 0, t->Thread });
+				}
+			}
+		}
+
+		return utils::WriteChromeTrace(filepath, events);
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#ifdef VRENDER_PROFILE
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "alloc_tracker.h"
+
+namespace debug
+{
+	//Zones past the capacity of a thread are dropped
+	constexpr uint32_t MaxThreadZones = 1 << 16;
+
+	struct ZoneEvent
+	{
+		const char* Name;
+		uint64_t Begin;
+		uint64_t End;
+	};
+
+	//Only the owning thread writes, the count is published after the event so readers never see a partial one
+	struct ThreadZones
+	{
+		std::unique_ptr<ZoneEvent[]> Events;
+		std::atomic<uint32_t> Count = 0;
+
+		uint32_t Thread;
+	};
+
+	inline uint64_t GetProfilerTime()
+	{
+		auto time = std::chrono::steady_clock::now().time_since_epoch();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+	}
+
+	class Profiler
+	{
+	private:
+		//Buffers live until exit, so zones of finished threads can still be exported
+		std::vector<std::unique_ptr<ThreadZones>> Threads;
+		std::mutex ThreadsMutex;
+
+		ThreadZones& RegisterThread();
+	public:
+		inline void Record(const char* name, const uint64_t begin, const uint64_t end)
+		{
+			thread_local ThreadZones* zones = &RegisterThread();
+
+			uint32_t count = zones->Count.load(std::memory_order_relaxed);
+			if (count >= MaxThreadZones)
+				return;
+
+			zones->Events[count] = { name, begin, end };
+			zones->Count.store(count + 1, std::memory_order_release);
+		}
+
+		//Safe while other threads keep recording, their newest zones may be missing
+		bool WriteTrace(const std::string& filepath);
+	};
+
+	inline Profiler GlobalProfiler;
+
+#ifdef VRENDER_TRACK_ALLOCATIONS
+	class ProfileZone;
+
+	inline thread_local ProfileZone* CurrentProfileZone = nullptr;
+#endif
+
+	class ProfileZone
+	{
+	private:
+		const char* Name;
+		uint64_t Begin;
+
+#ifdef VRENDER_TRACK_ALLOCATIONS
+		//Allocations are attributed to the innermost zone, children report theirs to the parent
+		ProfileZone* Parent;
+		ThreadAllocations AllocationsBegin;
+		ThreadAllocations ChildAllocations;
+#endif
+	public:
+		inline explicit ProfileZone(const char* name) : Name(name), Begin(GetProfilerTime())
+		{
+#ifdef VRENDER_TRACK_ALLOCATIONS
+			Parent = CurrentProfileZone;
+			CurrentProfileZone = this;
+			AllocationsBegin = CurrentThreadAllocations;
+#endif
+		}
+
+		inline ~ProfileZone()
+		{
+#ifdef VRENDER_TRACK_ALLOCATIONS
+			//Measured before recording, the first record of a thread allocates its buffer
+			uint64_t count = CurrentThreadAllocations.Count - AllocationsBegin.Count;
+			uint64_t bytes = CurrentThreadAllocations.Bytes - AllocationsBegin.Bytes;
+
+			if (count > ChildAllocations.Count)
+				GlobalAllocationTracker.RecordZone(Name, { count - ChildAllocations.Count, bytes - ChildAllocations.Bytes });
+
+			if (Parent)
+			{
+				Parent->ChildAllocations.Count += count;
+				Parent->ChildAllocations.Bytes += bytes;
+			}
+
+			CurrentProfileZone = Parent;
+#endif
+
+			GlobalProfiler.Record(Name, Begin, GetProfilerTime());
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+	};
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+//Concatenation only compiles for string literals, so names never dangle
+#define PROFILE_ZONE(name) debug::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)("" name "")
+#define PROFILE_WRITE_TRACE(filepath) debug::GlobalProfiler.WriteTrace(filepath)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_WRITE_TRACE(filepath)
+#endif
\ No newline at end of file
@@ -8,14 +8,14 @@ namespace app
 	{
 		va_list listCopy;
 
+		//Measuring consumes the list, so it works on a copy
 		va_copy(listCopy, args);
-		size_t bufLength = vsnprintf(nullptr, 0, format, args);
+		int bufLength = vsnprintf(nullptr, 0, format, listCopy);
+		va_end(listCopy);
 
 		if (bufLength < 0)
 			return {};
 
-		va_end(listCopy);
-
 
 		std::vector<char> buf(bufLength + 1);
 		vsnprintf(&buf[0], bufLength + 1, format, args);
@@ -31,12 +31,13 @@ namespace app
 
 		LOGC("Device: %s", VulkanApp.DeviceProperties.deviceName);
 		LOGC("Vulkan version: %d.%d.%d\n", majorApi, minorApi, patchApi);
+		LOGC("Job workers: %d\n", Jobs.GetWorkersCount());
 
 		auto workingDir = std::filesystem::current_path().string();
 		LOGC("Working directory: %s\n", workingDir.c_str());
 	}
 
-	void Engine::StartupEngine()
+	bool Engine::StartupEngine()
 	{
 		//Set working path as a project build directory, TODO remove only if need to distribute binaries
 		std::filesystem::current_path(WORKING_DIR);
@@ -45,59 +46,182 @@ namespace app
 		if (!debug::GlobalLoggger.Setup("log.txt"))
 		{
 			printf("Couldn't initialize logger, probably problem with output file creation");
-			return;
+			return false;
 		}
 		debug::GlobalLoggger.SetPrinter<StandardPrinter>();
 		debug::GlobalLoggger.SetSpamSettings(2);
 
 
-		if (!vk::SetupVulkanApp(WindowWidth, WindowHeight, VulkanApp))
-			return;
+		if (!vk::SetupVulkanApp(WindowWidth, WindowHeight, VulkanApp, Headless))
+			return false;
 
-		if (!RenderManager.Setup(VulkanApp, AssetManager))
-			return;
+		//The render thread schedules its own jobs
+		Jobs.Setup(WorkerThreadsCount, UseRenderThread ? 1 : 0);
+
+		if (!RenderManager.Setup(VulkanApp, AssetManager, Jobs))
+			return false;
 
-		SceneManager.Setup(RenderManager);
+		SceneManager.Setup(RenderManager, Jobs);
+		WorldPartition.Setup(SceneManager, RenderManager);
 
-		InputManager.Setup(VulkanApp);
+		if (!Headless)
+			InputManager.Setup(VulkanApp);
 
 
 		PrintPlatformInfo();
+
+		if (UseRenderThread)
+			RenderThread = std::thread(&Engine::RenderLoop, this);
+
+		return true;
 	}
 
 	void Engine::CleanupEngine()
 	{
+		if (RenderThread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(RenderMutex);
+				StopRendering = true;
+			}
+
+			RenderCondition.notify_all();
+			RenderThread.join();
+		}
+
+		WorldPartition.Cleanup();
+
 		RenderManager.Cleanup();
 
+		Jobs.Cleanup();
+
 		vk::CleanVulkanApp(VulkanApp);
 
+		PROFILE_WRITE_TRACE("cpu_trace.json");
+		ALLOC_LOG_REPORT(20);
+
 		debug::GlobalLoggger.Cleanup();
 	}
 
-	void Engine::Run(const std::function<void()>& userMainLoop)
+	void Engine::RunFrame(const std::function<void()>& userMainLoop)
 	{
+		PROFILE_ZONE("Engine::Frame");
+
 		utils::Timer frameTimer;
+		frameTimer.Start();
 
-		vk::RunVulkanApp(VulkanApp,
-			[&]()
+
+		debug::GlobalLoggger.Update();
+
+
+		if (!Headless)
+			InputManager.Update();
+
+		{
+			PROFILE_ZONE("Engine::UserMainLoop");
+			userMainLoop();
+		}
+
+		WorldPartition.Update();
+
+		auto& snapshot = Snapshots.GetWriteBuffer();
+
+		SceneManager.Update(snapshot);
+
+		snapshot.Frame = ++SimulatedFrame;
+		snapshot.CaptureTime = utils::GetSteadyTime();
+
+		if (RenderThread.joinable())
+			Publish(snapshot);
+		else
+			RenderManager.Update(snapshot);
+
+
+		Fps = 1000.0f / frameTimer.GetElapsedTime();
+		DeltaTime = 1.0f / Fps;
+	}
+
+	void Engine::Publish(const render::FrameSnapshot& snapshot)
+	{
+		PROFILE_ZONE("Engine::Publish");
+
+		{
+			std::unique_lock<std::mutex> lock(RenderMutex);
+
+			//Previous snapshot has to be taken first, so none is replaced unseen and the simulation
+			//never runs more than a frame ahead
+			RenderCondition.wait(lock, [&]() { return ConsumedFrame + 1 >= snapshot.Frame; });
+
+			Snapshots.Publish();
+		}
+
+		RenderCondition.notify_all();
+	}
+
+	void Engine::RenderLoop()
+	{
+		Jobs.AttachThread();
+
+		while (true)
+		{
 			{
-				frameTimer.Start();
+				std::unique_lock<std::mutex> lock(RenderMutex);
+				RenderCondition.wait(lock, [&]() { return StopRendering || Snapshots.HasFresh(); });
 
+				if (!Snapshots.Consume())
+					break;
 
-				debug::GlobalLoggger.Update();
+				ConsumedFrame = Snapshots.GetReadBuffer().Frame;
+			}
 
+			RenderCondition.notify_all();
 
-				InputManager.Update();
+			{
+				PROFILE_ZONE("Engine::RenderFrame");
+				RenderManager.Update(Snapshots.GetReadBuffer());
+			}
 
-				userMainLoop();
+			{
+				std::lock_guard<std::mutex> lock(RenderMutex);
+				RenderedFrame = ConsumedFrame;
+			}
 
-				SceneManager.Update();
+			RenderCondition.notify_all();
+		}
+	}
 
-				RenderManager.Update();
+	void Engine::WaitForRenderer()
+	{
+		if (!RenderThread.joinable())
+			return;
 
+		std::unique_lock<std::mutex> lock(RenderMutex);
+		RenderCondition.wait(lock, [&]() { return RenderedFrame >= SimulatedFrame; });
+	}
 
-				Fps = 1000.0f / frameTimer.GetElapsedTime();
-				DeltaTime = 1.0f / Fps;
+	void Engine::Run(const std::function<void()>& userMainLoop)
+	{
+		vk::RunVulkanApp(VulkanApp,
+			[&]()
+			{
+				RunFrame(userMainLoop);
+				ALLOC_END_FRAME();
 			});
+
+		WaitForRenderer();
+	}
+
+	void Engine::RunFrames(const uint32_t count, const std::function<void()>& userMainLoop)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!Headless)
+				glfwPollEvents();
+
+			RunFrame(userMainLoop);
+			ALLOC_END_FRAME();
+		}
+
+		WaitForRenderer();
 	}
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <thread>
 
 #include "vrender.h"
 
@@ -9,8 +12,11 @@
 #include "managers/render_manager.h"
 #include "managers/asset_manager.h"
 #include "managers/input_manager.h"
+#include "managers/world_partition.h"
 
 #include "utils/timer.h"
+#include "utils/job_system.h"
+#include "utils/triple_buffer.h"
 
 namespace app
 {
@@ -35,25 +41,68 @@ namespace app
 	class API Engine
 	{
 	private:
+		//Simulation frames hand snapshots over without locks, the mutex only puts the waiting side to sleep
+		utils::TripleBuffer<render::FrameSnapshot> Snapshots;
+
+		std::thread RenderThread;
+		std::mutex RenderMutex;
+		std::condition_variable RenderCondition;
+
+		//Main thread only
+		uint64_t SimulatedFrame = 0;
+
+		//Guarded by the mutex
+		uint64_t ConsumedFrame = 0;
+		uint64_t RenderedFrame = 0;
+		bool StopRendering = false;
+
 		void PrintPlatformInfo();
+
+		void RunFrame(const std::function<void()>& userMainLoop);
+
+		void Publish(const render::FrameSnapshot& snapshot);
+		void RenderLoop();
+
+		//Returns once the render thread drew the latest snapshot
+		void WaitForRenderer();
 	public:
 		vk::VulkanApp VulkanApp;
 
+		utils::JobSystem Jobs;
+
 		manager::SceneManager SceneManager;
 		manager::RenderManager RenderManager;
 		manager::AssetManager AssetManager;
 		manager::InputManager InputManager;
 
+		//Streams cells around the active camera once any are added
+		manager::WorldPartition WorldPartition;
+
 		uint16_t WindowWidth = 1920;
 		uint16_t WindowHeight = 1080;
 
+		//Renders offscreen without a window or input, e.g. on machines without a display. Read in StartupEngine
+		bool Headless = false;
+
+		//Threads besides the main one running engine jobs, zero picks one per remaining hardware thread.
+		//Read in StartupEngine
+		uint32_t WorkerThreadsCount = 0;
+
+		//Draws snapshots on a separate thread while the next frame is simulated, at most one frame behind.
+		//Read in StartupEngine
+		bool UseRenderThread = true;
+
 		float DeltaTime = 0.0f;
 		float Fps = 0.0f;
 
-		void StartupEngine();
+		bool StartupEngine();
 
 		void CleanupEngine();
 
+		//Runs until the window is closed
 		void Run(const std::function<void()>& userMainLoop);
+
+		//Runs a fixed number of frames, the only way to drive headless engines. Returns once they are all rendered
+		void RunFrames(const uint32_t count, const std::function<void()>& userMainLoop);
 	};
 }
\ No newline at end of file
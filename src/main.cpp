@@ -4,7 +4,8 @@ int main()
 {
 	app::Engine engine;
                                                     
-	engine.StartupEngine();
+	if (!engine.StartupEngine())
+		return 1;
 
 	engine.AssetManager.LoadAssetsFromFolder("res/assets"_ep);
 
@@ -30,19 +31,20 @@ int main()
 	scene::Node rootNode;
 
 	scene::PointLight pl;
-	pl.Position = glm::vec3(0.0f, 0.0f, 10.0f);
+	pl.SetPosition(glm::vec3(0.0f, 0.0f, 10.0f));
 	pl.Color = glm::vec3(250.0f);
 
 	scene::MeshRenderable generalMesh;
 	generalMesh.Mesh = "models/DamagedHelmet.blend"_ep;
 	generalMesh.Material = material;
-	generalMesh.Rotation = { 0.0f, 1.0f, 0.0f, glm::pi<float>() };
+	generalMesh.SetRotation({ 0.0f, 1.0f, 0.0f, glm::pi<float>() });
 
 	scene::MeshRenderable cubemapMesh;
 	cubemapMesh.Mesh = "models/cube.obj"_ep;
 	cubemapMesh.Material = hdrMaterial;
 	cubemapMesh.Render.DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 	cubemapMesh.Render.FacesCullMode = VK_CULL_MODE_FRONT_BIT;
+	cubemapMesh.Render.FrustumCulled = false;
 
 	rootNode.AttachChild(&pl);
 	rootNode.AttachChild(&generalMesh);
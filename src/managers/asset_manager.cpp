@@ -10,9 +10,10 @@ namespace manager
 {
 	void AssetManager::LoadAssetsFromFolder(const std::string& path)
 	{
+		PROFILE_ZONE("AssetManager::LoadAssetsFromFolder");
+
 		auto wstrPath = std::filesystem::path(path).wstring();
 
-		auto relPath = std::filesystem::path::preferred_separator + wstrPath;
 		auto p = std::filesystem::current_path() / wstrPath;
 
 		auto strPath = std::filesystem::path(p).string();
@@ -88,6 +89,8 @@ namespace manager
 
 	bool AssetManager::TryToLoadAsMesh(const utils::HashString& filepath)
 	{
+		PROFILE_ZONE("AssetManager::TryToLoadAsMesh");
+
 		Assimp::Importer assimpImporter;
 
 		const auto scene = assimpImporter.ReadFile(filepath.GetString(), aiProcess_Triangulate | aiProcess_CalcTangentSpace);
@@ -120,6 +123,8 @@ namespace manager
 		info.TangentsRDO.EndPosition = MeshesData.Tangents.size();
 		info.BitangentsRDO.EndPosition = MeshesData.Bitangents.size();
 
+		info.Bounds = scene::Aabb::FromPoints(meshData.Positions);
+
 		MeshesOffsetLookup[filepath.GetHash()] = info;
 
 		assimpImporter.FreeScene();
@@ -129,6 +134,8 @@ namespace manager
 
 	bool AssetManager::TryToLoadAsImage(const utils::HashString& filepath)
 	{
+		PROFILE_ZONE("AssetManager::TryToLoadAsImage");
+
 		int texWidth, texHeight, texChannels;
 		stbi_set_flip_vertically_on_load(1);
 
@@ -5,6 +5,10 @@
 #include <optional>
 #include <filesystem>
 
+#include "scene/bounds.h"
+
+struct aiMesh;
+
 namespace utils
 {
 	class HashString
@@ -37,6 +41,11 @@ namespace utils
 			HashValue = std::hash<std::string>{}(str);
 		}
 
+		inline void operator = (const char* str)
+		{
+			*this = std::string(str);
+		}
+
 		inline bool operator == (const HashString& hs)
 		{
 			return (HashValue == hs.GetHash());
@@ -107,6 +116,9 @@ namespace manager
 
 		utils::RangeDataOffset TangentsRDO;
 		utils::RangeDataOffset BitangentsRDO;
+
+		//Model space, computed on load so registering a mesh doesn't read its positions
+		scene::Aabb Bounds;
 	};
 
 	struct ImageInfo
@@ -140,6 +152,9 @@ namespace manager
 		bool Hdr;
 	};
 
+	//Flattens the indexed mesh into per vertex attributes
+	MeshData ConvertMesh(const aiMesh* assimpMesh);
+
 	class AssetManager
 	{
 	private:
@@ -270,6 +285,21 @@ namespace manager
 			return {};
 		}
 
+		inline std::optional<scene::Aabb> GetMeshBounds(const utils::HashString& filepath)
+		{
+			for (const auto& pd : LoadedDirectories)
+			{
+				utils::HashString hs = (std::filesystem::path(pd)
+										/ std::filesystem::path(filepath.GetString())).string();
+
+				auto findRes = MeshesOffsetLookup.find(hs.GetHash());
+				if (findRes != MeshesOffsetLookup.end())
+					return findRes->second.Bounds;
+			}
+
+			return std::nullopt;
+		}
+
 		inline bool IsMeshLoaded(const utils::HashString& filepath)
 		{
 			for (const auto& pd : LoadedDirectories)
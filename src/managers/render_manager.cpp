@@ -47,18 +47,13 @@ namespace manager
 		vkDestroyPipelineLayout(app.Device, pass.Renderable.PipelineLayout, nullptr);
 		vkDestroyPipeline(app.Device, pass.Renderable.Pipeline, nullptr);
 
-		for (const auto& fbo : pass.Framebuffers)
-			vkDestroyFramebuffer(app.Device, fbo, nullptr);
-
-		pass.ColorTexture.Cleanup();
-		pass.DepthTexture.Cleanup();
-
-		vkDestroyRenderPass(app.Device, pass.PassHandler, nullptr);
+		vkDestroySampler(app.Device, pass.Sampler, nullptr);
 	}
 
-	vk::Texture TextureManager::GetOrCreate(const render::MaterialTexture& texture, const vk::DescriptorImageType type)
+	vk::Texture TextureManager::GetOrCreate(vk::UploadContext& uploads, const render::MaterialTexture& texture,
+											const vk::DescriptorImageType type)
 	{
-		auto& findRes = TexturesLookup.find(texture.Image.GetHash());
+		auto findRes = TexturesLookup.find(texture.Image.GetHash());
 		if (findRes == TexturesLookup.end())
 		{
 			vk::Texture t;
@@ -89,15 +84,14 @@ namespace manager
 				{
 					t.Setup(*App, 1, 1, imageInfo, render::CreateInfoMapTextureParams());
 
-					t.SetLayout(App->GraphicsQueue, App->CommandPoolGQ,
-								vk::layout::SetImageLayoutFromUndefinedToGraphicsShader);
+					t.Transition(uploads.GetGraphicsCommandBuffer(), vk::ImageUsage::SampledGraphics);
 				}
 				else if (type == vk::DescriptorImageType::Cubemap)
 				{
 					t.Setup(*App, 1, 1, imageInfo, render::CreateInfoMapTextureParams(), 1, 6);
 
-					t.SetLayout(App->ComputeQueue, App->CommandPoolCQ,
-								vk::layout::SetCubeImageLayoutFromComputeWriteToGraphicsShader);
+					//Stands in for maps written by compute and sampled in general layout
+					t.Transition(uploads.GetGraphicsCommandBuffer(), vk::ImageUsage::StorageWrite);
 				}
 			}
 			else
@@ -109,9 +103,8 @@ namespace manager
 
 
 				t.Setup(*App, image.Width, image.Height, imageInfo, texture.TextureParams);
-				t.Update(image.PixelsData.data(), 4 * (image.Hdr ? sizeof(float) : 1));
-				t.SetLayout(App->GraphicsQueue, App->CommandPoolGQ,
-							vk::layout::SetImageLayoutFromTransferToGraphicsShader);
+				t.Update(uploads, image.PixelsData.data(), 4 * (image.Hdr ? sizeof(float) : 1),
+						 VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_ACCESS_SHADER_READ_BIT);
 			}
 
 			TexturesLookup[texture.Image.GetHash()] = t;
@@ -122,6 +115,20 @@ namespace manager
 		return findRes->second;
 	}
 
+	void CleanupMeshResources(const vk::VulkanApp& app, const MeshResources& resources)
+	{
+		for (const auto& d : resources.Descriptors)
+			vk::CleanupDescriptor(app, d);
+
+		for (const auto& b : resources.Buffers)
+			b.Cleanup();
+
+		vkDestroyPipelineLayout(app.Device, resources.PipelineLayout, nullptr);
+		vkDestroyPipeline(app.Device, resources.Pipeline, nullptr);
+
+		resources.MaterialUBO.Cleanup();
+	}
+
 	void CleanupRenderablesInfos(const vk::VulkanApp& app, const MeshRenderablesInfos& infos)
 	{
 		for (const auto& descriptors : infos.Descriptors)
@@ -142,201 +149,134 @@ namespace manager
 		for (const auto& p : infos.GraphicsPipelines)
 			vkDestroyPipeline(app.Device, p, nullptr);
 
-		for (const auto& ubo : infos.MeshUBOs)
-			ubo.Cleanup();
-
 		for (const auto& ubo : infos.MaterialUBOs)
 			ubo.Cleanup();
 	}
 
 	bool RenderManager::SetupRenderPassases()
 	{
-		{
-			VkAttachmentDescription depthAttachment{};
-			depthAttachment.format = VulkanApp->DepthFormat;
-			depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-			depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-			VkAttachmentReference depthAttachmentRef{};
-			depthAttachmentRef.attachment = 1;
-			depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-			VkAttachmentDescription colorAttachment{};
-			colorAttachment.format = VulkanApp->SwapChainFormat;
-			colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-			colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-			VkAttachmentReference colorAttachmentRef{};
-			colorAttachmentRef.attachment = 0;
-			colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-			VkSubpassDescription subpass{};
-			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-			subpass.colorAttachmentCount = 1;
-			subpass.pColorAttachments = &colorAttachmentRef;
-			subpass.pDepthStencilAttachment = &depthAttachmentRef;
-			
-			VkSubpassDependency dependency{};
-			dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependency.dstSubpass = 0;
-			dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependency.srcAccessMask = 0;
-			dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-			std::vector<VkAttachmentDescription> attachments = { colorAttachment, depthAttachment };
-			std::vector<VkSubpassDescription> subpasses = { subpass };
-			std::vector<VkSubpassDependency> dependencies = { dependency };
-
-			auto rpCreateRes = vk::CreateRenderPass(*VulkanApp, attachments, subpasses, dependencies);
-			if (!rpCreateRes)
-				return false;
-			MainRenderPass = *rpCreateRes;
+		FrameGraph.Setup(*VulkanApp, MergeTonemapSubpass);
+		FrameGraph.SetProfiler(&Profiler);
 
-			Framebuffers.resize(VulkanApp->SwapChainImageViews.size());
+		const auto& extent = VulkanApp->SwapChainExtent;
 
-			for (size_t i = 0; i < VulkanApp->SwapChainImageViews.size(); ++i)
-			{
-				std::vector<VkImageView> attachments;
-				attachments.push_back(VulkanApp->SwapChainImageViews[i]);
-				attachments.push_back(VulkanApp->DepthImageView);
+		render::GraphResourceState presentState;
+		presentState.Layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		presentState.Stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 
-				auto fboRes = vk::CreateFramebuffer(*VulkanApp, MainRenderPass, attachments,
-													VulkanApp->SwapChainExtent.width, VulkanApp->SwapChainExtent.height);
-				if (!fboRes)
-					return false;
+		//Acquire semaphore is waited at the color output stage, so the first barrier has to start there
+		render::GraphResourceState acquireState;
+		acquireState.Stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
-				Framebuffers[i] = *fboRes;
-			}
-		}
+		//Headless images are never presented and simply stay in the attachment layout
+		std::optional<render::GraphResourceState> finalState = presentState;
+		if (VulkanApp->Headless)
+			finalState = std::nullopt;
 
-		{
-			vk::TextureParams textureParams;
-			textureParams.MagFilter = VK_FILTER_LINEAR;
-			textureParams.MinFilter = VK_FILTER_LINEAR;
-			textureParams.AddressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			textureParams.AddressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		auto swapchain = FrameGraph.ImportImage("Swapchain",
+												{ extent.width, extent.height, VulkanApp->SwapChainFormat, VK_IMAGE_ASPECT_COLOR_BIT,
+												  VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+												VulkanApp->SwapChainImages, VulkanApp->SwapChainImageViews,
+												acquireState, finalState);
 
-			vk::TextureImageInfo imageInfo;
-			imageInfo.Type = VK_IMAGE_TYPE_2D;
-			imageInfo.ViewType = VK_IMAGE_VIEW_TYPE_2D;
-			imageInfo.Format = VK_FORMAT_R16G16B16A16_SFLOAT;
-			imageInfo.ViewAspect = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageInfo.UsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
-								   | VK_IMAGE_USAGE_SAMPLED_BIT;
-			imageInfo.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		auto hdrColor = FrameGraph.CreateImage("HdrColor",
+											   { extent.width, extent.height, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT });
+		auto hdrDepth = FrameGraph.CreateImage("HdrDepth",
+											   { extent.width, extent.height, VulkanApp->DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT });
 
-			HdrPass.ColorTexture.Setup(*VulkanApp, VulkanApp->SwapChainExtent.width, VulkanApp->SwapChainExtent.height,
-										imageInfo, textureParams);
+		VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
 
-			imageInfo.ViewAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-			imageInfo.Format = VulkanApp->DepthFormat;
-			imageInfo.ViewAspect = VK_IMAGE_ASPECT_DEPTH_BIT;;
-			imageInfo.UsageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
-								   | VK_IMAGE_USAGE_SAMPLED_BIT;
-			imageInfo.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		VkClearValue clearDepth;
+		clearDepth.depthStencil.depth = 1.0f;
+		clearDepth.depthStencil.stencil = 0;
 
-			HdrPass.DepthTexture.Setup(*VulkanApp, VulkanApp->SwapChainExtent.width, VulkanApp->SwapChainExtent.height,
-									   imageInfo, textureParams);
-
-			VkAttachmentDescription depthAttachment{};
-			depthAttachment.format = VulkanApp->DepthFormat;
-			depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-			depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-			VkAttachmentReference depthAttachmentRef{};
-			depthAttachmentRef.attachment = 1;
-			depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-			VkAttachmentDescription colorAttachment{};
-			colorAttachment.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-			colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-			colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			VkAttachmentReference colorAttachmentRef{};
-			colorAttachmentRef.attachment = 0;
-			colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-			VkSubpassDescription subpass{};
-			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-			subpass.colorAttachmentCount = 1;
-			subpass.pColorAttachments = &colorAttachmentRef;
-			subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-
-			std::vector<VkSubpassDependency> dependencies(2);
-
-			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[0].dstSubpass = 0;
-			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			dependencies[1].srcSubpass = 0;
-			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-
-			std::vector<VkAttachmentDescription> attachments = { colorAttachment, depthAttachment };
-			std::vector<VkSubpassDescription> subpasses = { subpass };
-
-			auto rpCreateRes = vk::CreateRenderPass(*VulkanApp, attachments, subpasses, dependencies);
-			if (!rpCreateRes)
-				return false;
-			HdrPass.PassHandler = *rpCreateRes;
+		HdrPass.Pass = FrameGraph.AddPass("Hdr",
+			[this](const VkCommandBuffer, const uint32_t slot)
+			{
+				Draw(slot);
+			});
 
-			for (size_t i = 0; i < VulkanApp->SwapChainImageViews.size(); ++i)
+		FrameGraph.Write(HdrPass.Pass, hdrColor, render::GraphUsage::ColorAttachment, clearColor);
+		FrameGraph.Write(HdrPass.Pass, hdrDepth, render::GraphUsage::DepthAttachment, clearDepth);
+
+		//Render fullscreen quad
+		MainPass = FrameGraph.AddPass("Tonemap",
+			[this](const VkCommandBuffer commandBuffer, const uint32_t)
 			{
-				std::vector<VkImageView> attachments;
-				attachments.push_back(HdrPass.ColorTexture.GetImage().GetViewHandler());
-				attachments.push_back(HdrPass.DepthTexture.GetImage().GetViewHandler());
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, HdrPass.Renderable.Pipeline);
 
-				auto fboRes = vk::CreateFramebuffer(*VulkanApp, HdrPass.PassHandler, attachments,
-													VulkanApp->SwapChainExtent.width, VulkanApp->SwapChainExtent.height);
-				if (!fboRes)
-					return false;
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, HdrPass.Renderable.PipelineLayout,
+										0, 1, HdrPass.Renderable.Descriptor.GetDescriptorInfo().DescriptorSets.data(), 0, nullptr);
 
-				HdrPass.Framebuffers.push_back(*fboRes);
-			}
-			
+				vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+
+				++LastDrawStats.DrawsCount;
+				LastDrawStats.VerticesCount += 6;
+			});
+
+		FrameGraph.Write(MainPass, swapchain, render::GraphUsage::ColorAttachment, clearColor);
+
+		//Merged tonemap reads hdr color straight from the previous subpass and needs no depth
+		if (MergeTonemapSubpass)
+		{
+			FrameGraph.Read(MainPass, hdrColor, render::GraphUsage::InputAttachment);
+		}
+		else
+		{
+			auto mainDepth = FrameGraph.CreateImage("MainDepth",
+													{ extent.width, extent.height, VulkanApp->DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT });
+
+			FrameGraph.Read(MainPass, hdrColor, render::GraphUsage::SampledFragment);
+			FrameGraph.Write(MainPass, mainDepth, render::GraphUsage::DepthAttachment, clearDepth);
+		}
+
+		if (!FrameGraph.Compile())
+		{
+			LOGE("Couldn't compile frame graph!");
+			return false;
+		}
 
+		{
 			auto& renderable = HdrPass.Renderable;
 
+			VkDescriptorImageInfo imageInfo{};
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageInfo.imageView = FrameGraph.GetImageView(hdrColor);
+
 			vk::TextureDescriptor descriptor;
-			descriptor.LinkTexture(HdrPass.ColorTexture, 0);
-			descriptor.Create(*VulkanApp, DescriptorPoolManager, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
 			vk::Shader shader;
 			shader.Setup(*VulkanApp);
 
 			shader.AddStage("res/shaders/offscreen/hdr_vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
-			shader.AddStage("res/shaders/offscreen/hdr_frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+
+			if (MergeTonemapSubpass)
+			{
+				descriptor.LinkImage(imageInfo, 0, VK_SHADER_STAGE_FRAGMENT_BIT);
+				descriptor.Create(*VulkanApp, DescriptorPoolManager, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
+
+				shader.AddStage("res/shaders/offscreen/hdr_input_frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+			}
+			else
+			{
+				vk::TextureParams textureParams;
+				textureParams.MagFilter = VK_FILTER_LINEAR;
+				textureParams.MinFilter = VK_FILTER_LINEAR;
+				textureParams.AddressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+				textureParams.AddressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+				auto samplerRes = vk::CreateSampler(*VulkanApp, textureParams);
+				if (!samplerRes)
+					return false;
+
+				HdrPass.Sampler = *samplerRes;
+				imageInfo.sampler = HdrPass.Sampler;
+
+				descriptor.LinkImage(imageInfo, 0);
+				descriptor.Create(*VulkanApp, DescriptorPoolManager, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+				shader.AddStage("res/shaders/offscreen/hdr_frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+			}
 
 			auto pipeline = CreateMainPipeline(shader, { descriptor.GetDescriptorInfo().DescriptorSetLayout });
 			if (!pipeline)
@@ -423,11 +363,13 @@ namespace manager
 		depthState.stencilTestEnable = VK_FALSE;
 
 
-		const uint8_t dynamicStatesCount = 2;
+		const uint8_t dynamicStatesCount = 4;
 		const VkDynamicState pipelineStates[dynamicStatesCount] =
 		{
 			VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT,
-			VK_DYNAMIC_STATE_CULL_MODE_EXT
+			VK_DYNAMIC_STATE_CULL_MODE_EXT,
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR
 		};
 
 		VkPipelineDynamicStateCreateInfo dynamicState{};
@@ -445,7 +387,8 @@ namespace manager
 		states.DepthState = depthState;
 		states.DynamicState = dynamicState;
 
-		auto pipelineRes = vk::CreateGraphicsPipeline(*VulkanApp, HdrPass.PassHandler, shader, layouts, states);
+		auto pipelineRes = vk::CreateGraphicsPipeline(*VulkanApp, FrameGraph.GetRenderPass(HdrPass.Pass), shader, layouts, states,
+															   FrameGraph.GetSubpass(HdrPass.Pass));
 
 		if (!pipelineRes)
 			return std::nullopt;
@@ -522,8 +465,17 @@ namespace manager
 		depthState.maxDepthBounds = 1.0f;
 		depthState.stencilTestEnable = VK_FALSE;
 
+		const uint8_t dynamicStatesCount = 2;
+		const VkDynamicState pipelineStates[dynamicStatesCount] =
+		{
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR
+		};
+
 		VkPipelineDynamicStateCreateInfo dynamicState{};
 		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = dynamicStatesCount;
+		dynamicState.pDynamicStates = pipelineStates;
 
 		vk::GraphicsStates states;
 		states.Assembly = inputAssembly;
@@ -534,7 +486,8 @@ namespace manager
 		states.DepthState = depthState;
 		states.DynamicState = dynamicState;
 
-		auto pipelineRes = vk::CreateGraphicsPipeline(*VulkanApp, MainRenderPass, shader, layouts, states);
+		auto pipelineRes = vk::CreateGraphicsPipeline(*VulkanApp, FrameGraph.GetRenderPass(MainPass), shader, layouts, states,
+															   FrameGraph.GetSubpass(MainPass));
 
 		if (!pipelineRes)
 			return std::nullopt;
@@ -542,16 +495,18 @@ namespace manager
 		return pipelineRes;
 	}
 
-	bool RenderManager::Setup(vk::VulkanApp& app, AssetManager& am)
+	bool RenderManager::Setup(vk::VulkanApp& app, AssetManager& am, utils::JobSystem& jobs)
 	{
 		VulkanApp = &app;
 		AM = &am;
+		Jobs = &jobs;
 
 		DescriptorPoolManager.Setup(app);
 
 		DescriptorPoolManager.AddUnit(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 		DescriptorPoolManager.AddUnit(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 		DescriptorPoolManager.AddUnit(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+		DescriptorPoolManager.AddUnit(VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
 
 		DescriptorPoolManager.Recreate();
 
@@ -559,7 +514,7 @@ namespace manager
 		if (!SetupRenderPassases())
 			return false;
 
-		CommandBuffers.resize(Framebuffers.size());
+		CommandBuffers.resize(VulkanApp->SwapChainImageViews.size());
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -571,31 +526,119 @@ namespace manager
 			return false;
 
 
+		//Images that hold a transform are tracked in a mask
+		ASSERT(CommandBuffers.size() <= 32, "Too many swapchain images!");
+
 		VkSemaphoreCreateInfo semaphoreInfo{};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		if (vkCreateSemaphore(app.Device, &semaphoreInfo, nullptr, &ImageAvailableSemaphore) != VK_SUCCESS
-			|| vkCreateSemaphore(app.Device, &semaphoreInfo, nullptr, &RenderFinishedSemaphore) != VK_SUCCESS)
+		//Signaled, so the first frames using them don't wait
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		ImageAvailableSemaphores.resize(MaxFramesInFlight, VK_NULL_HANDLE);
+		FrameFences.resize(MaxFramesInFlight, VK_NULL_HANDLE);
+
+		for (uint32_t i = 0; i < MaxFramesInFlight; ++i)
 		{
-			return false;
+			if (vkCreateSemaphore(app.Device, &semaphoreInfo, nullptr, &ImageAvailableSemaphores[i]) != VK_SUCCESS
+				|| vkCreateFence(app.Device, &fenceInfo, nullptr, &FrameFences[i]) != VK_SUCCESS)
+			{
+				return false;
+			}
+		}
+
+		RenderFinishedSemaphores.resize(CommandBuffers.size(), VK_NULL_HANDLE);
+		ImageFrames.resize(CommandBuffers.size(), 0);
+
+		for (auto& semaphore : RenderFinishedSemaphores)
+		{
+			if (vkCreateSemaphore(app.Device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+				return false;
 		}
 
 
 		//Setup ubo's
 		GlobalUBO.Setup(app, vk::UboType::Dynamic, sizeof(CameraUboInfo), 1);
 		LightUBO.Setup(app, vk::UboType::Dynamic, sizeof(LightDataUBO), 1);
+		ObjectTransforms.Setup(app, sizeof(MeshUBO), CommandBuffers.size());
+
+		if (!Uploads.Setup(app) || !LoaderUploads.Setup(app))
+			return false;
+
+		auto timelineRes = vk::CreateTimelineSemaphore(app);
+		if (!timelineRes)
+			return false;
+
+		GraphicsTimeline = *timelineRes;
+
+		if (!Compute.Setup(app, GraphicsTimeline)
+			|| !GraphicsTimer.Setup(app, app.QueueFamilies.Graphics, CommandBuffers.size())
+			|| !Profiler.Setup(app, app.QueueFamilies.Graphics, CommandBuffers.size(), GraphicsProfilerScopes))
+		{
+			return false;
+		}
 
 		TM.Setup(app, am);
 
+		MeshCreator = std::thread(&RenderManager::MeshCreatorLoop, this);
+
 		return true;
 	}
 
 	void RenderManager::Cleanup()
 	{
+		if (MeshCreator.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(MeshCreatorMutex);
+				StopMeshCreator = true;
+			}
+
+			MeshCreatorCondition.notify_all();
+			MeshCreator.join();
+
+			StopMeshCreator = false;
+		}
+
+		MeshRequests.clear();
+
+		vkDeviceWaitIdle(VulkanApp->Device);
+
+		vk::CompleteFrames(*VulkanApp, VulkanApp->SubmittedFrame);
+
+		//Resources held for the next frame can go too, there won't be one
+		VulkanApp->DeletionQueue.FlushAll();
+
+		//Never reached the render thread
+		for (const auto& [mesh, resources] : PreparedMeshes)
+			CleanupMeshResources(*VulkanApp, resources);
+
+		for (const auto& c : CreatedMeshes)
+			CleanupMeshResources(*VulkanApp, c.Resources);
+
+		for (const auto& c : RenderableChanges)
+			CleanupMeshResources(*VulkanApp, c.Resources);
+
+		PreparedMeshes.clear();
+		CreatedMeshes.clear();
+		RenderableChanges.clear();
+		RenderableIds.clear();
+
+		Uploads.Cleanup();
+		LoaderUploads.Cleanup();
+		Compute.Cleanup();
+
+		GraphicsTimer.Cleanup();
+		Profiler.Cleanup();
+		vkDestroySemaphore(VulkanApp->Device, GraphicsTimeline, nullptr);
+
 		CleanupRenderablesInfos(*VulkanApp, RenderablesInfos);
 
 		LightUBO.Cleanup();
 		GlobalUBO.Cleanup();
+		ObjectTransforms.Cleanup();
 
 		TM.Cleanup();
 
@@ -603,225 +646,372 @@ namespace manager
 
 		vkFreeCommandBuffers(VulkanApp->Device, VulkanApp->CommandPoolGQ, CommandBuffers.size(), &CommandBuffers[0]);
 
-		for (size_t i = 0; i < Framebuffers.size(); i++)
-			vkDestroyFramebuffer(VulkanApp->Device, Framebuffers[i], nullptr);
-
 		CleanupOffscreenPass(*VulkanApp, HdrPass);
 
-		vkDestroyRenderPass(VulkanApp->Device, MainRenderPass, nullptr);
+		FrameGraph.Cleanup();
+
+		for (uint32_t i = 0; i < MaxFramesInFlight; ++i)
+		{
+			vkDestroySemaphore(VulkanApp->Device, ImageAvailableSemaphores[i], nullptr);
+			vkDestroyFence(VulkanApp->Device, FrameFences[i], nullptr);
+		}
 
-		vkDestroySemaphore(VulkanApp->Device, ImageAvailableSemaphore, nullptr);
-		vkDestroySemaphore(VulkanApp->Device, RenderFinishedSemaphore, nullptr);
+		for (const auto& semaphore : RenderFinishedSemaphores)
+			vkDestroySemaphore(VulkanApp->Device, semaphore, nullptr);
 	}
 
-	void RenderManager::UpdateGlobalUBO()
+	void RenderManager::UpdateGlobalUBO(const render::FrameSnapshot& snapshot, const uint32_t imageId)
 	{
 		CameraUboInfo ubo;
-		ubo.ToCamera = ActiveCamera.GetViewMatrix();
-		ubo.ToClip = ActiveCamera.GetProjection();
-		ubo.CameraPosition = { ActiveCamera.Position, 1.0f };
+		ubo.ToCamera = snapshot.ToCamera;
+		ubo.ToClip = snapshot.ToClip;
+		ubo.CameraPosition = snapshot.CameraPosition;
 
-		GlobalUBO.Update(&ubo, 1);
+		GlobalUBO.Update(imageId, &ubo, 1);
 	}
 
-	void RenderManager::UpdateMeshUBO(const std::vector<scene::MeshRenderable*>& meshes)
+	void RenderManager::UpdateMeshUBO(const render::FrameSnapshot& snapshot, const uint32_t imageId)
 	{
-		for (size_t i = 0; i < meshes.size(); ++i)
+		PROFILE_ZONE("RenderManager::UpdateMeshUBO");
+
+		const auto& ids = RenderablesInfos.Ids;
+		auto& slots = RenderablesInfos.ObjectSlots;
+
+		TransformsBatch.Clear();
+
+		size_t meshesCount = std::min(snapshot.GetMeshesCount(), slots.size());
+
+		for (size_t i = 0; i < meshesCount; ++i)
 		{
-			if (i >= RenderablesInfos.MeshUBOs.size())
-				break;
+			//Snapshot captured before the renderables changed, see Update
+			if (ids[i] != snapshot.MeshIds[i] || slots[i] == UINT32_MAX)
+				continue;
 
-			auto& mesh = meshes[i];
+			//Skipped while the same mesh hasn't moved since it was written to this image's copy
+			auto& uploaded = RenderablesInfos.UploadedTransforms[i];
+			if (uploaded.Id != snapshot.MeshIds[i] || uploaded.Version != snapshot.TransformVersions[i])
+				uploaded = { snapshot.MeshIds[i], snapshot.TransformVersions[i], 0 };
+			else if (uploaded.Images & (1u << imageId))
+				continue;
 
-			glm::mat4 transform(1.0f);
-			transform = glm::rotate(transform, mesh->GetWorldRotation().w, glm::vec3(mesh->GetWorldRotation()));
-			transform = glm::scale(transform, mesh->GetWorldScale());
-			transform = glm::translate(transform, mesh->GetWorldPosition());
+			uploaded.Images |= 1u << imageId;
 
-			RenderablesInfos.MeshUBOs[i].Update(&transform, 1);
+			TransformsBatch.Push(snapshot.Positions[i], snapshot.Scales[i], snapshot.Rotations[i],
+								 ObjectTransforms.GetSlotData(slots[i], imageId) + offsetof(MeshUBO, Transform));
 		}
 
-		for (size_t i = 0; i < meshes.size(); ++i)
+		//Ranges write to distinct slots, so they need no synchronization
+		auto composeTransforms = [&](uint32_t begin, uint32_t end)
 		{
-			if (i >= RenderablesInfos.MaterialUBOs.size())
-				break;
+			scene::ComposeTransforms(TransformsBatch, begin, end);
+		};
 
-			auto& mesh = meshes[i];
-			auto& material = mesh->Material;
+		Jobs->ParallelFor(TransformsBatch.Size(), ComposeTransformsGrain, composeTransforms);
 
-			RenderablesInfos.MaterialUBOs[i].Update(material->GetMaterialData(), 1);
-		}
+		auto updateMaterials = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				auto& ubo = RenderablesInfos.MaterialUBOs[i];
 
+				if (ids[i] != 0 && ids[i] == snapshot.MeshIds[i] && !ubo.IsEmpty())
+					ubo.Update(imageId, const_cast<uint8_t*>(snapshot.GetMaterialData(i)), 1);
+			}
+		};
+
+		Jobs->ParallelFor(meshesCount, MaterialUpdateGrain, updateMaterials);
 	}
 
-	void RenderManager::UpdateLightUBO(const std::vector<scene::PointLight*>& pointLights,
-									   const std::vector<scene::Spotlight*>& spotlights)
+	void RenderManager::UpdateLightUBO(const render::FrameSnapshot& snapshot, const uint32_t imageId)
 	{
 		LightDataUBO lightData;
 
-		for (size_t i = 0; i < pointLights.size(); ++i)
+		//Lights past the uniform arrays are dropped
+		size_t pointLightsCount = std::min<size_t>(snapshot.PointLights.size(), MaxPointLights);
+		size_t spotlightsCount = std::min<size_t>(snapshot.Spotlights.size(), MaxSpotlights);
+
+		for (size_t i = 0; i < pointLightsCount; ++i)
 		{
-			auto& l = pointLights[i];
+			auto& l = snapshot.PointLights[i];
 
-			lightData.PointLights[i].Position = { l->Position, 1.0f };
-			lightData.PointLights[i].Color = { l->Color, 1.0f };
+			lightData.PointLights[i].Position = { l.Position, 1.0f };
+			lightData.PointLights[i].Color = { l.Color, 1.0f };
 		}
 
-		for (size_t i = 0; i < spotlights.size(); ++i)
+		for (size_t i = 0; i < spotlightsCount; ++i)
 		{
-			auto& l = spotlights[i];
+			auto& l = snapshot.Spotlights[i];
 
-			lightData.Spotlights[i].Position = { l->Position, 1.0f };
-			lightData.Spotlights[i].Direction = { glm::vec3(l->GetWorldRotation()), 0.0f };
-			lightData.Spotlights[i].Color = { l->Color, 1.0f };
-			lightData.Spotlights[i].OuterAngle = l->OuterAngle;
-			lightData.Spotlights[i].InnerAngle = l->InnerAngle;
+			lightData.Spotlights[i].Position = { l.Position, 1.0f };
+			lightData.Spotlights[i].Direction = { l.Direction, 0.0f };
+			lightData.Spotlights[i].Color = { l.Color, 1.0f };
+			lightData.Spotlights[i].OuterAngle = l.OuterAngle;
+			lightData.Spotlights[i].InnerAngle = l.InnerAngle;
 		}
 
-		lightData.PointLightsCount = pointLights.size();
-		lightData.SpotlightsCount = spotlights.size();
+		lightData.PointLightsCount = pointLightsCount;
+		lightData.SpotlightsCount = spotlightsCount;
 
-		LightUBO.Update(&lightData, 1);
+		LightUBO.Update(imageId, &lightData, 1);
 	}
 
 	void RenderManager::Draw(const uint8_t imageId)
 	{
+		PROFILE_ZONE("RenderManager::Draw");
+
+		vk::GpuScope scope(Profiler, CommandBuffers[imageId], "Draw");
+
+		LastDrawStats = {};
+
 		for (size_t j = 0; j < RenderablesInfos.GraphicsPipelines.size(); ++j)
 		{
-			vkCmdBindPipeline(CommandBuffers[imageId], VK_PIPELINE_BIND_POINT_GRAPHICS, RenderablesInfos.GraphicsPipelines[j]);
+			if (j >= VisibleMeshes.size() || !VisibleMeshes[j])
+				continue;
 
+			vkCmdBindPipeline(CommandBuffers[imageId], VK_PIPELINE_BIND_POINT_GRAPHICS, RenderablesInfos.GraphicsPipelines[j]);
 
-			std::vector<VkBuffer> buffers;
+			DrawBuffers.clear();
 			for (const auto& b : RenderablesInfos.Buffers[j])
-				buffers.push_back(b.GetHandler());
-
-			std::vector<VkDeviceSize> offsets(buffers.size(), 0);
+				DrawBuffers.push_back(b.GetHandler());
 
-			vkCmdBindVertexBuffers(CommandBuffers[imageId], 0, buffers.size(), buffers.data(), offsets.data());
+			DrawOffsets.resize(DrawBuffers.size(), 0);
 
+			vkCmdBindVertexBuffers(CommandBuffers[imageId], 0, DrawBuffers.size(), DrawBuffers.data(), DrawOffsets.data());
 
-			std::vector<VkDescriptorSet> descriptors;
+			DrawDescriptors.clear();
 
-			for (auto d : RenderablesInfos.Descriptors[j])
+			for (const auto& d : RenderablesInfos.Descriptors[j])
 			{
-				auto descriptorSets = d.DescriptorSets;
+				const auto& descriptorSets = d.DescriptorSets;
 
 				ASSERT(descriptorSets.size() != 0, "Invalid descriptor created!");
 
-				if (descriptorSets.size() == Framebuffers.size())
-					descriptors.push_back(descriptorSets[imageId]);
+				if (descriptorSets.size() == CommandBuffers.size())
+					DrawDescriptors.push_back(descriptorSets[imageId]);
 				else
-					descriptors.push_back(descriptorSets[0]);
+					DrawDescriptors.push_back(descriptorSets[0]);
 			}
 
 			vkCmdBindDescriptorSets(CommandBuffers[imageId], VK_PIPELINE_BIND_POINT_GRAPHICS, RenderablesInfos.GraphicsPipelineLayouts[j],
-									0, descriptors.size(), descriptors.data(), 0, nullptr);
-
+									0, DrawDescriptors.size(), DrawDescriptors.data(), 0, nullptr);
 
 			//Set dynamic states values
 			vk::CmdSetDepthOp(*VulkanApp, CommandBuffers[imageId], RenderablesInfos.AdditionalInfo[j].DepthCompareOp);
 			vk::CmdSetCullMode(*VulkanApp, CommandBuffers[imageId], RenderablesInfos.AdditionalInfo[j].FacesCullMode);
 
-
 			vkCmdDraw(CommandBuffers[imageId], RenderablesInfos.Buffers[j][0].GetElementsCount(), 1, 0, 0);
+
+			++LastDrawStats.DrawsCount;
+			LastDrawStats.VerticesCount += RenderablesInfos.Buffers[j][0].GetElementsCount();
 		}
 	}
 
-	void RenderManager::Update()
+	void RenderManager::Update(const render::FrameSnapshot& snapshot)
 	{
-		UpdateGlobalUBO();
+		PROFILE_ZONE("RenderManager::Update");
 
-		for (size_t i = 0; i < CommandBuffers.size(); ++i)
-		{
-			VkCommandBufferBeginInfo beginInfo{};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.flags = 0;
-			beginInfo.pInheritanceInfo = nullptr;
+		std::lock_guard<std::mutex> lock(FrameMutex);
 
-			if (vkBeginCommandBuffer(CommandBuffers[i], &beginInfo) != VK_SUCCESS)
-				return;
+		ApplyRenderableChanges();
 
-			VkRenderPassBeginInfo renderPassInfo{};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = HdrPass.PassHandler;
-			renderPassInfo.framebuffer = HdrPass.Framebuffers[i];
-			renderPassInfo.renderArea.offset = { 0, 0 };
-			renderPassInfo.renderArea.extent = VulkanApp->SwapChainExtent;
+		auto imageId = AcquireImage();
+		if (!imageId)
+			return;
 
-			VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+		UpdateGlobalUBO(snapshot, *imageId);
+		UpdateLightUBO(snapshot, *imageId);
 
-			VkClearValue clearDepth;
-			clearDepth.depthStencil.depth = 1.0f;
+		{
+			std::lock_guard<std::mutex> objectsLock(ObjectsMutex);
+			UpdateMeshUBO(snapshot, *imageId);
+		}
 
-			VkClearValue clearValues[2] = { clearColor, clearDepth };
+		//Renderables may have changed since the capture when the render thread is a frame behind.
+		//Meshes registered after it aren't in the snapshot and slots taken over by other meshes don't match its ids,
+		//both are skipped until the next one
+		const auto& ids = RenderablesInfos.Ids;
+		size_t meshesCount = std::min(snapshot.GetMeshesCount(), ids.size());
 
-			renderPassInfo.clearValueCount = 2;
-			renderPassInfo.pClearValues = &clearValues[0];
+		VisibleMeshes.resize(meshesCount);
 
-			vkCmdBeginRenderPass(CommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		for (size_t i = 0; i < meshesCount; ++i)
+		{
+			VisibleMeshes[i] = snapshot.Visible[i] && ids[i] == snapshot.MeshIds[i]
+							   && RenderablesInfos.GraphicsPipelines[i] != VK_NULL_HANDLE;
+		}
 
-			Draw(i);
+		Submit(*imageId);
 
-			vkCmdEndRenderPass(CommandBuffers[i]);
+		SnapshotLatency.store(utils::GetSteadyTime() - snapshot.CaptureTime, std::memory_order_relaxed);
+	}
 
+	std::optional<uint32_t> RenderManager::AcquireImage()
+	{
+		PROFILE_ZONE("RenderManager::AcquireImage");
 
-			//Render fullscreen quad
-			renderPassInfo.renderPass = MainRenderPass;
-			renderPassInfo.framebuffer = Framebuffers[i];
-			vkCmdBeginRenderPass(CommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		const uint32_t frameSlot = VulkanApp->SubmittedFrame % MaxFramesInFlight;
 
-			vkCmdBindPipeline(CommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, HdrPass.Renderable.Pipeline);
+		//Frame submitted with the same acquire semaphore has to be done before it's signaled again
+		vkWaitForFences(VulkanApp->Device, 1, &FrameFences[frameSlot], VK_TRUE, UINT64_MAX);
 
-			vkCmdBindDescriptorSets(CommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, HdrPass.Renderable.PipelineLayout,
-									0, 1, HdrPass.Renderable.Descriptor.GetDescriptorInfo().DescriptorSets.data(), 0, nullptr);
+		//Headless images are used in turns, there is nothing to acquire or present
+		uint32_t imageId = VulkanApp->SubmittedFrame % CommandBuffers.size();
+		if (!VulkanApp->Headless)
+		{
+			auto res = vkAcquireNextImageKHR(VulkanApp->Device, VulkanApp->SwapChain, UINT64_MAX,
+											 ImageAvailableSemaphores[frameSlot], VK_NULL_HANDLE, &imageId);
 
-			vkCmdDraw(CommandBuffers[i], 6, 1, 0, 0);
+			if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR)
+			{
+				LOGE("Couldn't acquire swapchain image!");
+				return std::nullopt;
+			}
+		}
+
+		//Images may come back out of order, so the frame last drawn into this one is waited for on its own
+		const uint64_t lastFrame = ImageFrames[imageId];
+		if (lastFrame > VulkanApp->CompletedFrame)
+		{
+			VkSemaphoreWaitInfo waitInfo{};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &GraphicsTimeline;
+			waitInfo.pValues = &lastFrame;
 
-			vkCmdEndRenderPass(CommandBuffers[i]);
+			vkWaitSemaphores(VulkanApp->Device, &waitInfo, UINT64_MAX);
+		}
 
+		//Timestamps of the image's last frame are read before its command buffer writes new ones
+		if (lastFrame > 0)
+		{
+			auto frameTime = GraphicsTimer.Resolve(imageId);
+			if (frameTime)
+				LastFrameTime = *frameTime;
 
-			if (vkEndCommandBuffer(CommandBuffers[i]) != VK_SUCCESS)
-				return;
+			Profiler.Collect();
 		}
 
-		uint32_t imageId = 0;
-		VkResult acqResult = vkAcquireNextImageKHR(VulkanApp->Device, VulkanApp->SwapChain, UINT64_MAX, ImageAvailableSemaphore, VK_NULL_HANDLE, &imageId);
+		return imageId;
+	}
 
+	void RenderManager::Submit(const uint32_t imageId)
+	{
+		PROFILE_ZONE("RenderManager::Submit");
+
+		const uint32_t frameSlot = VulkanApp->SubmittedFrame % MaxFramesInFlight;
+		const VkCommandBuffer commandBuffer = CommandBuffers[imageId];
+
+		//Only the acquired image's command buffer is recorded, the others may still be executing
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			return;
+
+		GraphicsTimer.Begin(commandBuffer, imageId);
+		Profiler.BeginFrame(commandBuffer, imageId);
+
+		FrameGraph.Execute(commandBuffer, imageId);
+
+		GraphicsTimer.End(commandBuffer, imageId);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			return;
+
+		//Uploads end with a graphics queue submission, so queue order is enough for this frame to see them
+		Uploads.Submit();
+		Uploads.Poll();
+
+		const bool headless = VulkanApp->Headless;
+
+		//Binary semaphores go first, so headless submissions simply skip them
+		const uint32_t firstSemaphore = headless ? 1 : 0;
 
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkSemaphore waitSemaphores[] = { ImageAvailableSemaphore };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		VkSemaphore waitSemaphores[] = { ImageAvailableSemaphores[frameSlot], Compute.GetTimeline() };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, ComputeWait.Stage };
+		uint64_t waitValues[] = { 0, ComputeWait.Value };
 
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
+		submitInfo.waitSemaphoreCount = (ComputeWait.Value > 0 ? 2 : 1) - firstSemaphore;
+		submitInfo.pWaitSemaphores = waitSemaphores + firstSemaphore;
+		submitInfo.pWaitDstStageMask = waitStages + firstSemaphore;
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &CommandBuffers[imageId];
+		submitInfo.pCommandBuffers = &commandBuffer;
 
-		VkSemaphore signalSemaphores[] = { RenderFinishedSemaphore };
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		VkSemaphore signalSemaphores[] = { RenderFinishedSemaphores[imageId], GraphicsTimeline };
+		uint64_t signalValues[] = { 0, VulkanApp->SubmittedFrame + 1 };
+		submitInfo.signalSemaphoreCount = 2 - firstSemaphore;
+		submitInfo.pSignalSemaphores = signalSemaphores + firstSemaphore;
 
-		if (vkQueueSubmit(VulkanApp->GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
-			return;
+		//Values for binary semaphores are ignored
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+		timelineInfo.pWaitSemaphoreValues = waitValues + firstSemaphore;
+		timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+		timelineInfo.pSignalSemaphoreValues = signalValues + firstSemaphore;
+
+		submitInfo.pNext = &timelineInfo;
+
+		vkResetFences(VulkanApp->Device, 1, &FrameFences[frameSlot]);
+
+		{
+			std::lock_guard<std::mutex> queueLock(VulkanApp->QueueMutex);
+
+			if (vkQueueSubmit(VulkanApp->GraphicsQueue, 1, &submitInfo, FrameFences[frameSlot]) != VK_SUCCESS)
+				return;
+		}
 
-		VkPresentInfoKHR presentInfo{};
-		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
+		ImageFrames[imageId] = ++VulkanApp->SubmittedFrame;
 
-		VkSwapchainKHR swapChains[] = { VulkanApp->SwapChain };
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = swapChains;
-		presentInfo.pImageIndices = &imageId;
+		Profiler.Submit(imageId);
 
-		vkQueuePresentKHR(VulkanApp->PresentQueue, &presentInfo);
-		vkQueueWaitIdle(VulkanApp->PresentQueue);
+		ComputeWait.Value = 0;
+		ComputeWait.Stage = 0;
+
+		if (!headless)
+		{
+			VkPresentInfoKHR presentInfo{};
+			presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			presentInfo.waitSemaphoreCount = 1;
+			presentInfo.pWaitSemaphores = signalSemaphores;
+
+			VkSwapchainKHR swapChains[] = { VulkanApp->SwapChain };
+			presentInfo.swapchainCount = 1;
+			presentInfo.pSwapchains = swapChains;
+			presentInfo.pImageIndices = &imageId;
+
+			std::lock_guard<std::mutex> queueLock(VulkanApp->QueueMutex);
+			vkQueuePresentKHR(VulkanApp->PresentQueue, &presentInfo);
+		}
+
+		//Nothing waits for this frame, resources of the frames the gpu has finished meanwhile are freed
+		uint64_t completedFrame = 0;
+		vkGetSemaphoreCounterValue(VulkanApp->Device, GraphicsTimeline, &completedFrame);
+
+		vk::CompleteFrames(*VulkanApp, completedFrame);
+
+		Profiler.Collect();
+
+		Compute.Poll();
 	}
 
-	std::vector<vk::Descriptor> RenderManager::SetupMeshDescriptors(const render::BaseMaterial& material, const vk::Shader& shader)
+	bool RenderManager::WriteGpuTrace(const std::string& filepath) const
+	{
+		auto events = Profiler.GetTraceEvents();
+
+		const auto& computeEvents = Compute.GetProfiler().GetTraceEvents();
+		events.insert(events.end(), computeEvents.begin(), computeEvents.end());
+
+		return utils::WriteChromeTrace(filepath, events);
+	}
+
+	std::vector<vk::Descriptor> RenderManager::SetupMeshDescriptors(const render::BaseMaterial& material, const vk::Shader& shader,
+																	 MeshResources& resources)
 	{
 		auto reflectMap = shader.GetReflectMap();
 
@@ -834,7 +1024,7 @@ namespace manager
 		vk::TextureDescriptor materialTexturesDescriptor;
 
 		{
-			auto& findShaderInfo = reflectMap.find(VK_SHADER_STAGE_VERTEX_BIT);
+			auto findShaderInfo = reflectMap.find(VK_SHADER_STAGE_VERTEX_BIT);
 			if (findShaderInfo == reflectMap.end())
 				return {};
 
@@ -852,19 +1042,26 @@ namespace manager
 					} break;
 				case ShaderDescriptorSetMeshUBO:
 					{
-						vk::UniformBuffer meshUBO;
-						meshUBO.Setup(*VulkanApp, vk::UboType::Static, sizeof(MeshUBO), 1);
+						std::lock_guard<std::mutex> objectsLock(ObjectsMutex);
+
+						auto slot = ObjectTransforms.Allocate();
+						if (!slot)
+							return {};
+
+						std::vector<VkDescriptorBufferInfo> copies;
+						for (uint32_t c = 0; c < ObjectTransforms.GetCopiesCount(); ++c)
+							copies.push_back(ObjectTransforms.GetBufferInfo(*slot, c));
 
-						meshUboDescriptor.LinkUBO(meshUBO, 0);
+						meshUboDescriptor.LinkBuffers(copies, 0);
 
-						RenderablesInfos.MeshUBOs.push_back(meshUBO);
+						resources.ObjectSlot = *slot;
 					} break;
 				}
 			}
 		}
 
 		{
-			auto& findShaderInfo = reflectMap.find(VK_SHADER_STAGE_FRAGMENT_BIT);
+			auto findShaderInfo = reflectMap.find(VK_SHADER_STAGE_FRAGMENT_BIT);
 			if (findShaderInfo == reflectMap.end())
 				return {};
 
@@ -882,19 +1079,20 @@ namespace manager
 					} break;
 				case ShaderDescriptorSetMaterialUBO:
 					{
+						//Rewritten every frame, so each image reads its own copy
 						vk::UniformBuffer materialUBO;
-						materialUBO.Setup(*VulkanApp, vk::UboType::Static, material.GetMaterialInfoStride(), 1);
+						materialUBO.Setup(*VulkanApp, vk::UboType::Dynamic, material.GetMaterialInfoStride(), 1);
 
 						materialUboDescriptor.LinkUBO(materialUBO, 0);
 
-						RenderablesInfos.MaterialUBOs.push_back(materialUBO);
+						resources.MaterialUBO = materialUBO;
 					} break;
 				case ShaderDescriptorSetMaterialTextures:
 					{
 						for (auto& b : d.Bindings)
 						{
 							auto texAccess = material.GetMaterialTextures()[b.BindId];
-							auto texture = TM.GetOrCreate(texAccess, b.ImageType);
+							auto texture = TM.GetOrCreate(LoaderUploads, texAccess, b.ImageType);
 
 							materialTexturesDescriptor.LinkTexture(texture, b.BindId);
 						}
@@ -917,11 +1115,11 @@ namespace manager
 		return descriptors;
 	}
 
-	std::vector<vk::Buffer> RenderManager::SetupMeshBuffers(const scene::MeshRenderable* mesh, vk::Shader& shader)
+	std::vector<vk::Buffer> RenderManager::SetupMeshBuffers(const MeshData& meshData, vk::Shader& shader)
 	{
 		auto reflectMap = shader.GetReflectMap();
 
-		auto& findShaderInfo = reflectMap.find(VK_SHADER_STAGE_VERTEX_BIT);
+		auto findShaderInfo = reflectMap.find(VK_SHADER_STAGE_VERTEX_BIT);
 		if (findShaderInfo == reflectMap.end())
 			return {};
 
@@ -929,8 +1127,6 @@ namespace manager
 
 		size_t bindId = 0;
 
-		auto meshData = AM->GetMeshData(mesh->Mesh);
-
 		for (auto i : findShaderInfo->second.Inputs)
 		{
 			switch (i.LocationId)
@@ -938,8 +1134,10 @@ namespace manager
 			case ShaderInputPositionLocation:
 				{
 					vk::Buffer positionBuffer;
-					positionBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(meshData.Positions[0]), meshData.Positions.size());
-					positionBuffer.Update((void*)meshData.Positions.data(), meshData.Positions.size());
+					positionBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+										  sizeof(meshData.Positions[0]), meshData.Positions.size(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+					LoaderUploads.UploadBuffer(positionBuffer, meshData.Positions.data(), positionBuffer.GetSize(),
+											   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
 					shader.AddInputBuffer(VK_FORMAT_R32G32B32_SFLOAT, bindId, ShaderInputPositionLocation, 0, positionBuffer.GetStride());
 
@@ -948,8 +1146,10 @@ namespace manager
 			case ShaderInputNormalLocation:
 				{
 					vk::Buffer normalBuffer;
-					normalBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(meshData.Normals[0]), meshData.Normals.size());
-					normalBuffer.Update((void*)meshData.Normals.data(), meshData.Normals.size());
+					normalBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+										  sizeof(meshData.Normals[0]), meshData.Normals.size(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+					LoaderUploads.UploadBuffer(normalBuffer, meshData.Normals.data(), normalBuffer.GetSize(),
+											   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
 					shader.AddInputBuffer(VK_FORMAT_R32G32B32_SFLOAT, bindId, ShaderInputNormalLocation, 0, normalBuffer.GetStride());
 
@@ -958,8 +1158,10 @@ namespace manager
 			case ShaderInputUvLocation:
 				{
 					vk::Buffer uvBuffer;
-					uvBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(meshData.UVs[0]), meshData.UVs.size());
-					uvBuffer.Update((void*)meshData.UVs.data(), meshData.UVs.size());
+					uvBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+										  sizeof(meshData.UVs[0]), meshData.UVs.size(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+					LoaderUploads.UploadBuffer(uvBuffer, meshData.UVs.data(), uvBuffer.GetSize(),
+											   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
 					shader.AddInputBuffer(VK_FORMAT_R32G32B32_SFLOAT, bindId, ShaderInputUvLocation, 0, uvBuffer.GetStride());
 
@@ -968,8 +1170,10 @@ namespace manager
 			case ShaderInputTangentLocation:
 				{
 					vk::Buffer tangentBuffer;
-					tangentBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(meshData.Tangents[0]), meshData.Tangents.size());
-					tangentBuffer.Update((void*)meshData.Tangents.data(), meshData.Tangents.size());
+					tangentBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+										  sizeof(meshData.Tangents[0]), meshData.Tangents.size(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+					LoaderUploads.UploadBuffer(tangentBuffer, meshData.Tangents.data(), tangentBuffer.GetSize(),
+											   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
 					shader.AddInputBuffer(VK_FORMAT_R32G32B32_SFLOAT, bindId, ShaderInputTangentLocation, 0, tangentBuffer.GetStride());
 
@@ -978,8 +1182,10 @@ namespace manager
 			case ShaderInputBitangentLocation:
 				{
 					vk::Buffer bitangentBuffer;
-					bitangentBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(meshData.Bitangents[0]), meshData.Bitangents.size());
-					bitangentBuffer.Update((void*)meshData.Bitangents.data(), meshData.Bitangents.size());
+					bitangentBuffer.Setup(*VulkanApp, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+										  sizeof(meshData.Bitangents[0]), meshData.Bitangents.size(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+					LoaderUploads.UploadBuffer(bitangentBuffer, meshData.Bitangents.data(), bitangentBuffer.GetSize(),
+											   VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
 					shader.AddInputBuffer(VK_FORMAT_R32G32B32_SFLOAT, bindId, ShaderInputBitangentLocation, 0, bitangentBuffer.GetStride());
 
@@ -993,44 +1199,286 @@ namespace manager
 		return buffers;
 	}
 
-	void RenderManager::RegisterMesh(scene::MeshRenderable* mesh)
+	std::optional<MeshResources> RenderManager::CreateMeshResources(const render::BaseMaterial* material, const utils::HashString& mesh,
+																   const scene::RenderInfo& info)
 	{
-		if (!mesh->Material)
+		if (!material)
 		{
 			LOGE("Couldn't register mesh without material!");
-			return;
+			return std::nullopt;
 		}
 
+		auto meshData = AM->GetMeshData(mesh);
+		auto shader = material->CreateShader(*VulkanApp);
+
+		std::lock_guard<std::mutex> lock(PrepareMutex);
 
-		auto shader = mesh->Material->CreateShader(*VulkanApp);
+		MeshResources resources;
+		resources.Info = info;
 
-		auto buffers = SetupMeshBuffers(mesh, shader);
+		resources.Buffers = SetupMeshBuffers(meshData, shader);
 
-		auto descriptors = SetupMeshDescriptors(*mesh->Material, shader);
+		resources.Descriptors = SetupMeshDescriptors(*material, shader, resources);
 
 		std::vector<VkDescriptorSetLayout> layouts;
-		for (auto& d : descriptors)
+		for (auto& d : resources.Descriptors)
 			layouts.push_back(d.DescriptorSetLayout);
 
 		auto pipelineRes = CreateMeshPipeline(shader, layouts);
+
+		shader.Cleanup();
+
+		//Resources are handed to threads that never see these uploads, textures found by later meshes too
+		LoaderUploads.WaitAll();
+
 		if (!pipelineRes)
 		{
 			LOGE("Couldn't create graphics pipeline for the mesh!");
+
+			DestroyMeshResources(resources);
+			return std::nullopt;
+		}
+
+		resources.PipelineLayout = pipelineRes->Layout;
+		resources.Pipeline = pipelineRes->Handle;
+
+		return resources;
+	}
+
+	void RenderManager::DestroyMeshResources(const MeshResources& resources)
+	{
+		CleanupMeshResources(*VulkanApp, resources);
+
+		if (resources.ObjectSlot != UINT32_MAX)
+		{
+			std::lock_guard<std::mutex> lock(ObjectsMutex);
+			ObjectTransforms.Release(resources.ObjectSlot);
+		}
+	}
+
+	void RenderManager::ReleaseMeshResources(std::vector<MeshResources>&& resources)
+	{
+		if (resources.empty())
 			return;
+
+		//Changes are applied before the frame is recorded, so the latest submitted one is the last drawing them
+		vk::DeferCleanup(*VulkanApp, VulkanApp->SubmittedFrame,
+			[this, resources = std::move(resources)]()
+			{
+				for (const auto& r : resources)
+					DestroyMeshResources(r);
+			});
+	}
+
+	void RenderManager::MeshCreatorLoop()
+	{
+		while (true)
+		{
+			MeshRequest request;
+
+			{
+				std::unique_lock<std::mutex> lock(MeshCreatorMutex);
+				MeshCreatorCondition.wait(lock, [&]() { return StopMeshCreator || !MeshRequests.empty(); });
+
+				if (StopMeshCreator)
+					break;
+
+				request = std::move(MeshRequests.front());
+				MeshRequests.pop_front();
+			}
+
+			//Meshes that can't be drawn keep an empty renderable, so they aren't created again
+			auto resources = CreateMeshResources(request.Material.get(), request.Mesh, request.Info);
+
+			std::lock_guard<std::mutex> lock(PreparedMutex);
+			CreatedMeshes.push_back({ request.Slot, request.Id, resources ? std::move(*resources) : MeshResources() });
 		}
+	}
 
+	void RenderManager::ApplyRenderableChanges()
+	{
+		PROFILE_ZONE("RenderManager::ApplyRenderableChanges");
 
-		RenderablesInfos.GraphicsPipelineLayouts.push_back(pipelineRes->Layout);
-		RenderablesInfos.GraphicsPipelines.push_back(pipelineRes->Handle);
-		RenderablesInfos.AdditionalInfo.push_back(mesh->Render);
-		RenderablesInfos.Buffers.push_back(buffers);
-		RenderablesInfos.Descriptors.push_back(descriptors);
+		std::vector<RenderableChange> changes;
 
-		shader.Cleanup();
+		{
+			std::lock_guard<std::mutex> lock(ChangesMutex);
+			changes.swap(RenderableChanges);
+		}
+
+		if (changes.empty())
+			return;
+
+		auto& infos = RenderablesInfos;
+
+		std::vector<MeshResources> removed;
+
+		for (auto& c : changes)
+		{
+			if (infos.Ids.size() <= c.Slot)
+				infos.Resize(c.Slot + 1);
+
+			//Also the empty renderable of a mesh whose resources were created meanwhile
+			if (infos.Ids[c.Slot] != 0)
+				removed.push_back(infos.Take(c.Slot));
+
+			if (c.Id != 0)
+				infos.Put(c.Slot, c.Id, std::move(c.Resources));
+		}
+
+		ReleaseMeshResources(std::move(removed));
+	}
+
+	void RenderManager::UpdateRenderables(const scene::ComponentRegistry& registry, const std::vector<uint32_t>& slots)
+	{
+		PROFILE_ZONE("RenderManager::UpdateRenderables");
+
+		const auto& meshes = registry.GetMeshes();
+
+		if (RenderableIds.size() < meshes.size())
+			RenderableIds.resize(meshes.size(), 0);
+
+		std::vector<RenderableChange> changes;
+		std::vector<MeshResources> unused;
+
+		{
+			std::lock_guard<std::mutex> lock(PreparedMutex);
+
+			for (auto& c : CreatedMeshes)
+			{
+				//Slot was emptied or taken over while they were created
+				if (RenderableIds[c.Slot] == c.Id)
+					changes.push_back(std::move(c));
+				else
+					unused.push_back(std::move(c.Resources));
+			}
+
+			CreatedMeshes.clear();
+		}
+
+		std::vector<MeshRequest> requests;
+
+		for (auto slot : slots)
+		{
+			auto mesh = meshes[slot];
+			uint64_t id = mesh ? registry.GetMeshId(slot) : 0;
+
+			//Added and removed again since the previous call
+			if (RenderableIds[slot] == id)
+				continue;
+
+			RenderableIds[slot] = id;
+
+			std::optional<MeshResources> prepared;
+
+			if (mesh)
+			{
+				std::lock_guard<std::mutex> lock(PreparedMutex);
+
+				auto findPrepared = PreparedMeshes.find(mesh);
+				if (findPrepared != PreparedMeshes.end())
+				{
+					prepared = std::move(findPrepared->second);
+					PreparedMeshes.erase(findPrepared);
+				}
+			}
+
+			if (!mesh || prepared)
+			{
+				changes.push_back({ slot, id, prepared ? std::move(*prepared) : MeshResources() });
+				continue;
+			}
+
+			//Bounds are known before the bvh reads them, the renderable stays empty until its resources are created
+			auto bounds = AM->GetMeshBounds(mesh->Mesh);
+			if (bounds && !bounds->IsEmpty())
+				mesh->LocalBounds = *bounds;
+
+			changes.push_back({ slot, id, MeshResources() });
+			requests.push_back({ slot, id, mesh->Material, mesh->Mesh, mesh->Render });
+		}
+
+		for (const auto& r : unused)
+			DestroyMeshResources(r);
+
+		if (!requests.empty())
+		{
+			{
+				std::lock_guard<std::mutex> lock(MeshCreatorMutex);
+
+				for (auto& r : requests)
+					MeshRequests.push_back(std::move(r));
+			}
+
+			MeshCreatorCondition.notify_one();
+		}
+
+		if (changes.empty())
+			return;
+
+		std::lock_guard<std::mutex> lock(ChangesMutex);
+
+		for (auto& c : changes)
+			RenderableChanges.push_back(std::move(c));
+	}
+
+	std::optional<VkDeviceSize> RenderManager::PrepareMesh(scene::MeshRenderable* mesh)
+	{
+		PROFILE_ZONE("RenderManager::PrepareMesh");
+
+		//Not registered yet, so nothing else reads the mesh
+		auto bounds = AM->GetMeshBounds(mesh->Mesh);
+		if (bounds && !bounds->IsEmpty())
+			mesh->LocalBounds = *bounds;
+
+		auto resources = CreateMeshResources(mesh->Material.get(), mesh->Mesh, mesh->Render);
+		if (!resources)
+			return std::nullopt;
+
+		VkDeviceSize size = 0;
+		for (const auto& b : resources->Buffers)
+			size += b.GetSize();
+
+		bool added;
+
+		{
+			std::lock_guard<std::mutex> lock(PreparedMutex);
+			added = PreparedMeshes.emplace(mesh, *resources).second;
+		}
+
+		//Prepared twice, the first resources are kept
+		if (!added)
+			DestroyMeshResources(*resources);
+
+		return size;
+	}
+
+	void RenderManager::DiscardPreparedMesh(const scene::MeshRenderable* mesh)
+	{
+		MeshResources resources;
+
+		{
+			std::lock_guard<std::mutex> lock(PreparedMutex);
+
+			auto findRes = PreparedMeshes.find(mesh);
+			if (findRes == PreparedMeshes.end())
+				return;
+
+			resources = std::move(findRes->second);
+			PreparedMeshes.erase(findRes);
+		}
+
+		//Never handed to the render thread
+		DestroyMeshResources(resources);
 	}
 
 	void RenderManager::SetupIBL(const utils::HashString& hdrFilepath)
 	{
+		PROFILE_ZONE("RenderManager::SetupIBL");
+
+		std::lock_guard<std::mutex> lock(FrameMutex);
+		std::lock_guard<std::mutex> prepareLock(PrepareMutex);
+
 		//TODO make resolutions for maps adjustable through global settings
 
 		auto errFunc = []()
@@ -1060,10 +1508,15 @@ namespace manager
 		IblTextures.Cubemap = *cubemap;
 		IblTextures.IrradianceMap = *irMap;
 		IblTextures.PreFilteredMap = *pfMap;
+
+		//Maps are generated on the compute queue, frames wait for them on the gpu
+		WaitForCompute(Compute.GetSubmittedValue(), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 	}
 
 	std::optional<utils::HashString> RenderManager::GenerateCubemapFromHDR(const utils::HashString& filepath, const uint16_t resolution)
 	{
+		PROFILE_ZONE("RenderManager::GenerateCubemapFromHDR");
+
 		vk::TextureParams params;
 		params.MagFilter = VK_FILTER_LINEAR;
 		params.MinFilter = VK_FILTER_LINEAR;
@@ -1086,10 +1539,8 @@ namespace manager
 		if (!hdrTexture.Setup(*VulkanApp, hdrData.Width, hdrData.Height, hdrImageInfo, params))
 			return std::nullopt;
 
-		hdrTexture.Update(hdrData.PixelsData.data(), 4 * sizeof(float));
-
-		hdrTexture.SetLayout(VulkanApp->ComputeQueue, VulkanApp->CommandPoolCQ,
-							 vk::layout::SetImageLayoutFromTransferToComputeRead);
+		hdrTexture.Update(Uploads, hdrData.PixelsData.data(), 4 * sizeof(float),
+						  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 
 		vk::TextureImageInfo cubemapImageInfo;
 		cubemapImageInfo.Type = VK_IMAGE_TYPE_2D;
@@ -1104,8 +1555,10 @@ namespace manager
 		if (!cubemap.Setup(*VulkanApp, resolution, resolution, cubemapImageInfo, params, 1, 6))
 			return std::nullopt;
 
-		cubemap.SetLayout(VulkanApp->ComputeQueue, VulkanApp->CommandPoolCQ,
-						  vk::layout::SetCubeImageLayoutFromComputeWriteToGraphicsShader);
+		cubemap.Transition(Uploads.GetGraphicsCommandBuffer(), vk::ImageUsage::StorageWrite);
+
+		//Compute runs on its own queue, so the batch has to be finished before dispatch
+		Uploads.Wait(Uploads.Submit());
 
 		vk::TextureDescriptor mapDescriptor;
 		mapDescriptor.LinkTexture(hdrTexture, 0);
@@ -1115,13 +1568,34 @@ namespace manager
 		vk::ComputeShader cs;
 		cs.Setup(*VulkanApp, FromHdrToCubemapShader);
 
-		const int workGroups = 16;
-		vk::RunComputeShader(*VulkanApp, cs, mapDescriptor.GetDescriptorInfo(),
-							 resolution / workGroups, resolution / workGroups, 6);
+		auto descriptor = mapDescriptor.GetDescriptorInfo();
+		std::vector<VkDescriptorSetLayout> layouts = { descriptor.DescriptorSetLayout };
+
+		auto pipelineRes = vk::CreateComputePipeline(*VulkanApp, cs, layouts, {});
+		ASSERT(pipelineRes, "Couldn't create compute pipeline!");
+
+		Compute.Submit(
+			[pipeline = *pipelineRes, cs, descriptor, resolution, profiler = &Compute.GetProfiler()](const VkCommandBuffer cmd)
+			{
+				vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Handle);
+				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Layout, 0, descriptor.DescriptorSets.size(),
+										descriptor.DescriptorSets.data(), 0, 0);
+
+				const int workGroups = 16;
 
-		cs.Cleanup();
-		hdrTexture.Cleanup();
-		mapDescriptor.Destroy();
+				vk::GpuScope scope(*profiler, cmd, "CubemapFromHdr");
+				cs.Dispatch(cmd, resolution / workGroups, resolution / workGroups, 6);
+			});
+
+		Compute.DeferCleanup(
+			[app = VulkanApp, pipeline = *pipelineRes, cs, hdrTexture, mapDescriptor]()
+			{
+				vk::DestoryPipeline(*app, pipeline);
+
+				cs.Cleanup();
+				hdrTexture.Cleanup();
+				mapDescriptor.Destroy();
+			});
 
 		size_t newId = AM->GetProcId();
 		TM.AddTexture(newId, cubemap);
@@ -1131,6 +1605,8 @@ namespace manager
 
 	std::optional<utils::HashString> RenderManager::GenerateIrradianceMap(const utils::HashString& filepath, const uint16_t resolution)
 	{
+		PROFILE_ZONE("RenderManager::GenerateIrradianceMap");
+
 		const int maxTileSize = 64;
 
 		if (resolution % maxTileSize != 0)
@@ -1156,7 +1632,7 @@ namespace manager
 		hdrImageInfo.Layout = VK_IMAGE_LAYOUT_GENERAL;
 		hdrImageInfo.CreateFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 
-		auto hdrTexture = TM.GetOrCreate({ filepath, params }, vk::DescriptorImageType::Cubemap);
+		auto hdrTexture = TM.GetOrCreate(Uploads, { filepath, params }, vk::DescriptorImageType::Cubemap);
 
 		vk::TextureImageInfo mapImageInfo;
 		mapImageInfo.Type = VK_IMAGE_TYPE_2D;
@@ -1171,8 +1647,9 @@ namespace manager
 		if (!map.Setup(*VulkanApp, resolution, resolution, mapImageInfo, params, 1, 6))
 			return std::nullopt;
 
-		map.SetLayout(VulkanApp->ComputeQueue, VulkanApp->CommandPoolCQ,
-					  vk::layout::SetCubeImageLayoutFromComputeWriteToGraphicsShader);
+		map.Transition(Uploads.GetGraphicsCommandBuffer(), vk::ImageUsage::StorageWrite);
+
+		Uploads.Wait(Uploads.Submit());
 
 
 		vk::TextureDescriptor mapDescriptor;
@@ -1202,42 +1679,49 @@ namespace manager
 		auto pipelineRes = vk::CreateComputePipeline(*VulkanApp, cs, layouts, { pushConstant });
 		ASSERT(pipelineRes, "Couldn't create compute pipeline!");
 
-		auto cmd = vk::BeginCommands(*VulkanApp, VulkanApp->CommandPoolCQ);
+		Compute.Submit(
+			[pipeline = *pipelineRes, cs, descriptor, header, resolution, maxTileSize,
+			 profiler = &Compute.GetProfiler()](const VkCommandBuffer cmd) mutable
+			{
+				vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Handle);
+				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Layout, 0, descriptor.DescriptorSets.size(),
+										descriptor.DescriptorSets.data(), 0, 0);
 
-		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineRes->Handle);
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineRes->Layout, 0, descriptor.DescriptorSets.size(),
-								descriptor.DescriptorSets.data(), 0, 0);
+				const int workGroups = 16;
+				const int tilesCount = resolution / maxTileSize;
+				const int size = resolution / workGroups / tilesCount;
 
-		const int workGroups = 16;
-		const int tilesCount = resolution / maxTileSize;
-		const int size = resolution / workGroups / tilesCount;
+				header.MaxTiles = tilesCount;
 
-		header.MaxTiles = tilesCount;
+				for (int f = 0; f < 6; ++f)
+				{
+					header.Face = f;
 
-		for (int f = 0; f < 6; ++f)
-		{
-			header.Face = f;
+					for (int i = 0; i < tilesCount; ++i)
+					{
+						header.CurrentTileX = i;
 
-			for (int i = 0; i < tilesCount; ++i)
-			{
-				header.CurrentTileX = i;
+						for (int j = 0; j < tilesCount; ++j)
+						{
+							header.CurrentTileY = j;
 
-				for (int j = 0; j < tilesCount; ++j)
-				{
-					header.CurrentTileY = j;
+							vkCmdPushConstants(cmd, pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(header), &header);
 
-					vkCmdPushConstants(cmd, pipelineRes->Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(header), &header);
-					cs.Dispatch(cmd, size, size, 1);
+							vk::GpuScope scope(*profiler, cmd, "IrradianceMapTile");
+							cs.Dispatch(cmd, size, size, 1);
+						}
+					}
 				}
-			}
-		}
+			});
 
-		vk::EndCommands(*VulkanApp, VulkanApp->CommandPoolCQ, cmd, VulkanApp->ComputeQueue);
-
-		vk::DestoryPipeline(*VulkanApp, *pipelineRes);
+		Compute.DeferCleanup(
+			[app = VulkanApp, pipeline = *pipelineRes, cs, mapDescriptor]()
+			{
+				vk::DestoryPipeline(*app, pipeline);
 
-		cs.Cleanup();
-		mapDescriptor.Destroy();
+				cs.Cleanup();
+				mapDescriptor.Destroy();
+			});
 
 
 		size_t newId = AM->GetProcId();
@@ -1248,13 +1732,15 @@ namespace manager
 
 	std::optional<utils::HashString> RenderManager::GeneratePreFilteredMap(const utils::HashString& filepath, const uint16_t resolution)
 	{
+		PROFILE_ZONE("RenderManager::GeneratePreFilteredMap");
+
 		vk::TextureParams params;
 		params.MagFilter = VK_FILTER_LINEAR;
 		params.MinFilter = VK_FILTER_LINEAR;
 		params.AddressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 		params.AddressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 
-		auto hdrTexture = TM.GetOrCreate({ filepath, params }, vk::DescriptorImageType::Cubemap);
+		auto hdrTexture = TM.GetOrCreate(Uploads, { filepath, params }, vk::DescriptorImageType::Cubemap);
 
 		vk::TextureImageInfo mapImageInfo;
 		mapImageInfo.Type = VK_IMAGE_TYPE_2D;
@@ -1269,8 +1755,9 @@ namespace manager
 		if(!map.Setup(*VulkanApp, resolution, resolution, mapImageInfo, params, 1, 6))
 			return std::nullopt;
 
-		map.SetLayout(VulkanApp->ComputeQueue, VulkanApp->CommandPoolCQ,
-					  vk::layout::SetCubeImageLayoutFromComputeWriteToGraphicsShader);
+		map.Transition(Uploads.GetGraphicsCommandBuffer(), vk::ImageUsage::StorageWrite);
+
+		Uploads.Wait(Uploads.Submit());
 
 		vk::TextureDescriptor hdrDescriptor;
 		hdrDescriptor.LinkTexture(hdrTexture, 0);
@@ -1306,29 +1793,36 @@ namespace manager
 		auto pipelineRes = vk::CreateComputePipeline(*VulkanApp, cs, layouts, { pushConstant });
 		ASSERT(pipelineRes, "Couldn't create compute pipeline!");
 
-		auto cmd = vk::BeginCommands(*VulkanApp, VulkanApp->CommandPoolCQ);
-
-		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineRes->Handle);
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineRes->Layout, 0, descriptorSets.size(),
-								descriptorSets.data(), 0, 0);
+		Compute.Submit(
+			[pipeline = *pipelineRes, cs, descriptorSets, header, resolution,
+			 profiler = &Compute.GetProfiler()](const VkCommandBuffer cmd) mutable
+			{
+				vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Handle);
+				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Layout, 0, descriptorSets.size(),
+										descriptorSets.data(), 0, 0);
 
-		const int workGroups = 16;
-		const int size = resolution / workGroups;
+				const int workGroups = 16;
+				const int size = resolution / workGroups;
 
-		header.MipMapSizeX = resolution;
-		header.MipMapSizeY = resolution;
-		header.Roughness = 0.0f;
+				header.MipMapSizeX = resolution;
+				header.MipMapSizeY = resolution;
+				header.Roughness = 0.0f;
 
-		vkCmdPushConstants(cmd, pipelineRes->Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(header), &header);
-		cs.Dispatch(cmd, size, size, 6);
+				vkCmdPushConstants(cmd, pipeline.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(header), &header);
 
-		vk::EndCommands(*VulkanApp, VulkanApp->CommandPoolCQ, cmd, VulkanApp->ComputeQueue);
+				vk::GpuScope scope(*profiler, cmd, "PreFilteredMap");
+				cs.Dispatch(cmd, size, size, 6);
+			});
 
-		vk::DestoryPipeline(*VulkanApp, *pipelineRes);
+		Compute.DeferCleanup(
+			[app = VulkanApp, pipeline = *pipelineRes, cs, hdrDescriptor, mapDescriptor]()
+			{
+				vk::DestoryPipeline(*app, pipeline);
 
-		cs.Cleanup();
-		hdrDescriptor.Destroy();
-		mapDescriptor.Destroy();
+				cs.Cleanup();
+				hdrDescriptor.Destroy();
+				mapDescriptor.Destroy();
+			});
 
 		size_t newId = AM->GetProcId();
 		TM.AddTexture(newId, map);
@@ -2,6 +2,11 @@
 #include "vrender.h"
 #include "vulkan/vulkan_app.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include "vulkan/shader.h"
 #include "vulkan/compute_shader.h"
 #include "vulkan/buffer.h"
@@ -9,13 +14,22 @@
 #include "vulkan/texture.h"
 #include "vulkan/helpers.h"
 #include "vulkan/pool.h"
+#include "vulkan/async_compute.h"
+#include "vulkan/queue_timer.h"
+#include "vulkan/gpu_profiler.h"
+#include "vulkan/object_buffer.h"
 
 #include "rendering/material.h"
+#include "rendering/frame_graph.h"
 #include "scene/scene_hi.h"
+#include "scene/transform_batch.h"
 #include "rendering/camera.h"
+#include "rendering/frame_snapshot.h"
 
 #include "managers/asset_manager.h"
 
+#include "utils/job_system.h"
+
 namespace manager
 {
 	constexpr uint8_t MaxPointLights = 32;
@@ -35,6 +49,15 @@ namespace manager
 	constexpr uint8_t ShaderDescriptorBindCameraUBO = 0;
 	constexpr uint8_t ShaderDescriptorBindLightUBO = 1;
 
+	constexpr uint32_t GraphicsProfilerScopes = 64;
+
+	//Frames the cpu may submit before waiting for the gpu
+	constexpr uint32_t MaxFramesInFlight = 2;
+
+	//Items per job of the parallel mesh updates
+	constexpr uint32_t ComposeTransformsGrain = 1024;
+	constexpr uint32_t MaterialUpdateGrain = 64;
+
 	constexpr auto FromHdrToCubemapShader = "res/shaders/compute/generate_cubemap.spv";
 	constexpr auto IrradianceMapComputeShader = "res/shaders/compute/generate_im.spv";
 	constexpr auto PreFilterMapComputeShader = "res/shaders/compute/generate_pm.spv";
@@ -59,7 +82,9 @@ namespace manager
 				t.Cleanup();
 		}
 
-		vk::Texture GetOrCreate(const render::MaterialTexture& texture, const vk::DescriptorImageType type);
+		//New textures are recorded into the uploads, they can be used once those are done
+		vk::Texture GetOrCreate(vk::UploadContext& uploads, const render::MaterialTexture& texture,
+								const vk::DescriptorImageType type);
 
 		inline void AddTexture(const manager::AssetId id, const vk::Texture& texture)
 		{
@@ -76,13 +101,11 @@ namespace manager
 		vk::TextureDescriptor Descriptor;
 	};
 
+	//Attachments and render pass are owned by the frame graph
 	struct OffscreenPass
 	{
-		VkRenderPass PassHandler;
-		std::vector<VkFramebuffer> Framebuffers;
-
-		vk::Texture ColorTexture;
-		vk::Texture DepthTexture;
+		render::GraphPassId Pass;
+		VkSampler Sampler = VK_NULL_HANDLE;
 
 		OffscreenRenderable Renderable;
 	};
@@ -90,8 +113,53 @@ namespace manager
 	void CleanupOffscreenPass(const vk::VulkanApp& app, const OffscreenPass& pass);
 
 
+	//Gpu side of one mesh, created on registration or ahead of it by PrepareMesh
+	struct MeshResources
+	{
+		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+
+		scene::RenderInfo Info;
+
+		std::vector<vk::Buffer> Buffers;
+		std::vector<vk::Descriptor> Descriptors;
+
+		//UINT32_MAX when the shader has no mesh UBO
+		uint32_t ObjectSlot = UINT32_MAX;
+		//Left empty when the shader has no material UBO
+		vk::UniformBuffer MaterialUBO;
+	};
+
+	void CleanupMeshResources(const vk::VulkanApp& app, const MeshResources& resources);
+
+	//Mesh slot taken over by the id with its resources, a zero id empties the slot. Resources stay empty
+	//for meshes that can't be drawn or are still being created
+	struct RenderableChange
+	{
+		uint32_t Slot;
+		uint64_t Id;
+
+		MeshResources Resources;
+	};
+
+	//Mesh registered without prepared resources, holds copies so the creating thread never reads the mesh
+	struct MeshRequest
+	{
+		uint32_t Slot;
+		uint64_t Id;
+
+		std::shared_ptr<render::BaseMaterial> Material;
+		utils::HashString Mesh;
+		scene::RenderInfo Info;
+	};
+
+
+	//Indexed by registry mesh slot, so renderables stay in place while others come and go
 	struct MeshRenderablesInfos
 	{
+		//Registry id of the mesh of each renderable, compared against snapshot ids. Zero for empty places
+		std::vector<uint64_t> Ids;
+
 		std::vector<VkPipelineLayout> GraphicsPipelineLayouts;
 		std::vector<VkPipeline> GraphicsPipelines;
 
@@ -101,31 +169,156 @@ namespace manager
 
 		std::vector<std::vector<vk::Descriptor>> Descriptors;
 
-		std::vector<vk::UniformBuffer> MeshUBOs;
+		//Mesh UBO of each renderable lives in the object buffer
+		std::vector<uint32_t> ObjectSlots;
 		std::vector<vk::UniformBuffer> MaterialUBOs;
+
+		//Mesh id and transform version last written to each object slot, with the images whose copy holds it
+		struct UploadedTransform
+		{
+			uint64_t Id = 0;
+			uint64_t Version = 0;
+			uint32_t Images = 0;
+		};
+
+		std::vector<UploadedTransform> UploadedTransforms;
+
+		//Moves the resources out and leaves the place empty
+		inline MeshResources Take(const size_t index)
+		{
+			MeshResources resources;
+			resources.PipelineLayout = GraphicsPipelineLayouts[index];
+			resources.Pipeline = GraphicsPipelines[index];
+			resources.Info = AdditionalInfo[index];
+			resources.Buffers = std::move(Buffers[index]);
+			resources.Descriptors = std::move(Descriptors[index]);
+			resources.ObjectSlot = ObjectSlots[index];
+			resources.MaterialUBO = std::move(MaterialUBOs[index]);
+
+			Ids[index] = 0;
+			GraphicsPipelineLayouts[index] = VK_NULL_HANDLE;
+			GraphicsPipelines[index] = VK_NULL_HANDLE;
+			Buffers[index].clear();
+			Descriptors[index].clear();
+			ObjectSlots[index] = UINT32_MAX;
+			MaterialUBOs[index] = vk::UniformBuffer();
+
+			return resources;
+		}
+
+		inline void Put(const size_t index, const uint64_t id, MeshResources&& resources)
+		{
+			Ids[index] = id;
+			GraphicsPipelineLayouts[index] = resources.PipelineLayout;
+			GraphicsPipelines[index] = resources.Pipeline;
+			AdditionalInfo[index] = resources.Info;
+			Buffers[index] = std::move(resources.Buffers);
+			Descriptors[index] = std::move(resources.Descriptors);
+			ObjectSlots[index] = resources.ObjectSlot;
+			MaterialUBOs[index] = std::move(resources.MaterialUBO);
+
+			//Slot belongs to another mesh now
+			UploadedTransforms[index] = {};
+		}
+
+		//New places are empty until they are put
+		inline void Resize(const size_t count)
+		{
+			Ids.resize(count, 0);
+			GraphicsPipelineLayouts.resize(count, VK_NULL_HANDLE);
+			GraphicsPipelines.resize(count, VK_NULL_HANDLE);
+			AdditionalInfo.resize(count);
+			Buffers.resize(count);
+			Descriptors.resize(count);
+			ObjectSlots.resize(count, UINT32_MAX);
+			MaterialUBOs.resize(count);
+			UploadedTransforms.resize(count);
+		}
 	};
 
 	void CleanupRenderablesInfos(const vk::VulkanApp& app, const MeshRenderablesInfos& infos);
 
 
+	//Latest finished frame and compute job, overlap shows how much they ran in parallel
+	struct QueueTimings
+	{
+		vk::QueueTimeRange Graphics;
+		vk::QueueTimeRange Compute;
+		uint64_t Overlap;
+	};
+
+	//Draws recorded into the latest command buffer, mesh draws and the fullscreen pass
+	struct DrawStats
+	{
+		uint32_t DrawsCount = 0;
+		uint64_t VerticesCount = 0;
+	};
+
 	class API RenderManager
 	{
 	private:
-		OffscreenPass HdrPass;
+		render::FrameGraph FrameGraph;
 
-		VkRenderPass MainRenderPass;
-		std::vector<VkFramebuffer> Framebuffers;
+		OffscreenPass HdrPass;
+		render::GraphPassId MainPass;
 
 		std::vector<VkCommandBuffer> CommandBuffers;
 
 		vk::DescriptorPoolManager DescriptorPoolManager;
 
-		VkSemaphore ImageAvailableSemaphore;
-		VkSemaphore RenderFinishedSemaphore;
+		//Acquire semaphores and fences are reused every MaxFramesInFlight frames, present semaphores
+		//belong to an image since it's only acquired again once its presentation is done
+		std::vector<VkSemaphore> ImageAvailableSemaphores;
+		std::vector<VkFence> FrameFences;
+		std::vector<VkSemaphore> RenderFinishedSemaphores;
+
+		//Last frame drawn into each image, its command buffer and per image buffers are rewritten once it's done
+		std::vector<uint64_t> ImageFrames;
+
+		vk::UploadContext Uploads;
+
+		//Signaled with the frame number by each frame submission
+		VkSemaphore GraphicsTimeline;
+
+		vk::AsyncCompute Compute;
+
+		struct
+		{
+			uint64_t Value = 0;
+			VkPipelineStageFlags Stage = 0;
+		} ComputeWait;
+
+		vk::QueueTimer GraphicsTimer;
+		vk::QueueTimeRange LastFrameTime;
+
+		//Scopes around every frame graph pass and the mesh draws
+		vk::GpuProfiler Profiler;
+
+		DrawStats LastDrawStats;
+
+		//Capture to submission of the latest drawn snapshot, in nanoseconds
+		std::atomic<uint64_t> SnapshotLatency = 0;
+
+		//Held by every frame, ibl generation takes it so it can be called from the simulation thread while another one renders
+		std::mutex FrameMutex;
+
+		//Held while mesh resources or ibl maps are created, they share the descriptor pool, the texture manager
+		//and the loader uploads
+		std::mutex PrepareMutex;
+
+		//Mesh resources are uploaded through it and handed over once it's done, so frames never wait for them
+		vk::UploadContext LoaderUploads;
+
+		//Slots are allocated while the render thread writes transforms, and a new chunk moves the chunk list
+		std::mutex ObjectsMutex;
 
 		vk::UniformBuffer LightUBO;
 		vk::UniformBuffer GlobalUBO;
 
+		//Mesh transforms are composed straight into its mapped memory, one copy per image
+		vk::ObjectBuffer ObjectTransforms;
+		scene::TransformBatch TransformsBatch;
+
 		struct
 		{
 			utils::HashString Cubemap;
@@ -133,14 +326,46 @@ namespace manager
 			utils::HashString PreFilteredMap;
 		} IblTextures;
 
-		render::Camera ActiveCamera;
-
+		//Render thread only, registration changes reach it through the renderable changes
 		MeshRenderablesInfos RenderablesInfos;
 
+		//Main thread only, registry id handed over for each mesh slot
+		std::vector<uint64_t> RenderableIds;
+
+		//Applied by the render thread before it draws
+		std::mutex ChangesMutex;
+		std::vector<RenderableChange> RenderableChanges;
+
+		//Guards only the two below, never held while resources are created
+		std::mutex PreparedMutex;
+
+		//Created ahead of registration, taken over once the registry holds the mesh
+		std::unordered_map<const scene::MeshRenderable*, MeshResources> PreparedMeshes;
+		//Created for registered meshes, handed over unless their slot changed meanwhile
+		std::vector<RenderableChange> CreatedMeshes;
+
+		//Creates resources of meshes registered without prepared ones, so the main thread never does
+		std::thread MeshCreator;
+		std::mutex MeshCreatorMutex;
+		std::condition_variable MeshCreatorCondition;
+
+		//Guarded by the mutex
+		std::deque<MeshRequest> MeshRequests;
+		bool StopMeshCreator = false;
+
+		//Visibility of the drawn snapshot, indexed like the renderables
+		std::vector<uint8_t> VisibleMeshes;
+
+		//Bindings of the mesh being recorded, reused so draws don't allocate once they've grown
+		std::vector<VkBuffer> DrawBuffers;
+		std::vector<VkDeviceSize> DrawOffsets;
+		std::vector<VkDescriptorSet> DrawDescriptors;
+
 		TextureManager TM;
 
 		manager::AssetManager* AM;
 		vk::VulkanApp* VulkanApp;
+		utils::JobSystem* Jobs;
 
 		bool SetupRenderPassases();
 
@@ -149,34 +374,62 @@ namespace manager
 		std::optional<vk::Pipeline> CreateMainPipeline(vk::Shader& shader,
 													   const std::vector<VkDescriptorSetLayout>& layouts);
 
-		std::vector<vk::Buffer> SetupMeshBuffers(const scene::MeshRenderable* mesh, vk::Shader& shader);
+		std::vector<vk::Buffer> SetupMeshBuffers(const MeshData& meshData, vk::Shader& shader);
 		std::vector<vk::Descriptor> SetupMeshDescriptors(const render::BaseMaterial& material, 
-													     const vk::Shader& shader);
+													     const vk::Shader& shader, MeshResources& resources);
+
+		//Takes the prepare mutex and returns once the uploads are done, so any thread can hand the resources over
+		std::optional<MeshResources> CreateMeshResources(const render::BaseMaterial* material, const utils::HashString& mesh,
+														 const scene::RenderInfo& info);
+
+		//For resources no frame has drawn, they go right away
+		void DestroyMeshResources(const MeshResources& resources);
+
+		//Destroys them once the gpu is done, render thread only
+		void ReleaseMeshResources(std::vector<MeshResources>&& resources);
+
+		void MeshCreatorLoop();
+
+		//Render thread, before the frame is recorded
+		void ApplyRenderableChanges();
+
+		void UpdateGlobalUBO(const render::FrameSnapshot& snapshot, const uint32_t imageId);
+		void UpdateMeshUBO(const render::FrameSnapshot& snapshot, const uint32_t imageId);
+		void UpdateLightUBO(const render::FrameSnapshot& snapshot, const uint32_t imageId);
 
-		void UpdateGlobalUBO();
+		//Waits until the image and the frame slot it's drawn with are free to reuse, nullopt when it can't be acquired
+		std::optional<uint32_t> AcquireImage();
 
 		void Draw(const uint8_t imageId);
 
+		void Submit(const uint32_t imageId);
+
 		std::optional<utils::HashString> GenerateCubemapFromHDR(const utils::HashString& filepath, const uint16_t resolution);
 		std::optional<utils::HashString> GenerateIrradianceMap(const utils::HashString& filepath, const uint16_t resolution);
 		std::optional<utils::HashString> GeneratePreFilteredMap(const utils::HashString& filepath, const uint16_t resolution);
 	public:
-		void UpdateMeshUBO(const std::vector<scene::MeshRenderable*>& meshes);
-		void UpdateLightUBO(const std::vector<scene::PointLight*>& pointLights,
-							const std::vector<scene::Spotlight*>& spotlights);
+		//Tonemapping runs as a second subpass of the hdr render pass, so hdr attachments never leave tile memory.
+		//Read in Setup
+		bool MergeTonemapSubpass = false;
 
-		bool Setup(vk::VulkanApp& app, AssetManager& am);
+		bool Setup(vk::VulkanApp& app, AssetManager& am, utils::JobSystem& jobs);
 
 		void Cleanup();
 
-		void Update();
+		//Uploads the snapshot and draws it, doesn't read the scene so it may run on its own thread
+		void Update(const render::FrameSnapshot& snapshot);
 
-		void RegisterMesh(scene::MeshRenderable* mesh);
+		//Hands the registry mesh slots changed since the previous call to the render thread, only those places are touched.
+		//Added meshes take their prepared resources, the others are created on a background thread and drawn once that's done.
+		//Resources of removed ones are destroyed once the gpu is done with them. Called every frame, also without changes
+		void UpdateRenderables(const scene::ComponentRegistry& registry, const std::vector<uint32_t>& slots);
 
-		inline void SetActiveCamera(const render::Camera& camera)
-		{
-			ActiveCamera = camera;
-		}
+		//Creates the gpu resources of a mesh ahead of its registration, e.g. on a loading thread. Never waits for frames.
+		//Returns the bytes of its vertex buffers, nullopt when the mesh can't be drawn
+		std::optional<VkDeviceSize> PrepareMesh(scene::MeshRenderable* mesh);
+
+		//For prepared meshes that won't be registered, has to be called before the mesh is destroyed
+		void DiscardPreparedMesh(const scene::MeshRenderable* mesh);
 
 		void SetupIBL(const utils::HashString& hdrFilepath);
 
@@ -194,6 +447,49 @@ namespace manager
 		{
 			return IblTextures.PreFilteredMap;
 		}
+
+		//Jobs submitted here may wait for a frame through its number and overlap the following ones
+		inline vk::AsyncCompute& GetAsyncCompute()
+		{
+			return Compute;
+		}
+
+		//Next frame submission waits on the gpu until the compute timeline reaches the value
+		inline void WaitForCompute(const uint64_t value, const VkPipelineStageFlags stage)
+		{
+			ComputeWait.Value = std::max(ComputeWait.Value, value);
+			ComputeWait.Stage |= stage;
+		}
+
+		inline QueueTimings GetQueueTimings() const
+		{
+			QueueTimings timings;
+			timings.Graphics = LastFrameTime;
+			timings.Compute = Compute.GetLastJobTime();
+			timings.Overlap = vk::GetOverlap(timings.Graphics, timings.Compute);
+
+			return timings;
+		}
+
+		inline DrawStats GetDrawStats() const
+		{
+			return LastDrawStats;
+		}
+
+		//Milliseconds from the capture of the latest drawn snapshot until its frame was submitted
+		inline float GetSnapshotLatency() const
+		{
+			return SnapshotLatency.load(std::memory_order_relaxed) / 1e6f;
+		}
+
+		//Rolling stats of frame graph passes and mesh draws
+		inline std::vector<vk::GpuScopeStats> GetGpuStats() const
+		{
+			return Profiler.GetAllStats();
+		}
+
+		//Graphics and compute scopes of everything read back so far
+		bool WriteGpuTrace(const std::string& filepath) const;
 	};
 
 }
\ No newline at end of file
@@ -1,20 +1,214 @@
 #include "scene_manager.h"
 
+#include <cstring>
+
 namespace manager
 {
-	void SceneManager::Update()
+	size_t SceneManager::SplitTransformSubtrees()
+	{
+		PROFILE_ZONE("SceneManager::SplitTransformSubtrees");
+
+		TransformSubtrees.clear();
+		TransformSubtrees.push_back({ RootNode, false });
+
+		//Walked breadth first until there are enough subtrees to keep the workers busy
+		size_t target = Jobs->GetWorkersCount() * TransformSubtreesPerWorker;
+		size_t first = 0;
+
+		while (first < TransformSubtrees.size() && TransformSubtrees.size() - first < target)
+		{
+			auto [node, parentChanged] = TransformSubtrees[first++];
+			node->UpdateTransformLevel(parentChanged, TransformSubtrees);
+		}
+
+		return first;
+	}
+
+	void SceneManager::UpdateBvh()
+	{
+		PROFILE_ZONE("SceneManager::UpdateBvh");
+
+		const auto& meshes = Registry.GetMeshes();
+
+		//E.g. a new root, built at once the tree is better and faster than inserted one by one
+		if (ChangedMeshSlots.size() > MeshBvh.GetItemsCount() * BvhRebuildChangesRatio)
+		{
+			MeshBvh.Build(meshes, *Jobs);
+			return;
+		}
+
+		for (auto slot : ChangedMeshSlots)
+		{
+			MeshBvh.Remove(slot);
+
+			if (meshes[slot])
+				MeshBvh.Insert(slot, meshes[slot]);
+		}
+
+		if (MeshBvh.Refit(*Jobs) && MeshBvh.NeedsRebuild())
+			MeshBvh.Build(meshes, *Jobs);
+	}
+
+	void SceneManager::CaptureMeshes(render::FrameSnapshot& snapshot)
+	{
+		PROFILE_ZONE("SceneManager::CaptureMeshes");
+
+		const auto& meshes = Registry.GetMeshes();
+
+		snapshot.ResizeMeshes(meshes.size());
+
+		//Offsets first, so ranges can copy material data independently
+		size_t materialBytes = 0;
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			snapshot.MaterialOffsets[i] = materialBytes;
+
+			//Meshes without material aren't registered for rendering, they get an empty range
+			if (meshes[i] && meshes[i]->Material)
+				materialBytes += meshes[i]->Material->GetMaterialInfoStride();
+		}
+
+		snapshot.MaterialOffsets[meshes.size()] = materialBytes;
+		snapshot.MaterialData.resize(materialBytes);
+
+		auto captureRange = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				auto m = meshes[i];
+
+				//Free slot
+				if (!m)
+				{
+					snapshot.MeshIds[i] = 0;
+					continue;
+				}
+
+				snapshot.MeshIds[i] = Registry.GetMeshId(i);
+				snapshot.TransformVersions[i] = m->GetTransformVersion();
+				snapshot.Positions[i] = m->GetWorldPosition();
+				snapshot.Scales[i] = m->GetWorldScale();
+				snapshot.Rotations[i] = m->GetWorldRotation();
+
+				size_t offset = snapshot.MaterialOffsets[i];
+				size_t size = snapshot.MaterialOffsets[i + 1] - offset;
+
+				if (size && m->Material)
+					std::memcpy(snapshot.MaterialData.data() + offset, m->Material->GetMaterialData(), size);
+			}
+		};
+
+		Jobs->ParallelFor(meshes.size(), CaptureMeshesGrain, captureRange);
+	}
+
+	void SceneManager::CaptureLights(render::FrameSnapshot& snapshot)
 	{
-		if(Cameras.size() >= 0)
-			RM->SetActiveCamera(Cameras[ActiveCameraId]);
+		snapshot.PointLights.clear();
+		snapshot.Spotlights.clear();
 
-		if (RootNode)
+		for (auto l : Registry.GetPointLights())
+			snapshot.PointLights.push_back({ l->GetWorldPosition(), l->Color });
+
+		for (auto l : Registry.GetSpotlights())
+		{
+			snapshot.Spotlights.push_back({ l->GetWorldPosition(), glm::vec3(l->GetWorldRotation()), l->Color,
+											l->OuterAngle, l->InnerAngle });
+		}
+	}
+
+	void SceneManager::CullMeshes(render::FrameSnapshot& snapshot)
+	{
+		PROFILE_ZONE("SceneManager::CullMeshes");
+
+		auto& visible = snapshot.Visible;
+
+		//No camera, no frustum
+		if (Cameras.empty())
+		{
+			std::fill(visible.begin(), visible.end(), 1);
+			return;
+		}
+
+		std::fill(visible.begin(), visible.end(), 0);
+
+		MeshBvh.QueryFrustum(scene::Frustum::FromMatrix(snapshot.ToClip * snapshot.ToCamera), VisibleMeshes);
+
+		for (auto i : VisibleMeshes)
+			visible[i] = 1;
+
+		const auto& meshes = Registry.GetMeshes();
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			if (meshes[i] && !meshes[i]->Render.FrustumCulled)
+				visible[i] = 1;
+		}
+	}
+
+	void SceneManager::Update(render::FrameSnapshot& snapshot)
+	{
+		PROFILE_ZONE("SceneManager::Update");
+
+		if (!Cameras.empty())
 		{
-			auto meshV = RootNode->GetNodesWithChannel<scene::MeshRenderable>();
-			RM->UpdateMeshUBO(meshV);
+			const render::Camera& camera = Cameras[ActiveCameraId];
 
-			auto plV = RootNode->GetNodesWithChannel<scene::PointLight>();
-			auto slV = RootNode->GetNodesWithChannel<scene::Spotlight>();
-			RM->UpdateLightUBO(plV, slV);
+			snapshot.ToCamera = camera.GetViewMatrix();
+			snapshot.ToClip = camera.GetProjection();
+			snapshot.CameraPosition = { camera.Position, 1.0f };
 		}
+
+		if (!RootNode)
+		{
+			snapshot.ResizeMeshes(0);
+			snapshot.MaterialData.clear();
+			snapshot.PointLights.clear();
+			snapshot.Spotlights.clear();
+
+			return;
+		}
+
+		//Before the bvh reads them, new renderables read the local bounds of their meshes from the assets
+		Registry.TakeChangedMeshSlots(ChangedMeshSlots);
+		RM->UpdateRenderables(Registry, ChangedMeshSlots);
+
+		utils::JobCounter transformsDone;
+		utils::JobCounter lightsDone;
+		utils::JobCounter bvhDone;
+
+		size_t first = SplitTransformSubtrees();
+
+		auto updateSubtrees = [this, first](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				auto [node, parentChanged] = TransformSubtrees[first + i];
+				node->UpdateTransforms(parentChanged);
+			}
+		};
+
+		Jobs->ParallelFor(transformsDone, TransformSubtrees.size() - first, 1, updateSubtrees);
+
+		//Lights only read world transforms, so they are captured next to the meshes
+		auto captureLights = [&]()
+		{
+			CaptureLights(snapshot);
+		};
+
+		Jobs->Run(lightsDone, captureLights, &transformsDone);
+
+		auto updateBvh = [this]()
+		{
+			UpdateBvh();
+		};
+
+		Jobs->Run(bvhDone, updateBvh, &transformsDone);
+
+		Jobs->Wait(transformsDone);
+		CaptureMeshes(snapshot);
+
+		Jobs->Wait(bvhDone);
+		CullMeshes(snapshot);
+
+		Jobs->Wait(lightsDone);
 	}
 }
\ No newline at end of file
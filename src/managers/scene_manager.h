@@ -3,28 +3,67 @@
 #include "render_manager.h"
 
 #include "scene/scene_hi.h"
+#include "scene/bvh.h"
+#include "scene/scene_file.h"
 #include "rendering/camera.h"
+#include "rendering/frame_snapshot.h"
 
 #include "vulkan/texture.h"
 
+#include "utils/job_system.h"
+
 namespace manager
 {
+	//Subtrees split off the hierarchy per worker before transform updates go parallel
+	constexpr uint32_t TransformSubtreesPerWorker = 4;
+
+	//Meshes per job of the snapshot capture
+	constexpr uint32_t CaptureMeshesGrain = 1024;
+
+	//Changed mesh slots relative to the bvh items, past it the bvh is rebuilt instead of inserting them one by one
+	constexpr float BvhRebuildChangesRatio = 0.25f;
+
 	class SceneManager
 	{
 	private:
 		std::vector<std::reference_wrapper<render::Camera>> Cameras;
 		size_t ActiveCameraId = 0;
 
-		scene::Node* RootNode;
+		scene::Node* RootNode = nullptr;
+		scene::ComponentRegistry Registry;
+
+		//Roots of the subtrees updated in parallel, with the parentChanged value to pass them
+		std::vector<std::pair<scene::Node*, bool>> TransformSubtrees;
+
+		//Registry mesh slots added to or freed since the previous update, applied to the renderables and the bvh
+		std::vector<uint32_t> ChangedMeshSlots;
+
+		//Over the registry meshes, updated as they change and refitted when they move
+		scene::Bvh MeshBvh;
+
+		std::vector<uint32_t> VisibleMeshes;
 
 		RenderManager* RM;
+		utils::JobSystem* Jobs;
+
+		//Updates the top levels and returns the first subtree left for the workers
+		size_t SplitTransformSubtrees();
+
+		void UpdateBvh();
+
+		void CaptureMeshes(render::FrameSnapshot& snapshot);
+		void CaptureLights(render::FrameSnapshot& snapshot);
+
+		void CullMeshes(render::FrameSnapshot& snapshot);
 	public:
-		inline void Setup(RenderManager& rm)
+		inline void Setup(RenderManager& rm, utils::JobSystem& jobs)
 		{
 			RM = &rm;
+			Jobs = &jobs;
 		}
 
-		void Update();
+		//Updates transforms and captures everything the renderer needs into the snapshot
+		void Update(render::FrameSnapshot& snapshot);
 
 		inline size_t Register(render::Camera& camera)
 		{
@@ -40,16 +79,53 @@ namespace manager
 				return;
 			}
 
-			ActiveCameraId = 0;
+			ActiveCameraId = id;
+		}
+
+		//nullptr while no camera is registered
+		inline const render::Camera* GetActiveCamera() const
+		{
+			return Cameras.empty() ? nullptr : &Cameras[ActiveCameraId].get();
 		}
 
+		//Nodes attached under the root later on are registered right away, like the ones detached from it are
+		//unregistered. The renderer and the bvh pick the changes up on the next update, gpu resources
+		//of removed meshes go once the gpu is done with them
 		inline void SetRoot(scene::Node* node)
 		{
+			if (RootNode)
+				RootNode->SetRegistry(nullptr);
+
 			RootNode = node;
+			RootNode->SetRegistry(&Registry);
+		}
+
+		inline scene::Node* GetRoot() const
+		{
+			return RootNode;
+		}
 
-			auto meshV = RootNode->GetNodesWithChannel<scene::MeshRenderable>();
-			for (auto& m : meshV)
-				RM->RegisterMesh(m);
+		//Writes the current root and everything under it, see scene::WriteSceneFile
+		inline bool SaveScene(const std::string& path, const scene::MaterialLibrary& materials) const
+		{
+			if (!RootNode)
+			{
+				LOGE("Can't save a scene without a root!");
+				return false;
+			}
+
+			return scene::WriteSceneFile(path, *RootNode, materials);
+		}
+
+		inline const scene::ComponentRegistry& GetRegistry() const
+		{
+			return Registry;
+		}
+
+		//Bounds as of the latest Update, items are the registry mesh slots of that update
+		inline const scene::Bvh& GetMeshBvh() const
+		{
+			return MeshBvh;
 		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,409 @@
+#include "world_partition.h"
+
+namespace manager
+{
+	void WorldPartition::LoaderLoop()
+	{
+		while (true)
+		{
+			LoadRequest request;
+			bool hasRequest = false;
+
+			std::vector<RetiredScene> destroyed;
+
+			{
+				std::unique_lock<std::mutex> lock(LoaderMutex);
+				LoaderCondition.wait(lock, [&]() { return StopLoader || !Requests.empty() || !Destroyed.empty(); });
+
+				if (StopLoader)
+					break;
+
+				destroyed.swap(Destroyed);
+
+				if (!Requests.empty())
+				{
+					request = std::move(Requests.front());
+					Requests.pop_front();
+
+					hasRequest = true;
+				}
+			}
+
+			for (auto& r : destroyed)
+				DestroyScene(r);
+
+			if (!hasRequest)
+				continue;
+
+			LoadResult result;
+			result.Cell = request.Cell;
+			result.MemoryUsage = 0;
+			result.Scene = LoadCell(request, result.MemoryUsage);
+
+			std::lock_guard<std::mutex> lock(LoaderMutex);
+			Results.push_back(std::move(result));
+		}
+	}
+
+	std::unique_ptr<scene::LoadedScene> WorldPartition::LoadCell(const LoadRequest& request, size_t& memoryUsage)
+	{
+		PROFILE_ZONE("WorldPartition::LoadCell");
+
+		auto loaded = std::make_unique<scene::LoadedScene>();
+		if (!loaded->Load(request.Path, *request.Materials))
+			return nullptr;
+
+		memoryUsage = loaded->GetMemoryUsage();
+
+		//Meshes that can't be prepared are retried, and reported, when the cell is attached
+		loaded->GetStore().GetPool<scene::MeshRenderable>().ForEach(
+			[&](scene::MeshRenderable& mesh)
+			{
+				if (StopLoader.load(std::memory_order_relaxed))
+					return;
+
+				auto size = RM->PrepareMesh(&mesh);
+				if (size)
+					memoryUsage += *size;
+			});
+
+		return loaded;
+	}
+
+	void WorldPartition::DestroyScene(RetiredScene& retired)
+	{
+		PROFILE_ZONE("WorldPartition::DestroyScene");
+
+		if (!retired.Attached)
+		{
+			retired.Scene->GetStore().GetPool<scene::MeshRenderable>().ForEach(
+				[&](scene::MeshRenderable& mesh)
+				{
+					RM->DiscardPreparedMesh(&mesh);
+				});
+		}
+
+		retired.Scene.reset();
+	}
+
+	void WorldPartition::CollectLoads()
+	{
+		std::vector<LoadResult> results;
+
+		{
+			std::lock_guard<std::mutex> lock(LoaderMutex);
+			results.swap(Results);
+		}
+
+		for (auto& r : results)
+		{
+			--PendingLoads;
+
+			auto& cell = Cells[r.Cell];
+
+			//Canceled, or loaded again while the first load was running
+			if (cell.State != CellState::Loading)
+			{
+				if (r.Scene)
+					Retired.push_back({ std::move(r.Scene), UpdatesCount, false });
+
+				continue;
+			}
+
+			if (!r.Scene)
+			{
+				LOGE("Couldn't load world cell %d %d from %s!", cell.Coords.x, cell.Coords.y, cell.Path.c_str());
+
+				cell.State = CellState::Failed;
+				continue;
+			}
+
+			cell.Scene = std::move(r.Scene);
+			cell.MemoryUsage = r.MemoryUsage;
+			cell.State = CellState::Ready;
+		}
+	}
+
+	void WorldPartition::RetireScenes()
+	{
+		size_t keepCount = 0;
+		bool handedOver = false;
+
+		{
+			std::lock_guard<std::mutex> lock(LoaderMutex);
+
+			for (auto& r : Retired)
+			{
+				if (UpdatesCount >= r.RetiredAt + RetiredSceneUpdates)
+				{
+					Destroyed.push_back(std::move(r));
+					handedOver = true;
+
+					continue;
+				}
+
+				Retired[keepCount++] = std::move(r);
+			}
+		}
+
+		Retired.resize(keepCount);
+
+		if (handedOver)
+			LoaderCondition.notify_one();
+	}
+
+	void WorldPartition::RequestLoad(const uint32_t cell)
+	{
+		auto& c = Cells[cell];
+
+		{
+			std::lock_guard<std::mutex> lock(LoaderMutex);
+			Requests.push_back({ cell, c.Path, c.Materials });
+		}
+
+		LoaderCondition.notify_one();
+
+		c.State = CellState::Loading;
+		++PendingLoads;
+	}
+
+	void WorldPartition::CancelLoad(const uint32_t cell)
+	{
+		Cells[cell].State = CellState::Unloaded;
+
+		//Requests already on the loading thread finish and their scene is retired once it arrives
+		std::lock_guard<std::mutex> lock(LoaderMutex);
+
+		auto findRes = std::find_if(Requests.begin(), Requests.end(),
+									[&](const LoadRequest& r) { return r.Cell == cell; });
+
+		if (findRes != Requests.end())
+		{
+			Requests.erase(findRes);
+			--PendingLoads;
+		}
+	}
+
+	void WorldPartition::Attach(const uint32_t cell)
+	{
+		auto& c = Cells[cell];
+
+		Root.AttachChild(&c.Scene->GetRoot());
+
+		c.State = CellState::Attached;
+		++AttachedCellsCount;
+	}
+
+	void WorldPartition::Evict(const uint32_t cell)
+	{
+		auto& c = Cells[cell];
+
+		bool attached = c.State == CellState::Attached;
+
+		if (attached)
+		{
+			Root.DetachChild(&c.Scene->GetRoot());
+			--AttachedCellsCount;
+		}
+
+		MemoryUsage -= c.MemoryUsage;
+
+		Retired.push_back({ std::move(c.Scene), UpdatesCount, attached });
+		c.State = CellState::Unloaded;
+	}
+
+	void WorldPartition::SortCandidates(const CellState state)
+	{
+		Candidates.clear();
+
+		for (uint32_t i = 0; i < Cells.size(); ++i)
+		{
+			if (Cells[i].State == state)
+				Candidates.push_back(i);
+		}
+
+		std::sort(Candidates.begin(), Candidates.end(),
+				  [&](const uint32_t a, const uint32_t b) { return Cells[a].Distance < Cells[b].Distance; });
+	}
+
+	bool WorldPartition::FreeMemory(const size_t bytes, const float distance, uint32_t& changes)
+	{
+		while (MemoryUsage + bytes > MemoryBudget)
+		{
+			uint32_t farthest = UINT32_MAX;
+
+			for (uint32_t i = 0; i < Cells.size(); ++i)
+			{
+				const auto& c = Cells[i];
+
+				bool evictable = c.State == CellState::Ready
+								 || (c.State == CellState::Attached && changes < MaxCellChangesPerFrame);
+
+				if (evictable && c.Distance > distance && (farthest == UINT32_MAX || c.Distance > Cells[farthest].Distance))
+					farthest = i;
+			}
+
+			if (farthest == UINT32_MAX)
+				return false;
+
+			if (Cells[farthest].State == CellState::Attached)
+				++changes;
+
+			Evict(farthest);
+		}
+
+		return true;
+	}
+
+	void WorldPartition::Cleanup()
+	{
+		if (Loader.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(LoaderMutex);
+				StopLoader = true;
+			}
+
+			LoaderCondition.notify_all();
+			Loader.join();
+
+			StopLoader = false;
+		}
+
+		//Prepared meshes are left to the renderer cleanup
+		for (auto& c : Cells)
+		{
+			if (c.State == CellState::Attached)
+				Root.DetachChild(&c.Scene->GetRoot());
+
+			c.Scene.reset();
+			c.State = CellState::Unloaded;
+		}
+
+		Retired.clear();
+		Destroyed.clear();
+		Results.clear();
+		Requests.clear();
+
+		MemoryUsage = 0;
+		AttachedCellsCount = 0;
+		PendingLoads = 0;
+	}
+
+	bool WorldPartition::AddCell(const glm::ivec2& coords, const std::string& path, const scene::MaterialLibrary& materials)
+	{
+		if (!CellsLookup.emplace(GetCellKey(coords), Cells.size()).second)
+		{
+			LOGE("World cell %d %d was added already!", coords.x, coords.y);
+			return false;
+		}
+
+		Cell cell;
+		cell.Coords = coords;
+		cell.Path = path;
+		cell.Materials = &materials;
+
+		Cells.push_back(std::move(cell));
+
+		if (!Loader.joinable())
+			Loader = std::thread(&WorldPartition::LoaderLoop, this);
+
+		return true;
+	}
+
+	void WorldPartition::Update()
+	{
+		PROFILE_ZONE("WorldPartition::Update");
+
+		if (Cells.empty())
+			return;
+
+		++UpdatesCount;
+
+		CollectLoads();
+		RetireScenes();
+
+		//Nothing to stream around
+		auto camera = SM->GetActiveCamera();
+		if (!camera)
+			return;
+
+		const glm::vec2 center(camera->Position.x, camera->Position.z);
+		const float unloadRadius = std::max(UnloadRadius, LoadRadius);
+
+		MemoryUsage = 0;
+		size_t pendingMemoryUsage = 0;
+
+		for (auto& c : Cells)
+		{
+			glm::vec2 min = glm::vec2(c.Coords) * CellSize;
+			glm::vec2 nearest = glm::clamp(center, min, min + CellSize);
+
+			c.Distance = glm::distance(center, nearest);
+
+			if (c.State == CellState::Ready || c.State == CellState::Attached)
+				MemoryUsage += c.MemoryUsage;
+			else if (c.State == CellState::Loading)
+				pendingMemoryUsage += c.MemoryUsage;
+		}
+
+		uint32_t changes = 0;
+
+		for (uint32_t i = 0; i < Cells.size(); ++i)
+		{
+			auto& c = Cells[i];
+
+			if (c.Distance <= unloadRadius)
+				continue;
+
+			if (c.State == CellState::Loading)
+			{
+				pendingMemoryUsage -= c.MemoryUsage;
+				CancelLoad(i);
+			}
+			else if (c.State == CellState::Ready)
+			{
+				Evict(i);
+			}
+			else if (c.State == CellState::Attached && changes < MaxCellChangesPerFrame)
+			{
+				Evict(i);
+				++changes;
+			}
+		}
+
+		//Still over the budget, e.g. after it was lowered
+		FreeMemory(0, -1.0f, changes);
+
+		if (changes < MaxCellChangesPerFrame)
+		{
+			SortCandidates(CellState::Ready);
+
+			for (auto i : Candidates)
+			{
+				if (changes >= MaxCellChangesPerFrame)
+					break;
+
+				Attach(i);
+				++changes;
+			}
+		}
+
+		//Nearest cells first, farther ones make room for them
+		SortCandidates(CellState::Unloaded);
+
+		for (auto i : Candidates)
+		{
+			auto& c = Cells[i];
+
+			if (c.Distance > LoadRadius || PendingLoads >= MaxPendingLoads
+				|| !FreeMemory(pendingMemoryUsage + c.MemoryUsage, c.Distance, changes))
+			{
+				break;
+			}
+
+			pendingMemoryUsage += c.MemoryUsage;
+			RequestLoad(i);
+		}
+	}
+}
\ No newline at end of file
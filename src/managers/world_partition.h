@@ -0,0 +1,194 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "vrender.h"
+#include "scene_manager.h"
+#include "render_manager.h"
+
+#include "scene/scene_file.h"
+
+namespace manager
+{
+	//Updates a retired cell scene waits before it's destroyed, the render thread may still draw a snapshot
+	//holding its meshes and their addresses mustn't be reused under it
+	constexpr uint64_t RetiredSceneUpdates = 2;
+
+	//Streams a world split into square cells on the xz plane around the active camera. Each cell is a scene
+	//file loaded on a background thread together with the gpu resources of its meshes, so attaching it only
+	//hands the prepared resources over. Cells are requested inside the load radius and evicted past the unload
+	//radius, the gap between them keeps cells on the border from reloading every frame
+	class WorldPartition
+	{
+	private:
+		enum class CellState
+		{
+			Unloaded,
+			//Queued or on the loading thread
+			Loading,
+			//Loaded and prepared, waiting to be attached
+			Ready,
+			Attached,
+			//Couldn't be loaded, never requested again
+			Failed
+		};
+
+		struct Cell
+		{
+			glm::ivec2 Coords;
+			std::string Path;
+			const scene::MaterialLibrary* Materials;
+
+			CellState State = CellState::Unloaded;
+			std::unique_ptr<scene::LoadedScene> Scene;
+
+			//Nodes and vertex buffers of the latest load, zero until the cell was loaded once
+			size_t MemoryUsage = 0;
+
+			//From the camera to the nearest point of the cell as of the latest update
+			float Distance = 0.0f;
+		};
+
+		struct LoadRequest
+		{
+			uint32_t Cell;
+			std::string Path;
+			const scene::MaterialLibrary* Materials;
+		};
+
+		//Scene is nullptr when the load failed
+		struct LoadResult
+		{
+			uint32_t Cell;
+			std::unique_ptr<scene::LoadedScene> Scene;
+			size_t MemoryUsage;
+		};
+
+		//Scenes of evicted cells, destroyed on the loading thread so big cells don't stall the main one
+		struct RetiredScene
+		{
+			std::unique_ptr<scene::LoadedScene> Scene;
+			uint64_t RetiredAt;
+
+			//Never attached scenes still have prepared meshes to discard
+			bool Attached;
+		};
+
+		std::vector<Cell> Cells;
+		std::unordered_map<uint64_t, uint32_t> CellsLookup;
+
+		//Attached cells are its children
+		scene::Node Root;
+
+		//Main thread only
+		uint64_t UpdatesCount = 0;
+		size_t MemoryUsage = 0;
+		uint32_t AttachedCellsCount = 0;
+		//Queued and loading requests, including canceled ones until their results arrive
+		uint32_t PendingLoads = 0;
+		std::vector<RetiredScene> Retired;
+		//Kept between updates, so sorting cells doesn't allocate
+		std::vector<uint32_t> Candidates;
+
+		std::thread Loader;
+		std::mutex LoaderMutex;
+		std::condition_variable LoaderCondition;
+
+		//Guarded by the mutex
+		std::deque<LoadRequest> Requests;
+		std::vector<LoadResult> Results;
+		std::vector<RetiredScene> Destroyed;
+
+		//Read without the mutex between meshes of a load
+		std::atomic<bool> StopLoader = false;
+
+		SceneManager* SM;
+		RenderManager* RM;
+
+		static inline uint64_t GetCellKey(const glm::ivec2& coords)
+		{
+			return (static_cast<uint64_t>(static_cast<uint32_t>(coords.x)) << 32) | static_cast<uint32_t>(coords.y);
+		}
+
+		void LoaderLoop();
+
+		std::unique_ptr<scene::LoadedScene> LoadCell(const LoadRequest& request, size_t& memoryUsage);
+		void DestroyScene(RetiredScene& retired);
+
+		void CollectLoads();
+		void RetireScenes();
+
+		void RequestLoad(const uint32_t cell);
+		void CancelLoad(const uint32_t cell);
+
+		void Attach(const uint32_t cell);
+		void Evict(const uint32_t cell);
+
+		//Candidates in the state, nearest first
+		void SortCandidates(const CellState state);
+
+		//Evicts the farthest cells beyond the distance until the bytes fit into the budget, attached ones
+		//only while changes are left. False when they still don't fit
+		bool FreeMemory(const size_t bytes, const float distance, uint32_t& changes);
+	public:
+		//Side of the square cells in world units
+		float CellSize = 64.0f;
+
+		//Cells nearer than it are loaded, ones farther than the unload radius are evicted
+		float LoadRadius = 128.0f;
+		float UnloadRadius = 192.0f;
+
+		//Bytes of loaded cells, the farthest ones are evicted past it and no loads are requested that would
+		//exceed it. Cells are measured on their first load, until then they count as empty
+		size_t MemoryBudget = 1ull << 30;
+
+		//Cells attached or detached in one update, each change registers or unregisters every mesh of the cell
+		uint32_t MaxCellChangesPerFrame = 1;
+
+		//Requests queued for the loading thread at once, lower values react faster to camera moves
+		uint32_t MaxPendingLoads = 2;
+
+		inline void Setup(SceneManager& sm, RenderManager& rm)
+		{
+			SM = &sm;
+			RM = &rm;
+		}
+
+		//Stops the loading thread and destroys every cell scene, before the renderer is cleaned up
+		void Cleanup();
+
+		//Cell (x, z) covers [x, x + 1) * CellSize on the x axis and the same on z, its scene file is in world space.
+		//Mesh assets have to be loaded up front and the material library stays unchanged while the cell streams,
+		//both are read on the loading thread. False when the cell was added already
+		bool AddCell(const glm::ivec2& coords, const std::string& path, const scene::MaterialLibrary& materials);
+
+		//Streams cells around the active camera, called every frame before the scene manager update.
+		//Never waits for loads, finished ones are picked up by a later update
+		void Update();
+
+		//Cells are attached under it, it has to be attached under the scene root for them to be drawn
+		inline scene::Node& GetRoot()
+		{
+			return Root;
+		}
+
+		//Of the attached and ready cells, as of the latest update
+		inline size_t GetMemoryUsage() const
+		{
+			return MemoryUsage;
+		}
+
+		inline uint32_t GetAttachedCellsCount() const
+		{
+			return AttachedCellsCount;
+		}
+
+		inline uint32_t GetPendingLoadsCount() const
+		{
+			return PendingLoads;
+		}
+	};
+}
\ No newline at end of file
@@ -69,6 +69,15 @@ namespace render
 
 		void Move(const CameraMoveDirection direction, const float deltaTime);
 
+		//Angles in radians
+		inline void SetRotation(const float yaw, const float pitch)
+		{
+			Yaw = yaw;
+			Pitch = pitch;
+
+			ComputeBasis();
+		}
+
 		inline void AddRotation(const float yaw, const float pitch, const float deltaTime)
 		{
 			Yaw -= yaw * Sensetivity * deltaTime;
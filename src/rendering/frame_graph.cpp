@@ -0,0 +1,931 @@
+#include "frame_graph.h"
+
+#include "vulkan/helpers.h"
+
+#include <algorithm>
+
+namespace render
+{
+	GraphResourceState GetUsageState(const GraphUsage usage, const bool write)
+	{
+		GraphResourceState state;
+
+		switch (usage)
+		{
+		case GraphUsage::ColorAttachment:
+			state.Layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			state.Access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | (write ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0);
+			state.Stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			break;
+		case GraphUsage::DepthAttachment:
+			state.Layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			state.Access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | (write ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : 0);
+			state.Stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			break;
+		case GraphUsage::InputAttachment:
+			state.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			state.Access = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			break;
+		case GraphUsage::SampledFragment:
+			state.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			state.Access = VK_ACCESS_SHADER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			break;
+		case GraphUsage::SampledCompute:
+			state.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			state.Access = VK_ACCESS_SHADER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			break;
+		case GraphUsage::StorageRead:
+			state.Layout = VK_IMAGE_LAYOUT_GENERAL;
+			state.Access = VK_ACCESS_SHADER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			break;
+		case GraphUsage::StorageWrite:
+			state.Layout = VK_IMAGE_LAYOUT_GENERAL;
+			state.Access = VK_ACCESS_SHADER_WRITE_BIT;
+			state.Stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			break;
+		case GraphUsage::TransferSrc:
+			state.Layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			state.Access = VK_ACCESS_TRANSFER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			break;
+		case GraphUsage::TransferDst:
+			state.Layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			state.Access = VK_ACCESS_TRANSFER_WRITE_BIT;
+			state.Stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			break;
+		case GraphUsage::VertexBuffer:
+			state.Access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+			break;
+		case GraphUsage::UniformBuffer:
+			state.Access = VK_ACCESS_UNIFORM_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			break;
+		}
+
+		return state;
+	}
+
+	VkImageUsageFlags GetUsageFlags(const GraphUsage usage)
+	{
+		switch (usage)
+		{
+		case GraphUsage::ColorAttachment: return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		case GraphUsage::DepthAttachment: return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		case GraphUsage::InputAttachment: return VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		case GraphUsage::SampledFragment:
+		case GraphUsage::SampledCompute: return VK_IMAGE_USAGE_SAMPLED_BIT;
+		case GraphUsage::StorageRead:
+		case GraphUsage::StorageWrite: return VK_IMAGE_USAGE_STORAGE_BIT;
+		case GraphUsage::TransferSrc: return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		case GraphUsage::TransferDst: return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		//Buffer usages don't add to the usage of images
+		case GraphUsage::VertexBuffer:
+		case GraphUsage::UniformBuffer: return 0;
+		}
+
+		return 0;
+	}
+
+	inline bool IsAttachment(const GraphUsage usage)
+	{
+		return usage == GraphUsage::ColorAttachment
+			   || usage == GraphUsage::DepthAttachment
+			   || usage == GraphUsage::InputAttachment;
+	}
+
+	inline bool HasWriteAccess(const VkAccessFlags access)
+	{
+		const VkAccessFlags writeMask = VK_ACCESS_SHADER_WRITE_BIT
+										| VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+										| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+										| VK_ACCESS_TRANSFER_WRITE_BIT
+										| VK_ACCESS_HOST_WRITE_BIT
+										| VK_ACCESS_MEMORY_WRITE_BIT;
+
+		return access & writeMask;
+	}
+
+	GraphResourceId FrameGraph::CreateImage(const std::string& name, const GraphImageInfo& info)
+	{
+		GraphResource resource;
+		resource.Name = name;
+		resource.ImageInfo = info;
+
+		Resources.push_back(resource);
+
+		return Resources.size() - 1;
+	}
+
+	GraphResourceId FrameGraph::ImportImage(const std::string& name, const GraphImageInfo& info,
+											const std::vector<VkImage>& images, const std::vector<VkImageView>& views,
+											const GraphResourceState& initialState,
+											const std::optional<GraphResourceState>& finalState)
+	{
+		GraphResource resource;
+		resource.Name = name;
+		resource.Imported = true;
+		resource.ImageInfo = info;
+		resource.Images = images;
+		resource.Views = views;
+		resource.InitialState = initialState;
+		resource.FinalState = finalState;
+
+		Resources.push_back(resource);
+
+		return Resources.size() - 1;
+	}
+
+	GraphResourceId FrameGraph::ImportBuffer(const std::string& name, const VkBuffer buffer, const GraphResourceState& initialState)
+	{
+		GraphResource resource;
+		resource.Name = name;
+		resource.Imported = true;
+		resource.IsBuffer = true;
+		resource.Buffer = buffer;
+		resource.InitialState = initialState;
+
+		Resources.push_back(resource);
+
+		return Resources.size() - 1;
+	}
+
+	GraphPassId FrameGraph::AddPass(const std::string& name, std::function<void(const VkCommandBuffer, const uint32_t)>&& execute,
+									const bool sideEffects)
+	{
+		GraphPass pass;
+		pass.Name = name;
+		pass.Execute = std::move(execute);
+		pass.SideEffects = sideEffects;
+
+		Passes.push_back(std::move(pass));
+
+		return Passes.size() - 1;
+	}
+
+	void FrameGraph::CullPasses()
+	{
+		//Walking backwards, a pass survives if it writes something visible outside the graph or read by a surviving pass
+		std::vector<bool> needed(Resources.size(), false);
+
+		for (auto p = Passes.rbegin(); p != Passes.rend(); ++p)
+		{
+			bool alive = p->SideEffects;
+
+			for (const auto& a : p->Accesses)
+			{
+				if (a.Write && (Resources[a.Resource].Imported || needed[a.Resource]))
+					alive = true;
+			}
+
+			p->Culled = !alive;
+
+			if (!alive)
+			{
+				LOGC("Frame graph pass %s is culled", p->Name.c_str());
+				continue;
+			}
+
+			for (const auto& a : p->Accesses)
+			{
+				if (!a.Write)
+					needed[a.Resource] = true;
+			}
+		}
+	}
+
+	void FrameGraph::GroupPasses()
+	{
+		int32_t leader = -1;
+		std::vector<bool> writtenInGroup(Resources.size(), false);
+
+		for (size_t i = 0; i < Passes.size(); ++i)
+		{
+			auto& p = Passes[i];
+
+			if (p.Culled)
+				continue;
+
+			std::optional<GraphResourceId> firstAttachment;
+
+			for (const auto& a : p.Accesses)
+			{
+				if (IsAttachment(a.Usage) && !firstAttachment)
+					firstAttachment = a.Resource;
+			}
+
+			//Everything the pass reads from the group has to be an attachment and the render area has to match
+			bool merge = MergeSubpasses && leader != -1 && firstAttachment;
+
+			for (const auto& a : p.Accesses)
+			{
+				if (merge && writtenInGroup[a.Resource] && !IsAttachment(a.Usage))
+					merge = false;
+			}
+
+			if (merge)
+			{
+				const auto& info = Resources[*firstAttachment].ImageInfo;
+				const auto& leaderExtent = Passes[leader].Extent;
+
+				merge = info.Width == leaderExtent.width && info.Height == leaderExtent.height;
+			}
+
+			if (merge)
+			{
+				p.Group = leader;
+				p.Subpass = Passes[leader].SubpassesCount++;
+			}
+			else
+			{
+				leader = firstAttachment ? (int32_t)i : -1;
+
+				p.Group = i;
+				p.Subpass = 0;
+				p.SubpassesCount = 1;
+
+				if (firstAttachment)
+				{
+					const auto& info = Resources[*firstAttachment].ImageInfo;
+					p.Extent = { info.Width, info.Height };
+				}
+
+				std::fill(writtenInGroup.begin(), writtenInGroup.end(), false);
+			}
+
+			for (const auto& a : p.Accesses)
+			{
+				if (a.Write)
+					writtenInGroup[a.Resource] = true;
+			}
+		}
+	}
+
+	void FrameGraph::ComputeLifetimes()
+	{
+		for (size_t i = 0; i < Passes.size(); ++i)
+		{
+			if (Passes[i].Culled)
+				continue;
+
+			for (const auto& a : Passes[i].Accesses)
+			{
+				auto& r = Resources[a.Resource];
+
+				if (r.FirstPass == -1)
+					r.FirstPass = i;
+
+				auto state = GetUsageState(a.Usage, a.Write);
+
+				r.LastPass = i;
+				r.LastStage = state.Stage;
+				r.LastAccess = state.Access;
+				r.UsageFlags |= GetUsageFlags(a.Usage);
+
+				if (!IsAttachment(a.Usage))
+					r.AttachmentOnly = false;
+			}
+		}
+	}
+
+	bool FrameGraph::AllocateTransients()
+	{
+		struct TransientInfo
+		{
+			GraphResourceId Id;
+			VkMemoryRequirements Requirements;
+		};
+
+		std::vector<TransientInfo> transients;
+
+		for (size_t i = 0; i < Resources.size(); ++i)
+		{
+			auto& r = Resources[i];
+
+			if (r.Imported || r.FirstPass == -1)
+				continue;
+
+			//Content never leaves a single render pass, so the memory may only exist on chip
+			r.Lazy = r.AttachmentOnly && Passes[r.FirstPass].Group == Passes[r.LastPass].Group;
+
+			if (r.Lazy)
+				r.UsageFlags |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+			VkImageCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			createInfo.imageType = VK_IMAGE_TYPE_2D;
+			createInfo.extent = { r.ImageInfo.Width, r.ImageInfo.Height, 1 };
+			createInfo.mipLevels = 1;
+			createInfo.arrayLayers = 1;
+			createInfo.format = r.ImageInfo.Format;
+			createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			createInfo.usage = r.UsageFlags;
+			createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+			VkImage image;
+			if (vkCreateImage(App->Device, &createInfo, nullptr, &image) != VK_SUCCESS)
+				return false;
+
+			r.Images = { image };
+
+			TransientInfo info;
+			info.Id = i;
+			vkGetImageMemoryRequirements(App->Device, image, &info.Requirements);
+
+			transients.push_back(info);
+		}
+
+		//Biggest images first, each one goes into the first block whose images live in other passes
+		std::sort(transients.begin(), transients.end(),
+			[](const TransientInfo& a, const TransientInfo& b)
+			{
+				return a.Requirements.size > b.Requirements.size;
+			});
+
+		for (const auto& t : transients)
+		{
+			const auto& r = Resources[t.Id];
+
+			auto fits = [&](const GraphMemoryBlock& block)
+			{
+				if (!(block.TypeBits & t.Requirements.memoryTypeBits) || block.Lazy != r.Lazy)
+					return false;
+
+				//Images of one render pass are alive together even if their passes don't overlap
+				for (auto other : block.Resources)
+				{
+					const auto& o = Resources[other];
+					if (Passes[r.FirstPass].Group <= Passes[o.LastPass].Group && Passes[o.FirstPass].Group <= Passes[r.LastPass].Group)
+						return false;
+				}
+
+				return true;
+			};
+
+			auto block = std::find_if(MemoryBlocks.begin(), MemoryBlocks.end(), fits);
+
+			if (block == MemoryBlocks.end())
+			{
+				MemoryBlocks.push_back({});
+				block = MemoryBlocks.end() - 1;
+				block->Lazy = r.Lazy;
+			}
+
+			block->Size = std::max(block->Size, t.Requirements.size);
+			block->TypeBits &= t.Requirements.memoryTypeBits;
+			block->Resources.push_back(t.Id);
+		}
+
+		for (auto& block : MemoryBlocks)
+		{
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = block.Size;
+			allocInfo.memoryTypeIndex = vk::FindMemoryType(*App, block.TypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			//Only tiled gpus usually expose lazily allocated memory
+			if (block.Lazy)
+			{
+				auto lazyType = vk::FindMemoryType(*App, block.TypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+																		  | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+				if (lazyType != -1)
+					allocInfo.memoryTypeIndex = lazyType;
+			}
+
+			if (vkAllocateMemory(App->Device, &allocInfo, nullptr, &block.Memory) != VK_SUCCESS)
+				return false;
+
+			//Image that takes over the memory has to wait for the one that used it before
+			std::sort(block.Resources.begin(), block.Resources.end(),
+				[this](const GraphResourceId a, const GraphResourceId b)
+				{
+					return Resources[a].FirstPass < Resources[b].FirstPass;
+				});
+
+			for (size_t i = 0; i < block.Resources.size(); ++i)
+			{
+				auto& r = Resources[block.Resources[i]];
+
+				vkBindImageMemory(App->Device, r.Images[0], block.Memory, 0);
+
+				auto& previous = Resources[block.Resources[i == 0 ? block.Resources.size() - 1 : i - 1]];
+				r.InitialState = { VK_IMAGE_LAYOUT_UNDEFINED, previous.LastAccess, previous.LastStage };
+
+				VkImageViewCreateInfo viewCreateInfo{};
+				viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewCreateInfo.image = r.Images[0];
+				viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewCreateInfo.format = r.ImageInfo.Format;
+				viewCreateInfo.subresourceRange.aspectMask = r.ImageInfo.Aspect;
+				viewCreateInfo.subresourceRange.baseMipLevel = 0;
+				viewCreateInfo.subresourceRange.levelCount = 1;
+				viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+				viewCreateInfo.subresourceRange.layerCount = 1;
+
+				VkImageView view;
+				if (vkCreateImageView(App->Device, &viewCreateInfo, nullptr, &view) != VK_SUCCESS)
+					return false;
+
+				r.Views = { view };
+			}
+		}
+
+		return true;
+	}
+
+	void FrameGraph::ComputeBarriers()
+	{
+		std::vector<GraphResourceState> states(Resources.size());
+		for (size_t i = 0; i < Resources.size(); ++i)
+			states[i] = Resources[i].InitialState;
+
+		for (auto& p : Passes)
+		{
+			if (p.Culled)
+				continue;
+
+			for (const auto& a : p.Accesses)
+			{
+				auto& current = states[a.Resource];
+				auto target = GetUsageState(a.Usage, a.Write);
+
+				bool layoutChange = !Resources[a.Resource].IsBuffer && current.Layout != target.Layout;
+				bool hazard = HasWriteAccess(current.Access) || (a.Write && current.Access != 0);
+
+				//Reads of the same layout after a barrier don't need another one, just extend the state
+				if (!layoutChange && !hazard && !a.Write)
+				{
+					current.Access |= target.Access;
+					current.Stage |= target.Stage;
+					continue;
+				}
+
+				p.Barriers.push_back({ a.Resource, current, target });
+				current = target;
+			}
+		}
+
+		for (size_t i = 0; i < Resources.size(); ++i)
+		{
+			const auto& r = Resources[i];
+
+			if (r.FirstPass != -1 && r.FinalState)
+				FinalBarriers.push_back({ (GraphResourceId)i, states[i], *r.FinalState });
+		}
+	}
+
+	bool FrameGraph::CreateRenderPasses()
+	{
+		for (size_t i = 0; i < Passes.size(); ++i)
+		{
+			auto& leader = Passes[i];
+
+			if (leader.Culled || leader.Group != i)
+				continue;
+
+			std::vector<GraphPass*> members;
+			for (size_t j = i; j < Passes.size(); ++j)
+			{
+				if (!Passes[j].Culled && Passes[j].Group == i)
+					members.push_back(&Passes[j]);
+			}
+
+			std::vector<GraphResourceId> attachmentResources;
+			std::vector<VkAttachmentDescription> attachments;
+			std::vector<bool> attachmentWritten;
+
+			std::vector<std::vector<VkAttachmentReference>> colorRefs(members.size());
+			std::vector<std::vector<VkAttachmentReference>> inputRefs(members.size());
+			std::vector<std::optional<VkAttachmentReference>> depthRefs(members.size());
+
+			for (size_t s = 0; s < members.size(); ++s)
+			{
+				for (const auto& a : members[s]->Accesses)
+				{
+					if (!IsAttachment(a.Usage))
+						continue;
+
+					const auto& r = Resources[a.Resource];
+					auto layout = GetUsageState(a.Usage, a.Write).Layout;
+
+					auto found = std::find(attachmentResources.begin(), attachmentResources.end(), a.Resource);
+					uint32_t index = found - attachmentResources.begin();
+
+					if (found == attachmentResources.end())
+					{
+						bool hasContent = r.FirstPass < (int32_t)i || (r.Imported && r.InitialState.Layout != VK_IMAGE_LAYOUT_UNDEFINED);
+
+						VkAttachmentDescription attachment{};
+						attachment.format = r.ImageInfo.Format;
+						attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+						attachment.loadOp = a.Clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+													: (hasContent ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+						attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+						attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+						//Layout before the render pass is set by the graph barriers
+						attachment.initialLayout = layout;
+
+						attachmentResources.push_back(a.Resource);
+						attachments.push_back(attachment);
+						attachmentWritten.push_back(false);
+
+						leader.ClearValues.push_back(a.Clear ? *a.Clear : VkClearValue{});
+					}
+
+					//Transitions between subpasses are done by the render pass itself
+					attachments[index].finalLayout = layout;
+					attachmentWritten[index] = attachmentWritten[index] || a.Write;
+
+					VkAttachmentReference ref{};
+					ref.attachment = index;
+					ref.layout = layout;
+
+					if (a.Usage == GraphUsage::DepthAttachment)
+						depthRefs[s] = ref;
+					else if (a.Usage == GraphUsage::InputAttachment)
+						inputRefs[s].push_back(ref);
+					else
+						colorRefs[s].push_back(ref);
+				}
+			}
+
+			if (attachments.empty())
+				continue;
+
+			const int32_t lastPass = members.back() - Passes.data();
+
+			for (size_t a = 0; a < attachments.size(); ++a)
+			{
+				const auto& r = Resources[attachmentResources[a]];
+				bool contentUsedLater = r.LastPass > lastPass || r.Imported;
+
+				attachments[a].storeOp = contentUsedLater && attachmentWritten[a] ? VK_ATTACHMENT_STORE_OP_STORE
+																				   : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			}
+
+			std::vector<VkSubpassDescription> subpasses(members.size());
+
+			for (size_t s = 0; s < members.size(); ++s)
+			{
+				subpasses[s].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+				subpasses[s].colorAttachmentCount = colorRefs[s].size();
+				subpasses[s].pColorAttachments = colorRefs[s].data();
+				subpasses[s].inputAttachmentCount = inputRefs[s].size();
+				subpasses[s].pInputAttachments = inputRefs[s].data();
+				subpasses[s].pDepthStencilAttachment = depthRefs[s] ? &*depthRefs[s] : nullptr;
+			}
+
+			//Barriers on attachments used by an earlier subpass become subpass dependencies,
+			//the rest can't be recorded inside the render pass and are moved in front of it
+			std::vector<std::optional<uint32_t>> lastSubpassUse(Resources.size());
+			std::vector<VkSubpassDependency> dependencies;
+
+			for (size_t s = 0; s < members.size(); ++s)
+			{
+				auto& p = *members[s];
+
+				if (s > 0)
+				{
+					for (const auto& b : p.Barriers)
+					{
+						if (!lastSubpassUse[b.Resource])
+						{
+							leader.Barriers.push_back(b);
+							continue;
+						}
+
+						VkSubpassDependency dependency{};
+						dependency.srcSubpass = *lastSubpassUse[b.Resource];
+						dependency.dstSubpass = s;
+						dependency.srcStageMask = b.Src.Stage;
+						dependency.dstStageMask = b.Dst.Stage;
+						dependency.srcAccessMask = HasWriteAccess(b.Src.Access) ? b.Src.Access : 0;
+						dependency.dstAccessMask = b.Dst.Access;
+						dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+						dependencies.push_back(dependency);
+					}
+
+					p.Barriers.clear();
+				}
+
+				for (const auto& a : p.Accesses)
+					lastSubpassUse[a.Resource] = s;
+			}
+
+			ASSERT(attachments.size() <= MaxGraphAttachments, "Too many attachments in one render pass!");
+
+			auto rpCreateRes = vk::CreateRenderPass(*App, attachments, subpasses, dependencies);
+			if (!rpCreateRes)
+				return false;
+
+			leader.RenderPass = *rpCreateRes;
+			leader.Attachments = attachmentResources;
+
+			if (!CreateFramebuffers(leader))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool FrameGraph::CreateFramebuffers(GraphPass& leader)
+	{
+		if (App->Features.ImagelessFramebuffer)
+		{
+			std::vector<VkFramebufferAttachmentImageInfo> infos;
+
+			for (auto r : leader.Attachments)
+			{
+				const auto& resource = Resources[r];
+
+				VkFramebufferAttachmentImageInfo info{};
+				info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENT_IMAGE_INFO;
+				info.usage = resource.Imported && resource.ImageInfo.Usage ? resource.ImageInfo.Usage : resource.UsageFlags;
+				info.width = resource.ImageInfo.Width;
+				info.height = resource.ImageInfo.Height;
+				info.layerCount = 1;
+				info.viewFormatCount = 1;
+				info.pViewFormats = &resource.ImageInfo.Format;
+
+				infos.push_back(info);
+			}
+
+			auto fboRes = vk::CreateImagelessFramebuffer(*App, leader.RenderPass, infos, leader.Extent.width, leader.Extent.height);
+			if (!fboRes)
+				return false;
+
+			leader.Framebuffers.push_back(*fboRes);
+
+			return true;
+		}
+
+		size_t framebuffersCount = 1;
+		for (auto r : leader.Attachments)
+			framebuffersCount = std::max(framebuffersCount, Resources[r].Views.size());
+
+		for (size_t f = 0; f < framebuffersCount; ++f)
+		{
+			std::vector<VkImageView> views;
+			for (auto r : leader.Attachments)
+				views.push_back(GetImageView(r, f));
+
+			auto fboRes = vk::CreateFramebuffer(*App, leader.RenderPass, views, leader.Extent.width, leader.Extent.height);
+			if (!fboRes)
+				return false;
+
+			leader.Framebuffers.push_back(*fboRes);
+		}
+
+		return true;
+	}
+
+	bool FrameGraph::Compile()
+	{
+		CullPasses();
+		GroupPasses();
+		ComputeLifetimes();
+
+		if (!AllocateTransients())
+			return false;
+
+		ComputeBarriers();
+
+		return CreateRenderPasses();
+	}
+
+	void FrameGraph::EmitBarriers(const VkCommandBuffer commandBuffer, const std::vector<GraphBarrier>& barriers, const uint32_t slot)
+	{
+		if (barriers.empty())
+			return;
+
+		//Every barrier keeps its own stages instead of merging them into one pair for the whole batch
+		if (App->Features.Synchronization2)
+		{
+			ImageBarriers2.clear();
+			MemoryBarriers2.clear();
+
+			for (const auto& b : barriers)
+			{
+				const auto& r = Resources[b.Resource];
+
+				VkAccessFlags srcAccess = HasWriteAccess(b.Src.Access) ? b.Src.Access : 0;
+
+				if (r.IsBuffer)
+				{
+					VkMemoryBarrier2KHR barrier{};
+					barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+					barrier.srcStageMask = b.Src.Stage;
+					barrier.srcAccessMask = srcAccess;
+					barrier.dstStageMask = b.Dst.Stage;
+					barrier.dstAccessMask = b.Dst.Access;
+
+					MemoryBarriers2.push_back(barrier);
+					continue;
+				}
+
+				VkImageMemoryBarrier2KHR barrier{};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+				barrier.srcStageMask = b.Src.Stage;
+				barrier.srcAccessMask = srcAccess;
+				barrier.dstStageMask = b.Dst.Stage;
+				barrier.dstAccessMask = b.Dst.Access;
+				barrier.oldLayout = b.Src.Layout;
+				barrier.newLayout = b.Dst.Layout;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = r.Images[slot % r.Images.size()];
+				barrier.subresourceRange.aspectMask = r.ImageInfo.Aspect;
+				barrier.subresourceRange.baseMipLevel = 0;
+				barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+				barrier.subresourceRange.baseArrayLayer = 0;
+				barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+				ImageBarriers2.push_back(barrier);
+			}
+
+			VkDependencyInfoKHR dependency{};
+			dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+			dependency.memoryBarrierCount = MemoryBarriers2.size();
+			dependency.pMemoryBarriers = MemoryBarriers2.data();
+			dependency.imageMemoryBarrierCount = ImageBarriers2.size();
+			dependency.pImageMemoryBarriers = ImageBarriers2.data();
+
+			vk::CmdPipelineBarrier2(*App, commandBuffer, dependency);
+
+			return;
+		}
+
+		ImageBarriers.clear();
+
+		VkMemoryBarrier memoryBarrier{};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+		VkPipelineStageFlags srcStage = 0;
+		VkPipelineStageFlags dstStage = 0;
+
+		for (const auto& b : barriers)
+		{
+			const auto& r = Resources[b.Resource];
+
+			srcStage |= b.Src.Stage;
+			dstStage |= b.Dst.Stage;
+
+			if (r.IsBuffer)
+			{
+				memoryBarrier.srcAccessMask |= b.Src.Access;
+				memoryBarrier.dstAccessMask |= b.Dst.Access;
+				continue;
+			}
+
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = b.Src.Layout;
+			barrier.newLayout = b.Dst.Layout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = r.Images[slot % r.Images.size()];
+			barrier.subresourceRange.aspectMask = r.ImageInfo.Aspect;
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			barrier.srcAccessMask = HasWriteAccess(b.Src.Access) ? b.Src.Access : 0;
+			barrier.dstAccessMask = b.Dst.Access;
+
+			ImageBarriers.push_back(barrier);
+		}
+
+		bool hasMemoryBarrier = memoryBarrier.srcAccessMask != 0 || memoryBarrier.dstAccessMask != 0;
+
+		vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0,
+							 hasMemoryBarrier ? 1 : 0, &memoryBarrier, 0, nullptr,
+							 ImageBarriers.size(), ImageBarriers.data());
+	}
+
+	void FrameGraph::Execute(const VkCommandBuffer commandBuffer, const uint32_t slot)
+	{
+		for (const auto& p : Passes)
+		{
+			if (p.Culled)
+				continue;
+
+			const auto& leader = Passes[p.Group];
+
+			uint32_t scope = Profiler ? Profiler->Begin(commandBuffer, p.Name.c_str()) : UINT32_MAX;
+
+			if (leader.RenderPass == VK_NULL_HANDLE)
+			{
+				EmitBarriers(commandBuffer, p.Barriers, slot);
+				p.Execute(commandBuffer, slot);
+
+				if (Profiler)
+					Profiler->End(commandBuffer, scope);
+
+				continue;
+			}
+
+			if (p.Subpass == 0)
+			{
+				EmitBarriers(commandBuffer, p.Barriers, slot);
+
+				VkRenderPassBeginInfo renderPassInfo{};
+				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				renderPassInfo.renderPass = leader.RenderPass;
+				renderPassInfo.framebuffer = leader.Framebuffers[slot % leader.Framebuffers.size()];
+				renderPassInfo.renderArea.offset = { 0, 0 };
+				renderPassInfo.renderArea.extent = leader.Extent;
+				renderPassInfo.clearValueCount = leader.ClearValues.size();
+				renderPassInfo.pClearValues = leader.ClearValues.data();
+
+				VkImageView views[MaxGraphAttachments];
+				for (size_t a = 0; a < leader.Attachments.size(); ++a)
+					views[a] = GetImageView(leader.Attachments[a], slot);
+
+				VkRenderPassAttachmentBeginInfo attachmentsInfo{};
+				attachmentsInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_ATTACHMENT_BEGIN_INFO;
+				attachmentsInfo.attachmentCount = leader.Attachments.size();
+				attachmentsInfo.pAttachments = views;
+
+				if (App->Features.ImagelessFramebuffer)
+					renderPassInfo.pNext = &attachmentsInfo;
+
+				vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+				//Pipelines take viewport and scissor as dynamic state, so they don't depend on the render size
+				VkViewport viewport{};
+				viewport.width = (float)leader.Extent.width;
+				viewport.height = (float)leader.Extent.height;
+				viewport.minDepth = 0.0f;
+				viewport.maxDepth = 1.0f;
+
+				VkRect2D scissor{};
+				scissor.extent = leader.Extent;
+
+				vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+				vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+			}
+			else
+			{
+				vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+			}
+
+			p.Execute(commandBuffer, slot);
+
+			if (p.Subpass + 1 == leader.SubpassesCount)
+				vkCmdEndRenderPass(commandBuffer);
+
+			if (Profiler)
+				Profiler->End(commandBuffer, scope);
+		}
+
+		EmitBarriers(commandBuffer, FinalBarriers, slot);
+	}
+
+	void FrameGraph::DestroyTransients()
+	{
+		for (auto& r : Resources)
+		{
+			if (r.Imported)
+				continue;
+
+			for (const auto& v : r.Views)
+				vkDestroyImageView(App->Device, v, nullptr);
+
+			for (const auto& i : r.Images)
+				vkDestroyImage(App->Device, i, nullptr);
+
+			r.Views.clear();
+			r.Images.clear();
+		}
+
+		for (const auto& b : MemoryBlocks)
+			vkFreeMemory(App->Device, b.Memory, nullptr);
+
+		MemoryBlocks.clear();
+	}
+
+	void FrameGraph::Cleanup()
+	{
+		for (const auto& p : Passes)
+		{
+			for (const auto& fbo : p.Framebuffers)
+				vkDestroyFramebuffer(App->Device, fbo, nullptr);
+
+			if (p.RenderPass != VK_NULL_HANDLE)
+				vkDestroyRenderPass(App->Device, p.RenderPass, nullptr);
+		}
+
+		DestroyTransients();
+
+		Passes.clear();
+		Resources.clear();
+		FinalBarriers.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+#pragma once
+#include "vrender.h"
+#include "vulkan/vulkan_app.h"
+#include "vulkan/gpu_profiler.h"
+
+#include <optional>
+#include <functional>
+
+namespace render
+{
+	using GraphResourceId = uint32_t;
+	using GraphPassId = uint32_t;
+
+	constexpr uint32_t MaxGraphAttachments = 8;
+
+	enum class GraphUsage
+	{
+		ColorAttachment,
+		DepthAttachment,
+		InputAttachment,
+		SampledFragment,
+		SampledCompute,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+		VertexBuffer,
+		UniformBuffer
+	};
+
+	struct GraphResourceState
+	{
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkAccessFlags Access = 0;
+		VkPipelineStageFlags Stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	};
+
+	struct GraphImageInfo
+	{
+		uint32_t Width;
+		uint32_t Height;
+		VkFormat Format;
+		VkImageAspectFlags Aspect;
+
+		//Usage imported images were created with, imageless framebuffers have to match it
+		VkImageUsageFlags Usage = 0;
+	};
+
+	struct GraphResource
+	{
+		std::string Name;
+
+		bool IsBuffer = false;
+		bool Imported = false;
+
+		GraphImageInfo ImageInfo;
+		VkImageUsageFlags UsageFlags = 0;
+
+		//Imported images may have a handle per swapchain image, transient ones always have one
+		std::vector<VkImage> Images;
+		std::vector<VkImageView> Views;
+		VkBuffer Buffer = VK_NULL_HANDLE;
+
+		GraphResourceState InitialState;
+		std::optional<GraphResourceState> FinalState;
+
+		int32_t FirstPass = -1;
+		int32_t LastPass = -1;
+		VkPipelineStageFlags LastStage = 0;
+		VkAccessFlags LastAccess = 0;
+
+		//Never sampled or used outside of render passes, may live in lazily allocated memory
+		bool AttachmentOnly = true;
+		bool Lazy = false;
+	};
+
+	struct GraphAccess
+	{
+		GraphResourceId Resource;
+		GraphUsage Usage;
+		bool Write;
+
+		std::optional<VkClearValue> Clear;
+	};
+
+	struct GraphBarrier
+	{
+		GraphResourceId Resource;
+		GraphResourceState Src;
+		GraphResourceState Dst;
+	};
+
+	struct GraphPass
+	{
+		std::string Name;
+
+		std::vector<GraphAccess> Accesses;
+		std::function<void(const VkCommandBuffer, const uint32_t)> Execute;
+
+		//Pass is never culled even if nothing reads its output
+		bool SideEffects = false;
+
+		bool Culled = false;
+
+		//Merged passes become subpasses of the render pass owned by the first pass of the group
+		uint32_t Group = 0;
+		uint32_t Subpass = 0;
+		uint32_t SubpassesCount = 1;
+
+		std::vector<GraphBarrier> Barriers;
+
+		VkRenderPass RenderPass = VK_NULL_HANDLE;
+		std::vector<GraphResourceId> Attachments;
+		//Single imageless framebuffer when the device supports it, otherwise one per slot
+		std::vector<VkFramebuffer> Framebuffers;
+		std::vector<VkClearValue> ClearValues;
+		VkExtent2D Extent;
+	};
+
+	struct GraphMemoryBlock
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Size = 0;
+		uint32_t TypeBits = UINT32_MAX;
+		bool Lazy = false;
+
+		std::vector<GraphResourceId> Resources;
+	};
+
+	//Passes declare what they read and write, compilation culls passes nobody depends on, creates render passes,
+	//places transient images with disjoint lifetimes into shared memory and computes the barriers between passes
+	class FrameGraph
+	{
+	private:
+		std::vector<GraphResource> Resources;
+		std::vector<GraphPass> Passes;
+
+		std::vector<GraphMemoryBlock> MemoryBlocks;
+		std::vector<GraphBarrier> FinalBarriers;
+
+		//Reused by every barrier batch, so recording doesn't allocate once they've grown
+		std::vector<VkImageMemoryBarrier2KHR> ImageBarriers2;
+		std::vector<VkMemoryBarrier2KHR> MemoryBarriers2;
+		std::vector<VkImageMemoryBarrier> ImageBarriers;
+
+		bool MergeSubpasses = false;
+
+		vk::GpuProfiler* Profiler = nullptr;
+
+		vk::VulkanApp* App;
+
+		void CullPasses();
+		void GroupPasses();
+		void ComputeLifetimes();
+
+		[[nodiscard]]
+		bool AllocateTransients();
+
+		void ComputeBarriers();
+
+		[[nodiscard]]
+		bool CreateRenderPasses();
+
+		[[nodiscard]]
+		bool CreateFramebuffers(GraphPass& leader);
+
+		void DestroyTransients();
+
+		void EmitBarriers(const VkCommandBuffer commandBuffer, const std::vector<GraphBarrier>& barriers, const uint32_t slot);
+	public:
+		//With merging consecutive raster passes that only read each other's output as input attachments
+		//share one render pass, so the intermediate attachments can stay in tile memory
+		inline void Setup(vk::VulkanApp& app, const bool mergeSubpasses = false)
+		{
+			App = &app;
+			MergeSubpasses = mergeSubpasses;
+		}
+
+		//Every executed pass gets a scope named after it
+		inline void SetProfiler(vk::GpuProfiler* profiler)
+		{
+			Profiler = profiler;
+		}
+
+		void Cleanup();
+
+		GraphResourceId CreateImage(const std::string& name, const GraphImageInfo& info);
+
+		//Final state is applied after the last pass, e.g. present layout for swapchain images
+		GraphResourceId ImportImage(const std::string& name, const GraphImageInfo& info,
+									const std::vector<VkImage>& images, const std::vector<VkImageView>& views,
+									const GraphResourceState& initialState,
+									const std::optional<GraphResourceState>& finalState = std::nullopt);
+
+		GraphResourceId ImportBuffer(const std::string& name, const VkBuffer buffer, const GraphResourceState& initialState);
+
+		GraphPassId AddPass(const std::string& name, std::function<void(const VkCommandBuffer, const uint32_t)>&& execute,
+							const bool sideEffects = false);
+
+		inline void Read(const GraphPassId pass, const GraphResourceId resource, const GraphUsage usage)
+		{
+			Passes[pass].Accesses.push_back({ resource, usage, false, std::nullopt });
+		}
+
+		//Attachments with a clear value are cleared, others keep their content only if an earlier pass wrote it
+		inline void Write(const GraphPassId pass, const GraphResourceId resource, const GraphUsage usage,
+						  const std::optional<VkClearValue>& clear = std::nullopt)
+		{
+			Passes[pass].Accesses.push_back({ resource, usage, true, clear });
+		}
+
+		[[nodiscard]]
+		bool Compile();
+
+		//Slot picks the handle of imported resources with several images
+		void Execute(const VkCommandBuffer commandBuffer, const uint32_t slot);
+
+		inline VkRenderPass GetRenderPass(const GraphPassId pass) const
+		{
+			return Passes[Passes[pass].Group].RenderPass;
+		}
+
+		inline uint32_t GetSubpass(const GraphPassId pass) const
+		{
+			return Passes[pass].Subpass;
+		}
+
+		inline bool IsCulled(const GraphPassId pass) const
+		{
+			return Passes[pass].Culled;
+		}
+
+		inline VkImageView GetImageView(const GraphResourceId resource, const uint32_t slot = 0) const
+		{
+			const auto& views = Resources[resource].Views;
+			return views[slot % views.size()];
+		}
+
+		inline size_t GetMemoryBlocksCount() const
+		{
+			return MemoryBlocks.size();
+		}
+	};
+}
\ No newline at end of file
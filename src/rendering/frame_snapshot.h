@@ -0,0 +1,72 @@
+#pragma once
+#include "vrender.h"
+
+namespace render
+{
+	struct PointLightSnapshot
+	{
+		glm::vec3 Position;
+		glm::vec3 Color;
+	};
+
+	struct SpotlightSnapshot
+	{
+		glm::vec3 Position;
+		glm::vec3 Direction;
+		glm::vec3 Color;
+		float OuterAngle;
+		float InnerAngle;
+	};
+
+	//Copy of everything the renderer reads from the scene, taken at the end of a simulation frame.
+	//The renderer never touches scene nodes, so the simulation can move on while the snapshot is drawn
+	struct FrameSnapshot
+	{
+		uint64_t Frame = 0;
+		//Steady clock nanoseconds of the capture, the renderer measures latency from it
+		uint64_t CaptureTime = 0;
+
+		glm::mat4 ToCamera;
+		glm::mat4 ToClip;
+		glm::vec4 CameraPosition;
+
+		//Indexed by registry mesh slot. Ids are the registry ones and zero for free slots, together with
+		//the versions they let the renderer skip unchanged meshes
+		std::vector<uint64_t> MeshIds;
+		std::vector<uint64_t> TransformVersions;
+		std::vector<glm::vec3> Positions;
+		std::vector<glm::vec3> Scales;
+		std::vector<glm::vec4> Rotations;
+		//Inside the camera frustum or never culled
+		std::vector<uint8_t> Visible;
+
+		//Material uniform data of every mesh, packed back to back
+		std::vector<size_t> MaterialOffsets;
+		std::vector<uint8_t> MaterialData;
+
+		std::vector<PointLightSnapshot> PointLights;
+		std::vector<SpotlightSnapshot> Spotlights;
+
+		//Resizes keep the capacity, so steady state captures don't allocate
+		inline void ResizeMeshes(const size_t count)
+		{
+			MeshIds.resize(count);
+			TransformVersions.resize(count);
+			Positions.resize(count);
+			Scales.resize(count);
+			Rotations.resize(count);
+			Visible.resize(count);
+			MaterialOffsets.resize(count + 1);
+		}
+
+		inline size_t GetMeshesCount() const
+		{
+			return MeshIds.size();
+		}
+
+		inline const uint8_t* GetMaterialData(const size_t mesh) const
+		{
+			return MaterialData.data() + MaterialOffsets[mesh];
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+#include "vrender.h"
+
+#include <cfloat>
+
+namespace scene
+{
+	//Axis aligned box, empty while Min is above Max
+	struct Aabb
+	{
+		glm::vec3 Min = glm::vec3(FLT_MAX);
+		glm::vec3 Max = glm::vec3(-FLT_MAX);
+
+		static inline Aabb FromPoints(const std::vector<glm::vec3>& points)
+		{
+			Aabb bounds;
+			for (const auto& p : points)
+				bounds.Extend(p);
+
+			return bounds;
+		}
+
+		inline bool IsEmpty() const
+		{
+			return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z;
+		}
+
+		inline void Extend(const glm::vec3& point)
+		{
+			Min = glm::min(Min, point);
+			Max = glm::max(Max, point);
+		}
+
+		inline void Extend(const Aabb& other)
+		{
+			Min = glm::min(Min, other.Min);
+			Max = glm::max(Max, other.Max);
+		}
+
+		inline glm::vec3 GetCenter() const
+		{
+			return (Min + Max) * 0.5f;
+		}
+
+		inline float GetSurfaceArea() const
+		{
+			if (IsEmpty())
+				return 0.0f;
+
+			glm::vec3 d = Max - Min;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		inline bool Overlaps(const Aabb& other) const
+		{
+			return Min.x <= other.Max.x && Max.x >= other.Min.x
+				&& Min.y <= other.Max.y && Max.y >= other.Min.y
+				&& Min.z <= other.Max.z && Max.z >= other.Min.z;
+		}
+
+		inline bool OverlapsSphere(const glm::vec3& center, const float radius) const
+		{
+			glm::vec3 d = center - glm::clamp(center, Min, Max);
+			return glm::dot(d, d) <= radius * radius;
+		}
+
+		//Slab test, distance is where the ray enters the box or zero when it starts inside
+		inline bool IntersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, const float maxDistance,
+								  float& distance) const
+		{
+			glm::vec3 t0 = (Min - origin) * inverseDirection;
+			glm::vec3 t1 = (Max - origin) * inverseDirection;
+
+			glm::vec3 entries = glm::min(t0, t1);
+			glm::vec3 exits = glm::max(t0, t1);
+
+			float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+			float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+
+			distance = enter;
+			return enter <= exit;
+		}
+
+		//Box around the transformed box, the matrix has to be affine
+		inline Aabb Transformed(const glm::mat4& transform) const
+		{
+			glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+			glm::vec3 extents = (Max - Min) * 0.5f;
+
+			glm::vec3 worldExtents = glm::abs(glm::vec3(transform[0])) * extents.x
+								   + glm::abs(glm::vec3(transform[1])) * extents.y
+								   + glm::abs(glm::vec3(transform[2])) * extents.z;
+
+			return { center - worldExtents, center + worldExtents };
+		}
+	};
+
+	//Planes point inwards, xyz is the normal and w the distance
+	struct Frustum
+	{
+		glm::vec4 Planes[6];
+
+		//Planes of a projection times view matrix. Extracted for a -1..1 depth range, which is
+		//conservative for 0..1 projections
+		static inline Frustum FromMatrix(const glm::mat4& m)
+		{
+			glm::vec4 rows[4];
+			for (int i = 0; i < 4; ++i)
+				rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+			Frustum f;
+			f.Planes[0] = rows[3] + rows[0];
+			f.Planes[1] = rows[3] - rows[0];
+			f.Planes[2] = rows[3] + rows[1];
+			f.Planes[3] = rows[3] - rows[1];
+			f.Planes[4] = rows[3] + rows[2];
+			f.Planes[5] = rows[3] - rows[2];
+
+			for (auto& p : f.Planes)
+				p /= glm::length(glm::vec3(p));
+
+			return f;
+		}
+
+		//Conservative, boxes near the corners may pass without touching the frustum
+		inline bool Overlaps(const Aabb& bounds) const
+		{
+			for (const auto& p : Planes)
+			{
+				//Corner furthest along the plane normal
+				glm::vec3 corner(p.x >= 0.0f ? bounds.Max.x : bounds.Min.x,
+								 p.y >= 0.0f ? bounds.Max.y : bounds.Min.y,
+								 p.z >= 0.0f ? bounds.Max.z : bounds.Min.z);
+
+				if (glm::dot(glm::vec3(p), corner) + p.w < 0.0f)
+					return false;
+			}
+
+			return true;
+		}
+	};
+}
\ No newline at end of file
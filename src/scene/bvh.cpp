@@ -0,0 +1,601 @@
+#include "bvh.h"
+
+#include <atomic>
+
+namespace scene
+{
+	void Bvh::ResizeSlots(const size_t count)
+	{
+		Meshes.resize(count, nullptr);
+		ItemLeaves.resize(count, UINT32_MAX);
+		WorldBounds.resize(count);
+		Centroids.resize(count);
+		TransformVersions.resize(count);
+	}
+
+	void Bvh::UpdateWorldBounds(const uint32_t mesh)
+	{
+		auto m = Meshes[mesh];
+
+		WorldBounds[mesh] = m->LocalBounds.Transformed(m->GetWorldMatrix());
+		Centroids[mesh] = WorldBounds[mesh].GetCenter();
+		TransformVersions[mesh] = m->GetTransformVersion();
+	}
+
+	std::optional<uint32_t> Bvh::Split(const BuildTask& task)
+	{
+		auto& node = Nodes[task.Node];
+
+		Aabb bounds;
+		Aabb centroids;
+
+		for (uint32_t i = task.Begin; i < task.End; ++i)
+		{
+			bounds.Extend(WorldBounds[Items[i]]);
+			centroids.Extend(Centroids[Items[i]]);
+		}
+
+		node.Bounds = bounds;
+
+		const uint32_t count = task.End - task.Begin;
+
+		auto makeLeaf = [&]() -> std::optional<uint32_t>
+		{
+			node.First = task.Begin;
+			node.Count = count;
+
+			LeafCapacities[task.Node] = count;
+
+			for (uint32_t i = task.Begin; i < task.End; ++i)
+				ItemLeaves[Items[i]] = task.Node;
+
+			return std::nullopt;
+		};
+
+		if (count <= 1 || task.Depth + 1 >= BvhMaxDepth)
+			return makeLeaf();
+
+		struct Bin
+		{
+			Aabb Bounds;
+			uint32_t Count = 0;
+		};
+
+		const glm::vec3 extent = centroids.Max - centroids.Min;
+
+		//Flat axes put everything in the first bin and are skipped
+		glm::vec3 binScale;
+		for (int axis = 0; axis < 3; ++axis)
+			binScale[axis] = extent[axis] > 0.0f ? BvhBinsCount / extent[axis] : 0.0f;
+
+		auto getBin = [&](const uint32_t item, const int axis)
+		{
+			float offset = (Centroids[item][axis] - centroids.Min[axis]) * binScale[axis];
+			return std::min(BvhBinsCount - 1, static_cast<uint32_t>(offset));
+		};
+
+		//All axes are binned in one pass over the items
+		Bin bins[3][BvhBinsCount];
+
+		for (uint32_t i = task.Begin; i < task.End; ++i)
+		{
+			uint32_t item = Items[i];
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				auto& bin = bins[axis][getBin(item, axis)];
+
+				bin.Bounds.Extend(WorldBounds[item]);
+				++bin.Count;
+			}
+		}
+
+		//Cheapest split after any bin of any axis, by area times items on both sides
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		uint32_t bestBin = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (extent[axis] <= 0.0f)
+				continue;
+
+			float rightCosts[BvhBinsCount];
+
+			Aabb right;
+			uint32_t rightCount = 0;
+
+			for (uint32_t b = BvhBinsCount - 1; b > 0; --b)
+			{
+				right.Extend(bins[axis][b].Bounds);
+				rightCount += bins[axis][b].Count;
+
+				rightCosts[b] = rightCount ? right.GetSurfaceArea() * rightCount : FLT_MAX;
+			}
+
+			Aabb left;
+			uint32_t leftCount = 0;
+
+			for (uint32_t b = 0; b + 1 < BvhBinsCount; ++b)
+			{
+				left.Extend(bins[axis][b].Bounds);
+				leftCount += bins[axis][b].Count;
+
+				if (!leftCount || rightCosts[b + 1] == FLT_MAX)
+					continue;
+
+				float cost = left.GetSurfaceArea() * leftCount + rightCosts[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b;
+				}
+			}
+		}
+
+		//Every centroid in the same place, only the count can split them
+		if (bestAxis < 0)
+		{
+			if (count <= BvhMaxLeafItems)
+				return makeLeaf();
+
+			return task.Begin + count / 2;
+		}
+
+		//Traversal step against testing every item
+		float area = bounds.GetSurfaceArea();
+		float splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+
+		if (count <= BvhMaxLeafItems && splitCost >= count)
+			return makeLeaf();
+
+		auto middle = std::partition(Items.begin() + task.Begin, Items.begin() + task.End,
+									 [&](const uint32_t item) { return getBin(item, bestAxis) <= bestBin; });
+
+		return static_cast<uint32_t>(middle - Items.begin());
+	}
+
+	void Bvh::BuildSubtree(Subtree& subtree)
+	{
+		std::vector<BuildTask> stack = { subtree.Task };
+
+		subtree.NodesEnd = subtree.NodesBegin;
+
+		while (!stack.empty())
+		{
+			auto task = stack.back();
+			stack.pop_back();
+
+			auto split = Split(task);
+			if (!split)
+				continue;
+
+			uint32_t left = subtree.NodesEnd;
+			subtree.NodesEnd += 2;
+
+			Nodes[task.Node].First = left;
+			Nodes[task.Node].Count = Node::Internal;
+
+			stack.push_back({ left, task.Begin, *split, task.Depth + 1 });
+			stack.push_back({ left + 1, *split, task.End, task.Depth + 1 });
+		}
+	}
+
+	float Bvh::RefitNodes(const uint32_t begin, const uint32_t end)
+	{
+		float cost = 0.0f;
+
+		for (uint32_t i = end; i-- > begin;)
+		{
+			auto& node = Nodes[i];
+
+			if (!node.IsLeaf())
+			{
+				node.Bounds = Nodes[node.First].Bounds;
+				node.Bounds.Extend(Nodes[node.First + 1].Bounds);
+
+				cost += node.Bounds.GetSurfaceArea();
+				continue;
+			}
+
+			node.Bounds = {};
+			for (uint32_t j = node.First; j < node.First + node.Count; ++j)
+				node.Bounds.Extend(WorldBounds[Items[j]]);
+
+			cost += node.Bounds.GetSurfaceArea() * node.Count;
+		}
+
+		return cost;
+	}
+
+	void Bvh::RefitAll(utils::JobSystem& jobs)
+	{
+		//Nodes split off by insertions first, their parents are leaves of the build and their children come after them
+		float insertedCost = RefitNodes(BuildNodesCount, Nodes.size());
+
+		auto refitSubtrees = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+				Subtrees[i].Cost = RefitNodes(Subtrees[i].NodesBegin, Subtrees[i].NodesEnd);
+		};
+
+		jobs.ParallelFor(Subtrees.size(), 1, refitSubtrees);
+
+		//Top nodes last, their lowest children are the subtree roots
+		float cost = insertedCost + RefitNodes(0, TopNodesCount);
+		for (const auto& s : Subtrees)
+			cost += s.Cost;
+
+		float rootArea = Nodes[0].Bounds.GetSurfaceArea();
+		Cost = rootArea > 0.0f ? cost / rootArea : 0.0f;
+	}
+
+	void Bvh::Build(const std::vector<MeshRenderable*>& meshes, utils::JobSystem& jobs)
+	{
+		PROFILE_ZONE("Bvh::Build");
+
+		Meshes = meshes;
+		ResizeSlots(Meshes.size());
+
+		auto computeBounds = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				if (Meshes[i])
+					UpdateWorldBounds(i);
+				else
+					WorldBounds[i] = {};
+			}
+		};
+
+		jobs.ParallelFor(Meshes.size(), BvhBoundsGrain, computeBounds);
+
+		Items.clear();
+		for (uint32_t i = 0; i < Meshes.size(); ++i)
+		{
+			if (Meshes[i])
+				Items.push_back(i);
+		}
+
+		const uint32_t count = Items.size();
+		ItemsCount = count;
+
+		Nodes.clear();
+		Subtrees.clear();
+		TopNodesCount = 0;
+		BuildNodesCount = 0;
+
+		Changed = false;
+
+		Cost = 0.0f;
+		BuildCost = 0.0f;
+
+		if (count == 0)
+			return;
+
+		//Upper bound, every leaf holds at least one item
+		Nodes.resize(2 * count - 1);
+		LeafCapacities.resize(Nodes.size());
+		BuildNodesCount = Nodes.size();
+
+		//Top levels are split breadth first until there are enough subtrees to keep the workers busy
+		std::vector<BuildTask> pending = { { 0, 0, count, 0 } };
+		TopNodesCount = 1;
+
+		size_t target = jobs.GetWorkersCount() * BvhSubtreesPerWorker;
+		size_t first = 0;
+
+		while (first < pending.size() && pending.size() - first < target)
+		{
+			auto task = pending[first++];
+
+			auto split = Split(task);
+			if (!split)
+				continue;
+
+			uint32_t left = TopNodesCount;
+			TopNodesCount += 2;
+
+			Nodes[task.Node].First = left;
+			Nodes[task.Node].Count = Node::Internal;
+
+			pending.push_back({ left, task.Begin, *split, task.Depth + 1 });
+			pending.push_back({ left + 1, *split, task.End, task.Depth + 1 });
+		}
+
+		//Each subtree gets room for the most nodes its items can need
+		uint32_t nodesBegin = TopNodesCount;
+
+		for (size_t i = first; i < pending.size(); ++i)
+		{
+			Subtrees.push_back({ pending[i], nodesBegin, nodesBegin, 0.0f });
+			nodesBegin += 2 * (pending[i].End - pending[i].Begin) - 2;
+		}
+
+		auto buildSubtrees = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+				BuildSubtree(Subtrees[i]);
+		};
+
+		jobs.ParallelFor(Subtrees.size(), 1, buildSubtrees);
+
+		RefitAll(jobs);
+		BuildCost = Cost;
+	}
+
+	bool Bvh::Refit(utils::JobSystem& jobs)
+	{
+		PROFILE_ZONE("Bvh::Refit");
+
+		std::atomic<bool> moved = false;
+
+		auto updateBounds = [&](uint32_t begin, uint32_t end)
+		{
+			bool any = false;
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				if (Meshes[i] && Meshes[i]->GetTransformVersion() != TransformVersions[i])
+				{
+					UpdateWorldBounds(i);
+					any = true;
+				}
+			}
+
+			if (any)
+				moved.store(true, std::memory_order_relaxed);
+		};
+
+		jobs.ParallelFor(Meshes.size(), BvhBoundsGrain, updateBounds);
+
+		if (!moved.load(std::memory_order_relaxed) && !Changed)
+			return false;
+
+		RefitAll(jobs);
+		Changed = false;
+
+		return true;
+	}
+
+	void Bvh::MoveLeaf(const uint32_t node, const uint32_t capacity)
+	{
+		auto& leaf = Nodes[node];
+
+		uint32_t first = Items.size();
+		Items.resize(first + capacity);
+
+		std::copy(Items.begin() + leaf.First, Items.begin() + leaf.First + leaf.Count, Items.begin() + first);
+
+		leaf.First = first;
+		LeafCapacities[node] = capacity;
+	}
+
+	void Bvh::SplitLeaf(const uint32_t node, const uint32_t item)
+	{
+		uint32_t items[BvhLeafCapacity + 1];
+		uint32_t count = 0;
+
+		Aabb centroids;
+
+		auto add = [&](const uint32_t i)
+		{
+			items[count++] = i;
+			centroids.Extend(Centroids[i]);
+		};
+
+		for (uint32_t i = Nodes[node].First; i < Nodes[node].First + Nodes[node].Count; ++i)
+			add(Items[i]);
+
+		add(item);
+
+		glm::vec3 extent = centroids.Max - centroids.Min;
+		int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+		uint32_t middle = count / 2;
+		std::nth_element(items, items + middle, items + count,
+						 [&](const uint32_t a, const uint32_t b) { return Centroids[a][axis] < Centroids[b][axis]; });
+
+		uint32_t left = Nodes.size();
+		Nodes.resize(left + 2);
+		LeafCapacities.resize(Nodes.size());
+
+		//Left leaf keeps the room of the split one, the right one gets new room
+		uint32_t firsts[2] = { Nodes[node].First, static_cast<uint32_t>(Items.size()) };
+		uint32_t ranges[3] = { 0, middle, count };
+
+		Items.resize(Items.size() + BvhLeafCapacity);
+
+		for (uint32_t c = 0; c < 2; ++c)
+		{
+			auto& child = Nodes[left + c];
+			child.First = firsts[c];
+			child.Count = 0;
+
+			LeafCapacities[left + c] = BvhLeafCapacity;
+
+			for (uint32_t i = ranges[c]; i < ranges[c + 1]; ++i)
+			{
+				Items[child.First + child.Count++] = items[i];
+				ItemLeaves[items[i]] = left + c;
+
+				child.Bounds.Extend(WorldBounds[items[i]]);
+			}
+		}
+
+		Nodes[node].First = left;
+		Nodes[node].Count = Node::Internal;
+	}
+
+	void Bvh::Insert(const uint32_t slot, MeshRenderable* mesh)
+	{
+		Remove(slot);
+
+		if (slot >= Meshes.size())
+			ResizeSlots(slot + 1);
+
+		Meshes[slot] = mesh;
+		UpdateWorldBounds(slot);
+
+		++ItemsCount;
+		Changed = true;
+
+		const auto& bounds = WorldBounds[slot];
+
+		//Empty build, the root is a leaf without room
+		if (Nodes.empty())
+		{
+			Nodes.resize(1);
+			LeafCapacities.assign(1, 0);
+
+			TopNodesCount = 1;
+			BuildNodesCount = 1;
+		}
+
+		uint32_t node = 0;
+		uint32_t depth = 0;
+
+		while (!Nodes[node].IsLeaf())
+		{
+			Nodes[node].Bounds.Extend(bounds);
+
+			//Child whose area grows least, the smaller one when both grow the same
+			uint32_t first = Nodes[node].First;
+
+			float areas[2];
+			float growths[2];
+
+			for (uint32_t c = 0; c < 2; ++c)
+			{
+				Aabb grown = Nodes[first + c].Bounds;
+				grown.Extend(bounds);
+
+				areas[c] = Nodes[first + c].Bounds.GetSurfaceArea();
+				growths[c] = grown.GetSurfaceArea() - areas[c];
+			}
+
+			bool right = growths[1] < growths[0] || (growths[1] == growths[0] && areas[1] < areas[0]);
+
+			node = first + (right ? 1 : 0);
+			++depth;
+		}
+
+		Nodes[node].Bounds.Extend(bounds);
+
+		uint32_t count = Nodes[node].Count;
+
+		if (count == LeafCapacities[node])
+		{
+			if (count == BvhLeafCapacity && depth + 1 < BvhMaxDepth)
+			{
+				SplitLeaf(node, slot);
+				return;
+			}
+
+			MoveLeaf(node, std::max(BvhLeafCapacity, 2 * count));
+		}
+
+		auto& leaf = Nodes[node];
+		Items[leaf.First + leaf.Count++] = slot;
+
+		ItemLeaves[slot] = node;
+	}
+
+	void Bvh::Remove(const uint32_t slot)
+	{
+		if (slot >= Meshes.size() || !Meshes[slot])
+			return;
+
+		//Swapped with the last item of the leaf
+		auto& leaf = Nodes[ItemLeaves[slot]];
+		uint32_t last = leaf.First + leaf.Count - 1;
+
+		for (uint32_t i = leaf.First; i <= last; ++i)
+		{
+			if (Items[i] == slot)
+			{
+				Items[i] = Items[last];
+				break;
+			}
+		}
+
+		--leaf.Count;
+
+		Meshes[slot] = nullptr;
+		WorldBounds[slot] = {};
+		ItemLeaves[slot] = UINT32_MAX;
+
+		--ItemsCount;
+		Changed = true;
+	}
+
+	std::optional<RayHit> Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance) const
+	{
+		if (Nodes.empty())
+			return std::nullopt;
+
+		const glm::vec3 inverseDirection = 1.0f / direction;
+
+		struct Entry
+		{
+			uint32_t Node;
+			float Distance;
+		};
+
+		Entry stack[BvhMaxDepth + 1];
+		uint32_t size = 0;
+
+		std::optional<RayHit> hit;
+		float nearest = maxDistance;
+
+		float distance;
+		if (Nodes[0].Bounds.IntersectsRay(origin, inverseDirection, nearest, distance))
+			stack[size++] = { 0, distance };
+
+		while (size > 0)
+		{
+			auto entry = stack[--size];
+
+			//Pushed before a nearer hit was found
+			if (entry.Distance > nearest)
+				continue;
+
+			const auto& node = Nodes[entry.Node];
+
+			if (!node.IsLeaf())
+			{
+				float distances[2];
+				bool hits[2];
+
+				for (uint32_t c = 0; c < 2; ++c)
+					hits[c] = Nodes[node.First + c].Bounds.IntersectsRay(origin, inverseDirection, nearest, distances[c]);
+
+				//Nearer child goes on top, so it's visited first
+				uint32_t nearer = distances[1] < distances[0] ? 1 : 0;
+
+				if (hits[1 - nearer])
+					stack[size++] = { node.First + 1 - nearer, distances[1 - nearer] };
+
+				if (hits[nearer])
+					stack[size++] = { node.First + nearer, distances[nearer] };
+
+				continue;
+			}
+
+			for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+			{
+				uint32_t item = Items[i];
+
+				if (WorldBounds[item].IntersectsRay(origin, inverseDirection, nearest, distance)
+					&& (!hit || distance < nearest))
+				{
+					nearest = distance;
+					hit = RayHit{ item, Meshes[item], distance };
+				}
+			}
+		}
+
+		return hit;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,245 @@
+#pragma once
+#include "vrender.h"
+
+#include "scene/bounds.h"
+#include "scene/scene_hi.h"
+
+#include "utils/job_system.h"
+
+#include <optional>
+
+namespace scene
+{
+	//Leaves with more items are split when the SAH finds it cheaper
+	constexpr uint32_t BvhMaxLeafItems = 4;
+
+	//Centroid bins split candidates are evaluated at, per axis
+	constexpr uint32_t BvhBinsCount = 16;
+
+	//Deeper nodes are always leaves, bounds the traversal stacks
+	constexpr uint32_t BvhMaxDepth = 64;
+
+	//Subtrees split off the top levels per worker before the build goes parallel
+	constexpr uint32_t BvhSubtreesPerWorker = 4;
+
+	//Items per job when world bounds are recomputed
+	constexpr uint32_t BvhBoundsGrain = 1024;
+
+	//Refitted SAH cost relative to the cost right after the build, past it the tree is rebuilt
+	constexpr float BvhRebuildCostRatio = 1.5f;
+
+	//Items a leaf makes room for once something is inserted into it, full ones are split in two
+	constexpr uint32_t BvhLeafCapacity = 8;
+
+	//Item room of the leaves relative to the items in them, past it the tree is rebuilt to reclaim the room
+	//emptied leaves hold
+	constexpr uint32_t BvhRebuildRoomRatio = 4;
+
+	struct RayHit
+	{
+		//Registry slot of the mesh
+		uint32_t Index;
+		MeshRenderable* Mesh;
+
+		float Distance;
+	};
+
+	//Bounding volume hierarchy over mesh world bounds, items are registry mesh slots. Built top down with a binned SAH,
+	//meshes added or removed afterwards are inserted into the leaf that grows least and swapped out of theirs.
+	//Refitted while the meshes move, until refitting and insertions degraded it enough to rebuild
+	class Bvh
+	{
+	private:
+		struct Node
+		{
+			//Count of internal nodes, leaves emptied by removals stay leaves
+			static constexpr uint32_t Internal = UINT32_MAX;
+
+			Aabb Bounds;
+
+			//Children of internal nodes are First and First + 1, leaves hold items [First, First + Count)
+			uint32_t First = 0;
+			uint32_t Count = 0;
+
+			inline bool IsLeaf() const
+			{
+				return Count != Internal;
+			}
+		};
+
+		//Items [Begin, End) left to place under the node
+		struct BuildTask
+		{
+			uint32_t Node;
+			uint32_t Begin;
+			uint32_t End;
+			uint32_t Depth;
+		};
+
+		//Nodes below a root built by one job. Children always come after their parents,
+		//so refitting walks the range backwards
+		struct Subtree
+		{
+			BuildTask Task;
+
+			uint32_t NodesBegin;
+			uint32_t NodesEnd;
+
+			float Cost;
+		};
+
+		std::vector<Node> Nodes;
+		//Nodes above the subtrees, built before the build goes parallel
+		uint32_t TopNodesCount = 0;
+		std::vector<Subtree> Subtrees;
+		//Nodes reserved by the build, ones split off by insertions come after them
+		uint32_t BuildNodesCount = 0;
+
+		//Indexed by slot, nullptr for slots without an item
+		std::vector<MeshRenderable*> Meshes;
+
+		//Slots in leaf order. Leaves an item was inserted into have room for more after their items
+		std::vector<uint32_t> Items;
+		uint32_t ItemsCount = 0;
+
+		//Item room of each leaf, indexed by node
+		std::vector<uint32_t> LeafCapacities;
+		//Leaf of each item, indexed by slot
+		std::vector<uint32_t> ItemLeaves;
+
+		std::vector<Aabb> WorldBounds;
+		std::vector<glm::vec3> Centroids;
+		std::vector<uint64_t> TransformVersions;
+
+		//Items were inserted or removed since the last refit
+		bool Changed = false;
+
+		float Cost = 0.0f;
+		float BuildCost = 0.0f;
+
+		void ResizeSlots(const size_t count);
+		void UpdateWorldBounds(const uint32_t mesh);
+
+		//Moves the leaf items to the end with room for the capacity, the room they had is only reclaimed by a build
+		void MoveLeaf(const uint32_t node, const uint32_t capacity);
+		//Splits the full leaf and the item at the median centroid of their widest axis into two new leaves
+		void SplitLeaf(const uint32_t node, const uint32_t item);
+
+		//Sets the node bounds and either makes it a leaf or partitions its items and returns the split
+		std::optional<uint32_t> Split(const BuildTask& task);
+
+		void BuildSubtree(Subtree& subtree);
+
+		//Recomputes bounds of nodes [begin, end) from their children and items, returns their summed SAH cost
+		float RefitNodes(const uint32_t begin, const uint32_t end);
+		void RefitAll(utils::JobSystem& jobs);
+
+		template<typename F>
+		inline void Query(const F& overlaps, std::vector<uint32_t>& result) const
+		{
+			result.clear();
+
+			if (Nodes.empty())
+				return;
+
+			uint32_t stack[BvhMaxDepth + 1];
+			uint32_t size = 0;
+
+			stack[size++] = 0;
+
+			while (size > 0)
+			{
+				const auto& node = Nodes[stack[--size]];
+
+				if (!overlaps(node.Bounds))
+					continue;
+
+				if (!node.IsLeaf())
+				{
+					stack[size++] = node.First;
+					stack[size++] = node.First + 1;
+					continue;
+				}
+
+				for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+				{
+					if (overlaps(WorldBounds[Items[i]]))
+						result.push_back(Items[i]);
+				}
+			}
+		}
+	public:
+		//Meshes are indexed by registry slot, nullptr for free slots. They have to stay alive until they are removed
+		//or the next build
+		void Build(const std::vector<MeshRenderable*>& meshes, utils::JobSystem& jobs);
+
+		//Replaces the item already in the slot. Bounds of the path down to its leaf grow right away,
+		//the next refit tightens them
+		void Insert(const uint32_t slot, MeshRenderable* mesh);
+
+		//Nothing happens for slots without an item. Bounds above its leaf stay loose until the next refit
+		void Remove(const uint32_t slot);
+
+		//Updates bounds of meshes that moved since the last refit, false when none did and no items changed
+		bool Refit(utils::JobSystem& jobs);
+
+		inline bool NeedsRebuild() const
+		{
+			return Cost > BuildCost * BvhRebuildCostRatio || Items.size() > BvhRebuildRoomRatio * (ItemsCount + BvhLeafCapacity);
+		}
+
+		//Queries replace the result with the slots of the items
+		inline void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const
+		{
+			Query([&](const Aabb& b) { return frustum.Overlaps(b); }, result);
+		}
+
+		inline void QueryOverlap(const Aabb& bounds, std::vector<uint32_t>& result) const
+		{
+			Query([&](const Aabb& b) { return bounds.Overlaps(b); }, result);
+		}
+
+		inline void QuerySphere(const glm::vec3& center, const float radius, std::vector<uint32_t>& result) const
+		{
+			Query([&](const Aabb& b) { return b.OverlapsSphere(center, radius); }, result);
+		}
+
+		//Nearest mesh whose world bounds the ray hits, direction doesn't need to be normalized
+		//but the distance is measured in its lengths
+		std::optional<RayHit> Raycast(const glm::vec3& origin, const glm::vec3& direction,
+									  const float maxDistance = FLT_MAX) const;
+
+		//nullptr for slots without an item
+		inline MeshRenderable* GetMesh(const uint32_t slot) const
+		{
+			return Meshes[slot];
+		}
+
+		//Empty for slots without an item
+		inline const Aabb& GetWorldBounds(const uint32_t slot) const
+		{
+			return WorldBounds[slot];
+		}
+
+		inline size_t GetSlotsCount() const
+		{
+			return Meshes.size();
+		}
+
+		inline uint32_t GetItemsCount() const
+		{
+			return ItemsCount;
+		}
+
+		//SAH cost relative to the root, compare with the cost after the build to judge the quality
+		inline float GetCost() const
+		{
+			return Cost;
+		}
+
+		inline float GetBuildCost() const
+		{
+			return BuildCost;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include "scene_file.h"
+
+#include <fstream>
+
+namespace scene
+{
+	template<typename T>
+	bool SceneFile::MapSection(const SceneFileSection& section, SceneFileArray<T>& records) const
+	{
+		uint64_t size = File.GetSize();
+
+		if (section.Offset % alignof(T) != 0 || section.Offset > size || section.Count > (size - section.Offset) / sizeof(T))
+			return false;
+
+		records = { reinterpret_cast<const T*>(File.GetData() + section.Offset), static_cast<size_t>(section.Count) };
+
+		return true;
+	}
+
+	bool SceneFile::Open(const std::string& path)
+	{
+		PROFILE_ZONE("SceneFile::Open");
+
+		Nodes = {};
+		Meshes = {};
+		PointLights = {};
+		Spotlights = {};
+		MeshNames = {};
+		MaterialNames = {};
+		Characters = {};
+
+		if (!File.Open(path))
+		{
+			LOGE("Couldn't map scene file %s!", path.c_str());
+			return false;
+		}
+
+		if (File.GetSize() < sizeof(SceneFileHeader))
+		{
+			LOGE("Scene file %s is too small for the header!", path.c_str());
+			return false;
+		}
+
+		const auto& header = *reinterpret_cast<const SceneFileHeader*>(File.GetData());
+
+		if (header.Magic != SceneFileMagic || header.Version != SceneFileVersion)
+		{
+			LOGE("%s isn't a version %d scene file!", path.c_str(), SceneFileVersion);
+			return false;
+		}
+
+		if (!MapSection(header.Nodes, Nodes) || !MapSection(header.Meshes, Meshes)
+			|| !MapSection(header.PointLights, PointLights) || !MapSection(header.Spotlights, Spotlights)
+			|| !MapSection(header.MeshNames, MeshNames) || !MapSection(header.MaterialNames, MaterialNames)
+			|| !MapSection(header.Characters, Characters))
+		{
+			LOGE("Scene file %s sections don't fit in it!", path.c_str());
+			return false;
+		}
+
+		if (Nodes.size() == 0)
+		{
+			LOGE("Scene file %s has no root!", path.c_str());
+			return false;
+		}
+
+		//Names are few, unlike the nodes, so they are checked once here
+		for (const auto& names : { MeshNames, MaterialNames })
+		{
+			for (const auto& n : names)
+			{
+				if (static_cast<uint64_t>(n.Offset) + n.Length > Characters.size())
+				{
+					LOGE("Scene file %s names don't fit in it!", path.c_str());
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool LoadedScene::Load(const std::string& path, const MaterialLibrary& materials)
+	{
+		PROFILE_ZONE("LoadedScene::Load");
+
+		if (Root.GetRegistry())
+		{
+			LOGE("Can't load a scene over one that is still registered!");
+			return false;
+		}
+
+		Store.Clear();
+
+		Root = Node();
+
+		SceneFile file;
+		if (!file.Open(path))
+			return false;
+
+		const auto& nodes = file.GetNodes();
+		const auto& meshes = file.GetMeshes();
+		const auto& pointLights = file.GetPointLights();
+		const auto& spotlights = file.GetSpotlights();
+
+		if (nodes.size() > HandleIndexMask)
+		{
+			LOGE("Scene file %s nodes exceed the node pool capacity!", path.c_str());
+			return false;
+		}
+
+		//Resolved once and copied to every mesh using them
+		std::vector<utils::HashString> meshNames;
+		meshNames.reserve(file.GetMeshNamesCount());
+
+		for (size_t i = 0; i < file.GetMeshNamesCount(); ++i)
+			meshNames.emplace_back(std::string(file.GetMeshName(i)));
+
+		std::vector<std::shared_ptr<render::BaseMaterial>> meshMaterials;
+		meshMaterials.reserve(file.GetMaterialNamesCount());
+
+		for (size_t i = 0; i < file.GetMaterialNamesCount(); ++i)
+		{
+			std::string name(file.GetMaterialName(i));
+
+			auto material = materials.Find(name);
+			if (!material)
+			{
+				LOGE("Scene file %s uses material %s which isn't in the library!", path.c_str(), name.c_str());
+				return false;
+			}
+
+			meshMaterials.push_back(material);
+		}
+
+		//Pools get their chunks up front, so creating the nodes doesn't allocate. Counts of a corrupted file
+		//can't make them reserve more than the nodes need
+		const size_t typedCount = meshes.size() + pointLights.size() + spotlights.size();
+
+		Store.GetPool<Node>().Reserve(nodes.size() - 1 - std::min(typedCount, nodes.size() - 1));
+		Store.GetPool<MeshRenderable>().Reserve(std::min(meshes.size(), nodes.size()));
+		Store.GetPool<PointLight>().Reserve(std::min(pointLights.size(), nodes.size()));
+		Store.GetPool<Spotlight>().Reserve(std::min(spotlights.size(), nodes.size()));
+
+		auto corrupted = [&](const size_t record)
+		{
+			LOGE("Scene file %s node %d is corrupted!", path.c_str(), static_cast<int>(record));
+
+			Store.Clear();
+			Root = Node();
+
+			return false;
+		};
+
+		//Instantiated nodes by record, parents always come before their children
+		std::vector<Node*> instances(nodes.size());
+
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			const auto& record = nodes[i];
+
+			Node* node = nullptr;
+
+			if (i == 0)
+			{
+				node = &Root;
+			}
+			else if (record.Parent >= i)
+			{
+				return corrupted(i);
+			}
+			else if (record.Type == SceneFileNodeType::Node)
+			{
+				node = Store.Get(Store.Create<Node>());
+			}
+			else if (record.Type == SceneFileNodeType::MeshRenderable)
+			{
+				if (record.Payload >= meshes.size())
+					return corrupted(i);
+
+				const auto& m = meshes[record.Payload];
+				if (m.Mesh >= meshNames.size() || m.Material >= meshMaterials.size())
+					return corrupted(i);
+
+				auto mesh = Store.Get(Store.Create<MeshRenderable>());
+				mesh->Mesh = meshNames[m.Mesh];
+				mesh->Material = meshMaterials[m.Material];
+				mesh->Render.DepthCompareOp = static_cast<VkCompareOp>(m.DepthCompareOp);
+				mesh->Render.FacesCullMode = m.FacesCullMode;
+				mesh->Render.FrustumCulled = m.FrustumCulled != 0;
+
+				node = mesh;
+			}
+			else if (record.Type == SceneFileNodeType::PointLight)
+			{
+				if (record.Payload >= pointLights.size())
+					return corrupted(i);
+
+				auto light = Store.Get(Store.Create<PointLight>());
+				light->Color = pointLights[record.Payload].Color;
+
+				node = light;
+			}
+			else if (record.Type == SceneFileNodeType::Spotlight)
+			{
+				if (record.Payload >= spotlights.size())
+					return corrupted(i);
+
+				const auto& s = spotlights[record.Payload];
+
+				auto light = Store.Get(Store.Create<Spotlight>());
+				light->Color = s.Color;
+				light->OuterAngle = s.OuterAngle;
+				light->InnerAngle = s.InnerAngle;
+
+				node = light;
+			}
+			else
+			{
+				return corrupted(i);
+			}
+
+			node->SetPosition(record.Position);
+			node->SetScale(record.Scale);
+			node->SetRotation(record.Rotation);
+
+			if (i > 0)
+				instances[record.Parent]->AttachChild(node);
+
+			instances[i] = node;
+		}
+
+		return true;
+	}
+
+	bool WriteSceneFile(const std::string& path, const Node& root, const MaterialLibrary& materials)
+	{
+		PROFILE_ZONE("WriteSceneFile");
+
+		std::vector<SceneFileNode> nodes;
+		std::vector<SceneFileMesh> meshes;
+		std::vector<SceneFilePointLight> pointLights;
+		std::vector<SceneFileSpotlight> spotlights;
+
+		std::vector<SceneFileString> meshNames;
+		std::vector<SceneFileString> materialNames;
+		std::string characters;
+
+		std::unordered_map<std::string, uint32_t> meshIds;
+		std::unordered_map<const render::BaseMaterial*, uint32_t> materialIds;
+
+		auto addName = [&](std::vector<SceneFileString>& names, const std::string& name)
+		{
+			names.push_back({ static_cast<uint32_t>(characters.size()), static_cast<uint32_t>(name.size()) });
+			characters += name;
+
+			return static_cast<uint32_t>(names.size() - 1);
+		};
+
+		//Breadth first, so parents are written before their children and siblings keep their order
+		std::vector<const Node*> order = { &root };
+		std::vector<uint32_t> parents = { UINT32_MAX };
+
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			const Node* node = order[i];
+
+			SceneFileNode record{};
+			record.Position = node->GetPosition();
+			record.Scale = node->GetScale();
+			record.Rotation = node->GetRotation();
+			record.Parent = parents[i];
+			record.Type = SceneFileNodeType::Node;
+
+			//The loader instantiates the root as a plain node
+			if (i == 0)
+			{
+				if (dynamic_cast<const MeshRenderable*>(node) || dynamic_cast<const PointLight*>(node))
+					LOGW("Scene root is saved as a plain node!");
+			}
+			else if (auto s = dynamic_cast<const Spotlight*>(node))
+			{
+				record.Type = SceneFileNodeType::Spotlight;
+				record.Payload = static_cast<uint32_t>(spotlights.size());
+
+				spotlights.push_back({ s->Color, s->OuterAngle, s->InnerAngle });
+			}
+			else if (auto l = dynamic_cast<const PointLight*>(node))
+			{
+				record.Type = SceneFileNodeType::PointLight;
+				record.Payload = static_cast<uint32_t>(pointLights.size());
+
+				pointLights.push_back({ l->Color });
+			}
+			else if (auto m = dynamic_cast<const MeshRenderable*>(node))
+			{
+				std::string meshPath = m->Mesh.GetString();
+				if (meshPath.empty())
+				{
+					LOGE("Can't save a mesh without its path!");
+					return false;
+				}
+
+				const std::string* materialName = m->Material ? materials.FindName(m->Material.get()) : nullptr;
+				if (!materialName)
+				{
+					LOGE("Can't save mesh %s, its material isn't in the library!", meshPath.c_str());
+					return false;
+				}
+
+				auto meshId = meshIds.find(meshPath);
+				if (meshId == meshIds.end())
+					meshId = meshIds.emplace(meshPath, addName(meshNames, meshPath)).first;
+
+				auto materialId = materialIds.find(m->Material.get());
+				if (materialId == materialIds.end())
+					materialId = materialIds.emplace(m->Material.get(), addName(materialNames, *materialName)).first;
+
+				record.Type = SceneFileNodeType::MeshRenderable;
+				record.Payload = static_cast<uint32_t>(meshes.size());
+
+				meshes.push_back({ meshId->second, materialId->second, static_cast<uint32_t>(m->Render.DepthCompareOp),
+								   static_cast<uint32_t>(m->Render.FacesCullMode), m->Render.FrustumCulled ? 1u : 0u });
+			}
+
+			nodes.push_back(record);
+
+			for (const Node* c = node->GetFirstChild(); c; c = c->GetNextSibling())
+			{
+				order.push_back(c);
+				parents.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		if (nodes.size() > HandleIndexMask || characters.size() > UINT32_MAX)
+		{
+			LOGE("Scene is too big for a scene file!");
+			return false;
+		}
+
+		SceneFileHeader header{};
+		header.Magic = SceneFileMagic;
+		header.Version = SceneFileVersion;
+
+		//Sections follow the header in declaration order, each one aligned
+		uint64_t offset = sizeof(SceneFileHeader);
+
+		auto place = [&](SceneFileSection& section, const size_t count, const size_t stride)
+		{
+			offset = (offset + SceneFileAlignment - 1) / SceneFileAlignment * SceneFileAlignment;
+
+			section = { offset, count };
+			offset += count * stride;
+		};
+
+		place(header.Nodes, nodes.size(), sizeof(SceneFileNode));
+		place(header.Meshes, meshes.size(), sizeof(SceneFileMesh));
+		place(header.PointLights, pointLights.size(), sizeof(SceneFilePointLight));
+		place(header.Spotlights, spotlights.size(), sizeof(SceneFileSpotlight));
+		place(header.MeshNames, meshNames.size(), sizeof(SceneFileString));
+		place(header.MaterialNames, materialNames.size(), sizeof(SceneFileString));
+		place(header.Characters, characters.size(), sizeof(char));
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOGE("Couldn't create scene file %s!", path.c_str());
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		uint64_t written = sizeof(header);
+
+		auto write = [&](const SceneFileSection& section, const void* data, const size_t size)
+		{
+			static const char padding[SceneFileAlignment] = {};
+			file.write(padding, section.Offset - written);
+
+			file.write(static_cast<const char*>(data), size);
+			written = section.Offset + size;
+		};
+
+		write(header.Nodes, nodes.data(), nodes.size() * sizeof(SceneFileNode));
+		write(header.Meshes, meshes.data(), meshes.size() * sizeof(SceneFileMesh));
+		write(header.PointLights, pointLights.data(), pointLights.size() * sizeof(SceneFilePointLight));
+		write(header.Spotlights, spotlights.data(), spotlights.size() * sizeof(SceneFileSpotlight));
+		write(header.MeshNames, meshNames.data(), meshNames.size() * sizeof(SceneFileString));
+		write(header.MaterialNames, materialNames.data(), materialNames.size() * sizeof(SceneFileString));
+		write(header.Characters, characters.data(), characters.size());
+
+		if (!file.good())
+		{
+			LOGE("Couldn't write scene file %s!", path.c_str());
+			return false;
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#pragma once
+#include "vrender.h"
+
+#include "scene/scene_hi.h"
+#include "scene/scene_store.h"
+
+#include "utils/mapped_file.h"
+
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace scene
+{
+	//"VRSC" read as a little endian uint32, files are little endian like every platform the engine runs on
+	constexpr uint32_t SceneFileMagic = 0x43535256;
+
+	//Bumped on every layout change, files of other versions are rejected
+	constexpr uint32_t SceneFileVersion = 1;
+
+	//Sections start at multiples of it, enough for every record type
+	constexpr uint64_t SceneFileAlignment = 8;
+
+	enum class SceneFileNodeType : uint32_t
+	{
+		Node,
+		MeshRenderable,
+		PointLight,
+		Spotlight
+	};
+
+	//Records are used in place from the mapped file, so they only hold fixed size types and refer to each other by index
+	struct SceneFileNode
+	{
+		glm::vec3 Position;
+		glm::vec3 Scale;
+		glm::vec4 Rotation;
+
+		//Always below the index of the node itself, UINT32_MAX for the root which is the first record
+		uint32_t Parent;
+
+		SceneFileNodeType Type;
+		//Index into the records of the type, unused for plain nodes
+		uint32_t Payload;
+	};
+
+	struct SceneFileMesh
+	{
+		//Indices into the mesh and material names
+		uint32_t Mesh;
+		uint32_t Material;
+
+		uint32_t DepthCompareOp;
+		uint32_t FacesCullMode;
+		uint32_t FrustumCulled;
+	};
+
+	struct SceneFilePointLight
+	{
+		glm::vec3 Color;
+	};
+
+	struct SceneFileSpotlight
+	{
+		glm::vec3 Color;
+
+		float OuterAngle;
+		float InnerAngle;
+	};
+
+	//Characters [Offset, Offset + Length) of the characters section, not null terminated
+	struct SceneFileString
+	{
+		uint32_t Offset;
+		uint32_t Length;
+	};
+
+	//Records array at a byte offset from the start of the file
+	struct SceneFileSection
+	{
+		uint64_t Offset;
+		uint64_t Count;
+	};
+
+	struct SceneFileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+
+		SceneFileSection Nodes;
+		SceneFileSection Meshes;
+		SceneFileSection PointLights;
+		SceneFileSection Spotlights;
+
+		SceneFileSection MeshNames;
+		SceneFileSection MaterialNames;
+		SceneFileSection Characters;
+	};
+
+	static_assert(std::is_trivially_copyable_v<SceneFileNode> && sizeof(SceneFileNode) == 52);
+	static_assert(std::is_trivially_copyable_v<SceneFileMesh> && sizeof(SceneFileMesh) == 20);
+	static_assert(std::is_trivially_copyable_v<SceneFileSpotlight> && sizeof(SceneFileSpotlight) == 20);
+	static_assert(std::is_trivially_copyable_v<SceneFileHeader> && sizeof(SceneFileHeader) == 120);
+
+	//Records of one section inside the mapping
+	template<typename T>
+	class SceneFileArray
+	{
+	private:
+		const T* Data = nullptr;
+		size_t Count = 0;
+	public:
+		SceneFileArray() = default;
+
+		inline SceneFileArray(const T* data, const size_t count)
+			: Data(data), Count(count) {}
+
+		inline const T& operator[](const size_t index) const
+		{
+			return Data[index];
+		}
+
+		inline const T* begin() const
+		{
+			return Data;
+		}
+
+		inline const T* end() const
+		{
+			return Data + Count;
+		}
+
+		inline size_t size() const
+		{
+			return Count;
+		}
+	};
+
+	//Scene files refer to materials by name, the same library resolves the names on load and provides them on save
+	class MaterialLibrary
+	{
+	private:
+		std::unordered_map<std::string, std::shared_ptr<render::BaseMaterial>> Materials;
+		std::unordered_map<const render::BaseMaterial*, std::string> Names;
+	public:
+		//Replaces the material previously added under the name
+		inline void Add(const std::string& name, const std::shared_ptr<render::BaseMaterial>& material)
+		{
+			auto previous = Materials.find(name);
+			if (previous != Materials.end())
+				Names.erase(previous->second.get());
+
+			Materials[name] = material;
+			Names[material.get()] = name;
+		}
+
+		//nullptr when no material was added under the name
+		inline std::shared_ptr<render::BaseMaterial> Find(const std::string& name) const
+		{
+			auto findRes = Materials.find(name);
+			return findRes != Materials.end() ? findRes->second : nullptr;
+		}
+
+		//nullptr when the material wasn't added
+		inline const std::string* FindName(const render::BaseMaterial* material) const
+		{
+			auto findRes = Names.find(material);
+			return findRes != Names.end() ? &findRes->second : nullptr;
+		}
+	};
+
+	//Memory mapped scene file. Opening checks the header and that every section fits the file, records are
+	//read in place afterwards without parsing or copying them
+	class SceneFile
+	{
+	private:
+		utils::MappedFile File;
+
+		SceneFileArray<SceneFileNode> Nodes;
+		SceneFileArray<SceneFileMesh> Meshes;
+		SceneFileArray<SceneFilePointLight> PointLights;
+		SceneFileArray<SceneFileSpotlight> Spotlights;
+
+		SceneFileArray<SceneFileString> MeshNames;
+		SceneFileArray<SceneFileString> MaterialNames;
+		SceneFileArray<char> Characters;
+
+		//Turns the section offset into a pointer, false when it's misaligned or runs past the end of the file
+		template<typename T>
+		bool MapSection(const SceneFileSection& section, SceneFileArray<T>& records) const;
+	public:
+		bool Open(const std::string& path);
+
+		inline const SceneFileArray<SceneFileNode>& GetNodes() const
+		{
+			return Nodes;
+		}
+
+		inline const SceneFileArray<SceneFileMesh>& GetMeshes() const
+		{
+			return Meshes;
+		}
+
+		inline const SceneFileArray<SceneFilePointLight>& GetPointLights() const
+		{
+			return PointLights;
+		}
+
+		inline const SceneFileArray<SceneFileSpotlight>& GetSpotlights() const
+		{
+			return Spotlights;
+		}
+
+		inline size_t GetMeshNamesCount() const
+		{
+			return MeshNames.size();
+		}
+
+		inline std::string_view GetMeshName(const size_t index) const
+		{
+			return { Characters.begin() + MeshNames[index].Offset, MeshNames[index].Length };
+		}
+
+		inline size_t GetMaterialNamesCount() const
+		{
+			return MaterialNames.size();
+		}
+
+		inline std::string_view GetMaterialName(const size_t index) const
+		{
+			return { Characters.begin() + MaterialNames[index].Offset, MaterialNames[index].Length };
+		}
+	};
+
+	//Node hierarchy instantiated from a scene file, owns every node of it so it has to outlive the scene manager
+	//using its root
+	class LoadedScene
+	{
+	private:
+		Node Root;
+
+		//Declared after the root, so pooled nodes are detached from it before it goes away
+		SceneStore Store;
+	public:
+		//Replaces the previous scene. Fails without a scene when a material isn't in the library
+		//or the file is corrupted
+		bool Load(const std::string& path, const MaterialLibrary& materials);
+
+		inline Node& GetRoot()
+		{
+			return Root;
+		}
+
+		inline size_t GetNodesCount() const
+		{
+			return 1 + Store.GetNodesCount();
+		}
+
+		//Every node besides the root is pooled in it
+		inline SceneStore& GetStore()
+		{
+			return Store;
+		}
+
+		inline size_t GetMemoryUsage() const
+		{
+			return sizeof(LoadedScene) + Store.GetMemoryUsage();
+		}
+	};
+
+	//Saves the node and everything under it, the node becomes the root of the file. Materials have to be in
+	//the library and meshes need their path, node types the format doesn't know are saved as plain nodes
+	bool WriteSceneFile(const std::string& path, const Node& root, const MaterialLibrary& materials);
+}
\ No newline at end of file
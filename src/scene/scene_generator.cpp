@@ -0,0 +1,122 @@
+#include "scene_generator.h"
+
+#include "managers/render_manager.h"
+
+namespace scene
+{
+	bool GeneratedScene::Generate(const GeneratorSettings& settings)
+	{
+		PROFILE_ZONE("GeneratedScene::Generate");
+
+		if (settings.Meshes.empty() || settings.Materials.empty())
+		{
+			LOGE("Scene generator needs at least one mesh and one material!");
+			return false;
+		}
+
+		if (settings.Depth > 0 && settings.Branching == 0)
+		{
+			LOGE("Scene generator branching has to be positive!");
+			return false;
+		}
+
+		if (settings.PointLightsCount > manager::MaxPointLights || settings.SpotlightsCount > manager::MaxSpotlights)
+		{
+			LOGE("Scene generator lights exceed the %d point lights or %d spotlights limit!",
+				 manager::MaxPointLights, manager::MaxSpotlights);
+			return false;
+		}
+
+		//Count groups level by level, stop before there are more leaves than meshes
+		std::vector<size_t> levelSizes = { 1 };
+		size_t groupsCount = 0;
+
+		for (uint32_t i = 0; i < settings.Depth; ++i)
+		{
+			size_t size = levelSizes.back() * settings.Branching;
+			if (size > settings.MeshesCount)
+			{
+				LOGE("Scene generator hierarchy has more leaf groups than meshes!");
+				return false;
+			}
+
+			levelSizes.push_back(size);
+			groupsCount += size;
+		}
+
+		if (groupsCount >= HandleIndexMask || settings.MeshesCount >= HandleIndexMask)
+		{
+			LOGE("Scene generator nodes exceed the node pool capacity!");
+			return false;
+		}
+
+		if (Root.GetRegistry())
+		{
+			LOGE("Scene generator can't regenerate a scene that is still registered!");
+			return false;
+		}
+
+		Random.seed(settings.Seed);
+
+		Store.Clear();
+
+		Root = Node();
+
+		//Groups only get a small offset so meshes stay roughly inside the extent at any depth
+		const float groupOffset = settings.Depth > 0 ? settings.Extent * 0.1f / settings.Depth : 0.0f;
+
+		std::vector<Node*> parents = { &Root };
+
+		for (uint32_t i = 1; i < levelSizes.size(); ++i)
+		{
+			std::vector<Node*> level(levelSizes[i]);
+
+			for (size_t j = 0; j < level.size(); ++j)
+			{
+				auto& g = *Store.Get(Store.Create<Node>());
+				g.SetPosition(RandomPosition(groupOffset));
+
+				parents[j / settings.Branching]->AttachChild(&g);
+				level[j] = &g;
+			}
+
+			parents = std::move(level);
+		}
+
+		//Leaf groups get the meshes round robin, so every leaf has at least one
+		for (uint32_t i = 0; i < settings.MeshesCount; ++i)
+		{
+			auto& m = *Store.Get(Store.Create<MeshRenderable>());
+			m.Mesh = settings.Meshes[RandomIndex(settings.Meshes.size())];
+			m.Material = settings.Materials[RandomIndex(settings.Materials.size())];
+			m.SetPosition(RandomPosition(settings.Extent));
+			m.SetScale(glm::vec3(RandomFloat(settings.MinScale, settings.MaxScale)));
+
+			parents[i % parents.size()]->AttachChild(&m);
+		}
+
+		for (uint32_t i = 0; i < settings.PointLightsCount; ++i)
+		{
+			auto& l = *Store.Get(Store.Create<PointLight>());
+			l.SetPosition(RandomPosition(settings.Extent));
+			l.Color = glm::vec3(RandomFloat(0.0f, 1.0f), RandomFloat(0.0f, 1.0f), RandomFloat(0.0f, 1.0f)) * 250.0f;
+
+			Root.AttachChild(&l);
+		}
+
+		for (uint32_t i = 0; i < settings.SpotlightsCount; ++i)
+		{
+			auto& l = *Store.Get(Store.Create<Spotlight>());
+			l.SetPosition(RandomPosition(settings.Extent));
+			l.Color = glm::vec3(RandomFloat(0.0f, 1.0f), RandomFloat(0.0f, 1.0f), RandomFloat(0.0f, 1.0f)) * 250.0f;
+			l.SetRotation({ glm::normalize(RandomPosition(1.0f) + glm::vec3(0.0f, -2.0f, 0.0f)), 0.0f });
+
+			l.OuterAngle = RandomFloat(glm::radians(20.0f), glm::radians(45.0f));
+			l.InnerAngle = l.OuterAngle * 0.8f;
+
+			Root.AttachChild(&l);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include "vrender.h"
+
+#include "scene/scene_hi.h"
+#include "scene/scene_store.h"
+
+#include <random>
+
+namespace scene
+{
+	struct GeneratorSettings
+	{
+		uint64_t Seed = 0;
+
+		uint32_t MeshesCount = 1000;
+
+		//Levels of group nodes between the root and the meshes, each group has Branching childs.
+		//Depth 0 attaches every mesh to the root, Branching 1 builds a single chain
+		uint32_t Depth = 4;
+		uint32_t Branching = 4;
+
+		//Picked uniformly for every mesh
+		std::vector<utils::HashString> Meshes;
+		std::vector<std::shared_ptr<render::BaseMaterial>> Materials;
+
+		uint32_t PointLightsCount = 4;
+		uint32_t SpotlightsCount = 0;
+
+		//Half size of the cube meshes and lights are scattered in
+		float Extent = 50.0f;
+		float MinScale = 0.5f;
+		float MaxScale = 1.5f;
+	};
+
+	//Builds a deterministic node hierarchy for scaling benchmarks and owns every node of it,
+	//so it has to outlive the scene manager using its root
+	class GeneratedScene
+	{
+	private:
+		Node Root;
+
+		//Declared after the root, so pooled nodes are detached from it before it goes away
+		SceneStore Store;
+
+		//mt19937_64 output is fixed by the standard unlike the std distributions
+		std::mt19937_64 Random;
+
+		inline float RandomFloat(const float min, const float max)
+		{
+			return min + (max - min) * static_cast<float>((Random() >> 11) * 0x1.0p-53);
+		}
+
+		inline size_t RandomIndex(const size_t count)
+		{
+			return Random() % count;
+		}
+
+		inline glm::vec3 RandomPosition(const float extent)
+		{
+			return { RandomFloat(-extent, extent), RandomFloat(-extent, extent), RandomFloat(-extent, extent) };
+		}
+	public:
+		bool Generate(const GeneratorSettings& settings);
+
+		inline Node& GetRoot()
+		{
+			return Root;
+		}
+
+		inline size_t GetMeshesCount() const
+		{
+			return Store.GetPool<MeshRenderable>().GetCount();
+		}
+
+		inline size_t GetNodesCount() const
+		{
+			return 1 + Store.GetNodesCount();
+		}
+	};
+}
\ No newline at end of file
@@ -3,85 +3,315 @@
 
 #include "managers/asset_manager.h"
 #include "rendering/material.h"
+#include "scene/bounds.h"
 
 #include <type_traits>
 
 namespace scene
 {
-    inline size_t GlobalObjectCounter = 0;
+    class MeshRenderable;
+    class PointLight;
+    class Spotlight;
+    class ComponentRegistry;
     
+    //Pooled nodes are referenced through generational handles, see SceneStore
     class Object
     {
-    private:
-        size_t Handle = GlobalObjectCounter++;
     public:
         virtual ~Object() {}
-
-        inline size_t GetHandle() const
-        {
-            return Handle;
-        }
     };
 
     class Spatial : public Object
     {
-    public:
+    protected:
         glm::vec3 Position = glm::vec3(0.0f);
         glm::vec3 Scale = glm::vec3(1.0f);
         glm::vec4 Rotation = { glm::vec3(1.0f), 0.0f };
+
+        virtual void OnTransformChanged() {}
+    public:
+        inline void SetPosition(const glm::vec3& position)
+        {
+            Position = position;
+            OnTransformChanged();
+        }
+
+        inline void SetScale(const glm::vec3& scale)
+        {
+            Scale = scale;
+            OnTransformChanged();
+        }
+
+        //Axis in xyz, angle in w
+        inline void SetRotation(const glm::vec4& rotation)
+        {
+            Rotation = rotation;
+            OnTransformChanged();
+        }
+
+        inline const glm::vec3& GetPosition() const
+        {
+            return Position;
+        }
+
+        inline const glm::vec3& GetScale() const
+        {
+            return Scale;
+        }
+
+        inline const glm::vec4& GetRotation() const
+        {
+            return Rotation;
+        }
     };
 
 	class Node : public Spatial
 	{
+        friend class ComponentRegistry;
 	private:
         Node* Parent = nullptr;
-		std::unordered_map<size_t, Node*> Childs;
-	public:
-        inline void SetParent(Node* node)
+
+        //Children are an intrusive list in attach order, walking it touches no other memory
+        Node* FirstChild = nullptr;
+        Node* LastChild = nullptr;
+        Node* PreviousSibling = nullptr;
+        Node* NextSibling = nullptr;
+
+        ComponentRegistry* Registry = nullptr;
+        //Position in the registry array of the node type, the stable slot for meshes
+        size_t RegistryIndex = SIZE_MAX;
+
+        //Cached by UpdateTransforms, the world values don't compose as matrices so each one is kept
+        glm::vec3 WorldPosition = glm::vec3(0.0f);
+        glm::vec3 WorldScale = glm::vec3(1.0f);
+        glm::vec4 WorldRotation = { glm::vec3(1.0f), 0.0f };
+
+        //Bumped on every recompute, so users of the world transform can skip unchanged nodes
+        uint64_t TransformVersion = 0;
+
+        bool TransformDirty = true;
+        //Set on every ancestor of a dirty node, lets the update skip clean subtrees
+        bool ChildTransformDirty = false;
+
+        inline void MarkChildTransformDirty()
+        {
+            for (Node* n = this; n && !n->ChildTransformDirty; n = n->Parent)
+                n->ChildTransformDirty = true;
+        }
+
+        inline void MarkTransformDirty()
+        {
+            TransformDirty = true;
+
+            if (Parent)
+                Parent->MarkChildTransformDirty();
+        }
+
+        inline void ComputeWorldTransform()
+        {
+            if (Parent)
+            {
+                WorldPosition = Parent->WorldPosition + Position;
+                WorldScale = Parent->WorldScale * Scale;
+
+                auto w = Parent->WorldRotation;
+                WorldRotation = glm::vec4(glm::vec3(w) * glm::vec3(Rotation), w.w + Rotation.w);
+            }
+            else
+            {
+                WorldPosition = Position;
+                WorldScale = Scale;
+                WorldRotation = Rotation;
+            }
+
+            ++TransformVersion;
+        }
+
+        inline void LinkChild(Node* node)
         {
-           Parent = node;
+            node->Parent = this;
+            node->PreviousSibling = LastChild;
+            node->NextSibling = nullptr;
+
+            if (LastChild)
+                LastChild->NextSibling = node;
+            else
+                FirstChild = node;
+
+            LastChild = node;
         }
-        
+
+        inline void UnlinkChild(Node* node)
+        {
+            if (node->PreviousSibling)
+                node->PreviousSibling->NextSibling = node->NextSibling;
+            else
+                FirstChild = node->NextSibling;
+
+            if (node->NextSibling)
+                node->NextSibling->PreviousSibling = node->PreviousSibling;
+            else
+                LastChild = node->PreviousSibling;
+
+            node->Parent = nullptr;
+            node->PreviousSibling = nullptr;
+            node->NextSibling = nullptr;
+        }
+    protected:
+        virtual void OnRegister(ComponentRegistry&) {}
+        virtual void OnUnregister(ComponentRegistry&) {}
+
+        inline void OnTransformChanged() override
+        {
+            MarkTransformDirty();
+        }
+	public:
+        //Moves the node from its previous parent, if it had one
         inline void AttachChild(Node* node)
         {
-           Childs[node->GetHandle()] = node;
+           if (node->Parent)
+               node->Parent->DetachChild(node);
+
+           LinkChild(node);
+           node->MarkTransformDirty();
 
-           node->SetParent(this);
+           if (Registry)
+               node->SetRegistry(Registry);
         }
 
         inline void DetachChild(Node* node)
         {
-           Childs.erase(node->GetHandle());
+           if (node->Parent != this)
+           {
+               LOGE("Detached node isn't a child!");
+               return;
+           }
+
+           UnlinkChild(node);
+           node->MarkTransformDirty();
+
+           if (node->Registry)
+               node->SetRegistry(nullptr);
+        }
+
+        //Detaches the node from its parent and its children from it, required before it's destroyed
+        inline void DetachAll()
+        {
+            if (Parent)
+                Parent->DetachChild(this);
+            else if (Registry)
+                SetRegistry(nullptr);
+
+            while (FirstChild)
+                DetachChild(FirstChild);
+        }
+
+        inline Node* GetParent() const
+        {
+            return Parent;
+        }
+
+        inline Node* GetFirstChild() const
+        {
+            return FirstChild;
+        }
+
+        inline Node* GetNextSibling() const
+        {
+            return NextSibling;
+        }
+
+        //Recomputes the world transforms of dirty nodes and their subtrees, clean subtrees aren't visited.
+        //Called once per frame on the root, costs nothing when nothing moved
+        inline void UpdateTransforms(const bool parentChanged = false)
+        {
+            bool changed = parentChanged || TransformDirty;
+
+            if (changed)
+                ComputeWorldTransform();
+
+            if (changed || ChildTransformDirty)
+            {
+                for (Node* c = FirstChild; c; c = c->NextSibling)
+                    c->UpdateTransforms(changed);
+            }
+
+            TransformDirty = false;
+            ChildTransformDirty = false;
+        }
+
+        //Single level of UpdateTransforms, children that still need the update are appended with the
+        //parentChanged value to pass them. Lets callers spread subtrees over threads
+        inline void UpdateTransformLevel(const bool parentChanged, std::vector<std::pair<Node*, bool>>& pending)
+        {
+            bool changed = parentChanged || TransformDirty;
 
-           node->SetParent(nullptr);
+            if (changed)
+                ComputeWorldTransform();
+
+            if (changed || ChildTransformDirty)
+            {
+                for (Node* c = FirstChild; c; c = c->NextSibling)
+                {
+                    if (changed || c->TransformDirty || c->ChildTransformDirty)
+                        pending.push_back({ c, changed });
+                }
+            }
+
+            TransformDirty = false;
+            ChildTransformDirty = false;
         }
 
-        inline glm::vec3 GetWorldPosition() const
+        inline uint64_t GetTransformVersion() const
         {
-            if (!Parent)
-                return Position;
-            
-            return Parent->GetWorldPosition() + Position;
+            return TransformVersion;
         }
 
-        inline glm::vec3 GetWorldScale() const
+        //Moves the whole subtree to another registry, nullptr only unregisters it
+        inline void SetRegistry(ComponentRegistry* registry)
         {
-            if (!Parent)
-                return Scale;
+            if (Registry)
+                OnUnregister(*Registry);
+
+            Registry = registry;
+
+            if (Registry)
+                OnRegister(*Registry);
 
-            return Parent->GetWorldScale() * Scale;
+            for (Node* c = FirstChild; c; c = c->NextSibling)
+                c->SetRegistry(registry);
         }
 
-        inline glm::vec4 GetWorldRotation() const
+        inline ComponentRegistry* GetRegistry() const
         {
-            if (!Parent)
-                return Rotation;
+            return Registry;
+        }
 
-            auto w = Parent->GetWorldRotation();
-            auto l = Rotation;
-            auto rot = glm::vec4(glm::vec3(w) * glm::vec3(l), w.w + l.w);
+        //World values are the ones of the latest UpdateTransforms
+        inline const glm::vec3& GetWorldPosition() const
+        {
+            return WorldPosition;
+        }
+
+        inline const glm::vec3& GetWorldScale() const
+        {
+            return WorldScale;
+        }
+
+        inline const glm::vec4& GetWorldRotation() const
+        {
+            return WorldRotation;
+        }
 
-            return rot;
+        //Renderers compose these in batches, see ComposeTransforms
+        inline glm::mat4 GetWorldMatrix() const
+        {
+            glm::mat4 transform(1.0f);
+            transform = glm::rotate(transform, WorldRotation.w, glm::vec3(WorldRotation));
+            transform = glm::scale(transform, WorldScale);
+            transform = glm::translate(transform, WorldPosition);
+
+            return transform;
         }
 
         //Looks up through child nodes and return nodes with desired channel
@@ -90,9 +320,9 @@ namespace scene
         {
             std::vector<T*> v;
 
-            for (auto&[h, c] : Childs)
+            for (Node* c = FirstChild; c; c = c->NextSibling)
             {
-                auto cv = c->GetNodesWithChannel<T>();
+                auto cv = c->template GetNodesWithChannel<T>();
                 v.insert(v.end(), cv.begin(), cv.end());
 
                 auto ptr = dynamic_cast<T*>(c);
@@ -108,26 +338,191 @@ namespace scene
     {
         VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS;
         VkCullModeFlags FacesCullMode = VK_CULL_MODE_BACK_BIT;
+
+        //Skipped when its world bounds are outside of the camera frustum, off for meshes drawn around the camera
+        bool FrustumCulled = true;
+    };
+
+    //Per type arrays of the nodes attached under a registered root, kept up to date on attach and detach,
+    //so gathering them is free. Light arrays are dense and change order when one is removed. Meshes keep their slot
+    //while registered, freed slots stay nullptr until an added mesh takes them over before the array grows.
+    //Nodes have to be detached before they are destroyed, SceneStore does it for pooled ones
+    class ComponentRegistry
+    {
+    private:
+        std::vector<MeshRenderable*> Meshes;
+        //Registration of the mesh in each slot, never reused so users of the slots can tell its meshes apart.
+        //Zero for free slots
+        std::vector<uint64_t> MeshIds;
+        std::vector<uint32_t> FreeMeshSlots;
+        uint64_t LastMeshId = 0;
+
+        //Slots added to or freed since the last TakeChangedMeshSlots, each one once
+        std::vector<uint32_t> ChangedMeshSlots;
+        std::vector<uint8_t> MeshSlotsChanged;
+
+        std::vector<PointLight*> PointLights;
+        std::vector<Spotlight*> Spotlights;
+
+        //Bumped on every add and remove, so users of the arrays know when indices were invalidated
+        uint64_t Version = 0;
+
+        template<typename T>
+        inline void Add(std::vector<T*>& v, T* node)
+        {
+            node->RegistryIndex = v.size();
+            v.push_back(node);
+
+            ++Version;
+        }
+
+        //Swaps the last node into the freed place
+        template<typename T>
+        inline void Remove(std::vector<T*>& v, T* node)
+        {
+            auto last = v.back();
+            last->RegistryIndex = node->RegistryIndex;
+            v[node->RegistryIndex] = last;
+            v.pop_back();
+
+            node->RegistryIndex = SIZE_MAX;
+
+            ++Version;
+        }
+
+        inline void MarkMeshSlotChanged(const uint32_t slot)
+        {
+            if (MeshSlotsChanged[slot])
+                return;
+
+            MeshSlotsChanged[slot] = 1;
+            ChangedMeshSlots.push_back(slot);
+        }
+    public:
+        inline void Add(PointLight* node) { Add(PointLights, node); }
+        inline void Add(Spotlight* node) { Add(Spotlights, node); }
+
+        inline void Remove(PointLight* node) { Remove(PointLights, node); }
+        inline void Remove(Spotlight* node) { Remove(Spotlights, node); }
+
+        //Takes the most recently freed slot over, a new one when none is free
+        void Add(MeshRenderable* node);
+        void Remove(MeshRenderable* node);
+
+        //Indexed by slot, nullptr for free ones. The array never shrinks
+        inline const std::vector<MeshRenderable*>& GetMeshes() const
+        {
+            return Meshes;
+        }
+
+        inline uint64_t GetMeshId(const uint32_t slot) const
+        {
+            return MeshIds[slot];
+        }
+
+        inline size_t GetMeshesCount() const
+        {
+            return Meshes.size() - FreeMeshSlots.size();
+        }
+
+        //Replaces the slots with the ones changed since the previous call, a slot may have been freed and taken
+        //over again in between. Meant for a single user that applies the changes once per frame
+        inline void TakeChangedMeshSlots(std::vector<uint32_t>& slots)
+        {
+            slots.swap(ChangedMeshSlots);
+            ChangedMeshSlots.clear();
+
+            for (auto s : slots)
+                MeshSlotsChanged[s] = 0;
+        }
+
+        inline const std::vector<PointLight*>& GetPointLights() const
+        {
+            return PointLights;
+        }
+
+        inline const std::vector<Spotlight*>& GetSpotlights() const
+        {
+            return Spotlights;
+        }
+
+        inline uint64_t GetVersion() const
+        {
+            return Version;
+        }
     };
 
     class MeshRenderable : public Node
     {
+    protected:
+        inline void OnRegister(ComponentRegistry& registry) override { registry.Add(this); }
+        inline void OnUnregister(ComponentRegistry& registry) override { registry.Remove(this); }
     public:
         std::shared_ptr<render::BaseMaterial> Material;
 
         utils::HashString Mesh;
 
+        //Model space, read from the mesh asset when the render manager registers it
+        Aabb LocalBounds = { glm::vec3(-1.0f), glm::vec3(1.0f) };
+
         RenderInfo Render;
     };
 
+    inline void ComponentRegistry::Add(MeshRenderable* node)
+    {
+        uint32_t slot;
+
+        if (!FreeMeshSlots.empty())
+        {
+            slot = FreeMeshSlots.back();
+            FreeMeshSlots.pop_back();
+        }
+        else
+        {
+            slot = Meshes.size();
+
+            Meshes.push_back(nullptr);
+            MeshIds.push_back(0);
+            MeshSlotsChanged.push_back(0);
+        }
+
+        node->RegistryIndex = slot;
+        Meshes[slot] = node;
+        MeshIds[slot] = ++LastMeshId;
+
+        MarkMeshSlotChanged(slot);
+        ++Version;
+    }
+
+    inline void ComponentRegistry::Remove(MeshRenderable* node)
+    {
+        uint32_t slot = node->RegistryIndex;
+
+        Meshes[slot] = nullptr;
+        MeshIds[slot] = 0;
+        FreeMeshSlots.push_back(slot);
+
+        node->RegistryIndex = SIZE_MAX;
+
+        MarkMeshSlotChanged(slot);
+        ++Version;
+    }
+
     class PointLight : public Node
     {
+    protected:
+        inline void OnRegister(ComponentRegistry& registry) override { registry.Add(this); }
+        inline void OnUnregister(ComponentRegistry& registry) override { registry.Remove(this); }
     public:
         glm::vec3 Color;
     };
 
+    //Registered only as a spotlight, not as a point light
     class Spotlight : public PointLight
     {
+    protected:
+        inline void OnRegister(ComponentRegistry& registry) override { registry.Add(this); }
+        inline void OnUnregister(ComponentRegistry& registry) override { registry.Remove(this); }
     public:
         float OuterAngle;
         float InnerAngle;
@@ -0,0 +1,270 @@
+#pragma once
+#include "vrender.h"
+
+#include "scene/scene_hi.h"
+
+#include <type_traits>
+
+namespace scene
+{
+    //Nodes per pool chunk, chunks never move so nodes keep their addresses
+    constexpr uint32_t NodePoolChunkSize = 1024;
+
+    //Low bits of a handle index the pool slot, high bits count how many times the slot was reused
+    constexpr uint32_t HandleIndexBits = 20;
+    constexpr uint32_t HandleIndexMask = (1u << HandleIndexBits) - 1;
+    constexpr uint32_t HandleGenerationMask = (1u << (32 - HandleIndexBits)) - 1;
+
+    //32 bit reference to a pooled node. Handles of destroyed nodes resolve to nullptr until the generation
+    //of their slot wraps around
+    template<typename T>
+    class NodeHandle
+    {
+    private:
+        uint32_t Value = UINT32_MAX;
+    public:
+        NodeHandle() = default;
+
+        inline NodeHandle(const uint32_t index, const uint32_t generation)
+            : Value((generation << HandleIndexBits) | index) {}
+
+        inline bool IsValid() const
+        {
+            return Value != UINT32_MAX;
+        }
+
+        inline uint32_t GetIndex() const
+        {
+            return Value & HandleIndexMask;
+        }
+
+        inline uint32_t GetGeneration() const
+        {
+            return Value >> HandleIndexBits;
+        }
+
+        inline bool operator==(const NodeHandle& other) const
+        {
+            return Value == other.Value;
+        }
+
+        inline bool operator!=(const NodeHandle& other) const
+        {
+            return Value != other.Value;
+        }
+    };
+
+    //Nodes of one type allocated in fixed chunks, freed slots are reused before new ones
+    template<typename T>
+    class NodePool
+    {
+    private:
+        using Storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+        struct SlotState
+        {
+            uint16_t Generation = 0;
+            bool Alive = false;
+        };
+
+        std::vector<std::unique_ptr<Storage[]>> Chunks;
+        std::vector<SlotState> Slots;
+        std::vector<uint32_t> FreeSlots;
+
+        size_t AliveCount = 0;
+
+        inline T* GetSlot(const uint32_t index) const
+        {
+            return reinterpret_cast<T*>(&Chunks[index / NodePoolChunkSize][index % NodePoolChunkSize]);
+        }
+    public:
+        NodePool() = default;
+        NodePool(const NodePool&) = delete;
+        NodePool& operator=(const NodePool&) = delete;
+
+        inline ~NodePool()
+        {
+            Clear();
+        }
+
+        //Invalid handle once every index is taken
+        inline NodeHandle<T> Create()
+        {
+            uint32_t index;
+
+            if (!FreeSlots.empty())
+            {
+                index = FreeSlots.back();
+                FreeSlots.pop_back();
+            }
+            else
+            {
+                //Last index is reserved, its handle with the last generation is the invalid one
+                if (Slots.size() >= HandleIndexMask)
+                {
+                    LOGE("Node pool is full!");
+                    return {};
+                }
+
+                index = Slots.size();
+
+                if (index / NodePoolChunkSize == Chunks.size())
+                    Chunks.push_back(std::make_unique<Storage[]>(NodePoolChunkSize));
+
+                Slots.emplace_back();
+            }
+
+            new (GetSlot(index)) T();
+
+            Slots[index].Alive = true;
+            ++AliveCount;
+
+            return { index, Slots[index].Generation };
+        }
+
+        //Allocates chunks and slots up front, so creating up to count nodes in total doesn't allocate
+        inline void Reserve(const size_t count)
+        {
+            while (Chunks.size() * NodePoolChunkSize < count)
+                Chunks.push_back(std::make_unique<Storage[]>(NodePoolChunkSize));
+
+            Slots.reserve(count);
+        }
+
+        //nullptr when the node was destroyed
+        inline T* Get(const NodeHandle<T> handle) const
+        {
+            uint32_t index = handle.GetIndex();
+
+            if (index >= Slots.size() || !Slots[index].Alive || Slots[index].Generation != handle.GetGeneration())
+                return nullptr;
+
+            return GetSlot(index);
+        }
+
+        //Detaches the node from the hierarchy first, its children stay alive as roots
+        inline bool Destroy(const NodeHandle<T> handle)
+        {
+            T* node = Get(handle);
+            if (!node)
+                return false;
+
+            node->DetachAll();
+            node->~T();
+
+            uint32_t index = handle.GetIndex();
+
+            Slots[index].Alive = false;
+            Slots[index].Generation = (Slots[index].Generation + 1) & HandleGenerationMask;
+
+            FreeSlots.push_back(index);
+            --AliveCount;
+
+            return true;
+        }
+
+        //Live nodes in slot order, which follows memory order
+        template<typename F>
+        inline void ForEach(const F& func) const
+        {
+            for (uint32_t i = 0; i < Slots.size(); ++i)
+            {
+                if (Slots[i].Alive)
+                    func(*GetSlot(i));
+            }
+        }
+
+        //Destroys every node, chunks are kept for reuse
+        inline void Clear()
+        {
+            for (uint32_t i = 0; i < Slots.size(); ++i)
+            {
+                if (Slots[i].Alive)
+                    Destroy({ i, Slots[i].Generation });
+            }
+        }
+
+        inline size_t GetCount() const
+        {
+            return AliveCount;
+        }
+
+        //Chunks and slot states, kept after nodes are destroyed
+        inline size_t GetMemoryUsage() const
+        {
+            return Chunks.size() * NodePoolChunkSize * sizeof(Storage) + Slots.capacity() * sizeof(SlotState);
+        }
+    };
+
+    //Owns pooled nodes of every type. Nodes link to each other by pointer, handles are for references
+    //held outside of the hierarchy that may outlive the node
+    class SceneStore
+    {
+    private:
+        NodePool<Node> Nodes;
+        NodePool<MeshRenderable> Meshes;
+        NodePool<PointLight> PointLights;
+        NodePool<Spotlight> Spotlights;
+
+        template<typename>
+        static constexpr bool UnknownType = false;
+    public:
+        template<typename T>
+        inline NodePool<T>& GetPool()
+        {
+            if constexpr (std::is_same_v<T, Node>)
+                return Nodes;
+            else if constexpr (std::is_same_v<T, MeshRenderable>)
+                return Meshes;
+            else if constexpr (std::is_same_v<T, PointLight>)
+                return PointLights;
+            else if constexpr (std::is_same_v<T, Spotlight>)
+                return Spotlights;
+            else
+                static_assert(UnknownType<T>, "Node type has no pool");
+        }
+
+        template<typename T>
+        inline const NodePool<T>& GetPool() const
+        {
+            return const_cast<SceneStore*>(this)->GetPool<T>();
+        }
+
+        template<typename T>
+        inline NodeHandle<T> Create()
+        {
+            return GetPool<T>().Create();
+        }
+
+        template<typename T>
+        inline T* Get(const NodeHandle<T> handle)
+        {
+            return GetPool<T>().Get(handle);
+        }
+
+        template<typename T>
+        inline bool Destroy(const NodeHandle<T> handle)
+        {
+            return GetPool<T>().Destroy(handle);
+        }
+
+        inline void Clear()
+        {
+            Spotlights.Clear();
+            PointLights.Clear();
+            Meshes.Clear();
+            Nodes.Clear();
+        }
+
+        inline size_t GetNodesCount() const
+        {
+            return Nodes.GetCount() + Meshes.GetCount() + PointLights.GetCount() + Spotlights.GetCount();
+        }
+
+        inline size_t GetMemoryUsage() const
+        {
+            return Nodes.GetMemoryUsage() + Meshes.GetMemoryUsage() + PointLights.GetMemoryUsage()
+                   + Spotlights.GetMemoryUsage();
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "transform_batch.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define VRENDER_TRANSFORMS_SSE
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+	#define VRENDER_TRANSFORMS_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace scene
+{
+	namespace
+	{
+#if defined(VRENDER_TRANSFORMS_SSE)
+		using Float4 = __m128;
+
+		inline Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+		inline Float4 Set(const float v) { return _mm_set1_ps(v); }
+		inline Float4 Add(const Float4 a, const Float4 b) { return _mm_add_ps(a, b); }
+		inline Float4 Sub(const Float4 a, const Float4 b) { return _mm_sub_ps(a, b); }
+		inline Float4 Mul(const Float4 a, const Float4 b) { return _mm_mul_ps(a, b); }
+		inline Float4 Div(const Float4 a, const Float4 b) { return _mm_div_ps(a, b); }
+		inline Float4 Sqrt(const Float4 a) { return _mm_sqrt_ps(a); }
+
+		//Lanes hold one column component each, transposed so every transform gets its whole column
+		inline void StoreColumn(Float4 x, Float4 y, Float4 z, Float4 w, uint8_t* const* destinations, const size_t column)
+		{
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+
+			_mm_storeu_ps(reinterpret_cast<float*>(destinations[0]) + column * 4, x);
+			_mm_storeu_ps(reinterpret_cast<float*>(destinations[1]) + column * 4, y);
+			_mm_storeu_ps(reinterpret_cast<float*>(destinations[2]) + column * 4, z);
+			_mm_storeu_ps(reinterpret_cast<float*>(destinations[3]) + column * 4, w);
+		}
+#elif defined(VRENDER_TRANSFORMS_NEON)
+		using Float4 = float32x4_t;
+
+		inline Float4 Load(const float* p) { return vld1q_f32(p); }
+		inline Float4 Set(const float v) { return vdupq_n_f32(v); }
+		inline Float4 Add(const Float4 a, const Float4 b) { return vaddq_f32(a, b); }
+		inline Float4 Sub(const Float4 a, const Float4 b) { return vsubq_f32(a, b); }
+		inline Float4 Mul(const Float4 a, const Float4 b) { return vmulq_f32(a, b); }
+		inline Float4 Div(const Float4 a, const Float4 b) { return vdivq_f32(a, b); }
+		inline Float4 Sqrt(const Float4 a) { return vsqrtq_f32(a); }
+
+		inline void StoreColumn(const Float4 x, const Float4 y, const Float4 z, const Float4 w,
+								uint8_t* const* destinations, const size_t column)
+		{
+			float32x4x4_t lanes = { { x, y, z, w } };
+
+			float values[16];
+			vst4q_f32(values, lanes);
+
+			for (size_t i = 0; i < 4; ++i)
+				std::memcpy(destinations[i] + column * 4 * sizeof(float), values + i * 4, 4 * sizeof(float));
+		}
+#else
+		struct Float4
+		{
+			float V[4];
+		};
+
+		inline Float4 Load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+		inline Float4 Set(const float v) { return { { v, v, v, v } }; }
+
+		template<typename F>
+		inline Float4 Apply(const Float4 a, const Float4 b, F f)
+		{
+			return { { f(a.V[0], b.V[0]), f(a.V[1], b.V[1]), f(a.V[2], b.V[2]), f(a.V[3], b.V[3]) } };
+		}
+
+		inline Float4 Add(const Float4 a, const Float4 b) { return Apply(a, b, [](float x, float y) { return x + y; }); }
+		inline Float4 Sub(const Float4 a, const Float4 b) { return Apply(a, b, [](float x, float y) { return x - y; }); }
+		inline Float4 Mul(const Float4 a, const Float4 b) { return Apply(a, b, [](float x, float y) { return x * y; }); }
+		inline Float4 Div(const Float4 a, const Float4 b) { return Apply(a, b, [](float x, float y) { return x / y; }); }
+		inline Float4 Sqrt(const Float4 a) { return { { std::sqrt(a.V[0]), std::sqrt(a.V[1]), std::sqrt(a.V[2]), std::sqrt(a.V[3]) } }; }
+
+		inline void StoreColumn(const Float4 x, const Float4 y, const Float4 z, const Float4 w,
+								uint8_t* const* destinations, const size_t column)
+		{
+			for (size_t i = 0; i < 4; ++i)
+			{
+				float values[4] = { x.V[i], y.V[i], z.V[i], w.V[i] };
+				std::memcpy(destinations[i] + column * 4 * sizeof(float), values, sizeof(values));
+			}
+		}
+#endif
+
+		//Expanded glm::rotate, glm::scale and glm::translate on an identity matrix
+		inline void ComposeBatch4(const TransformBatch& batch, const size_t first)
+		{
+			float cosines[4];
+			float sines[4];
+
+			for (size_t i = 0; i < 4; ++i)
+			{
+				cosines[i] = std::cos(batch.Angle[first + i]);
+				sines[i] = std::sin(batch.Angle[first + i]);
+			}
+
+			const Float4 c = Load(cosines);
+			const Float4 s = Load(sines);
+
+			Float4 ax = Load(&batch.AxisX[first]);
+			Float4 ay = Load(&batch.AxisY[first]);
+			Float4 az = Load(&batch.AxisZ[first]);
+
+			const Float4 length = Sqrt(Add(Add(Mul(ax, ax), Mul(ay, ay)), Mul(az, az)));
+			const Float4 inverseLength = Div(Set(1.0f), length);
+
+			ax = Mul(ax, inverseLength);
+			ay = Mul(ay, inverseLength);
+			az = Mul(az, inverseLength);
+
+			const Float4 t = Sub(Set(1.0f), c);
+			const Float4 tx = Mul(t, ax);
+			const Float4 ty = Mul(t, ay);
+			const Float4 tz = Mul(t, az);
+
+			const Float4 sx = Load(&batch.ScaleX[first]);
+			const Float4 sy = Load(&batch.ScaleY[first]);
+			const Float4 sz = Load(&batch.ScaleZ[first]);
+
+			const Float4 c00 = Mul(Add(c, Mul(tx, ax)), sx);
+			const Float4 c01 = Mul(Add(Mul(tx, ay), Mul(s, az)), sx);
+			const Float4 c02 = Mul(Sub(Mul(tx, az), Mul(s, ay)), sx);
+
+			const Float4 c10 = Mul(Sub(Mul(ty, ax), Mul(s, az)), sy);
+			const Float4 c11 = Mul(Add(c, Mul(ty, ay)), sy);
+			const Float4 c12 = Mul(Add(Mul(ty, az), Mul(s, ax)), sy);
+
+			const Float4 c20 = Mul(Add(Mul(tz, ax), Mul(s, ay)), sz);
+			const Float4 c21 = Mul(Sub(Mul(tz, ay), Mul(s, ax)), sz);
+			const Float4 c22 = Mul(Add(c, Mul(tz, az)), sz);
+
+			const Float4 px = Load(&batch.PositionX[first]);
+			const Float4 py = Load(&batch.PositionY[first]);
+			const Float4 pz = Load(&batch.PositionZ[first]);
+
+			const Float4 c30 = Add(Add(Mul(c00, px), Mul(c10, py)), Mul(c20, pz));
+			const Float4 c31 = Add(Add(Mul(c01, px), Mul(c11, py)), Mul(c21, pz));
+			const Float4 c32 = Add(Add(Mul(c02, px), Mul(c12, py)), Mul(c22, pz));
+
+			const Float4 zero = Set(0.0f);
+			const Float4 one = Set(1.0f);
+
+			uint8_t* const* destinations = &batch.Destinations[first];
+
+			StoreColumn(c00, c01, c02, zero, destinations, 0);
+			StoreColumn(c10, c11, c12, zero, destinations, 1);
+			StoreColumn(c20, c21, c22, zero, destinations, 2);
+			StoreColumn(c30, c31, c32, one, destinations, 3);
+		}
+
+		inline void ComposeSingle(const TransformBatch& batch, const size_t i)
+		{
+			glm::mat4 transform(1.0f);
+			transform = glm::rotate(transform, batch.Angle[i], glm::vec3(batch.AxisX[i], batch.AxisY[i], batch.AxisZ[i]));
+			transform = glm::scale(transform, glm::vec3(batch.ScaleX[i], batch.ScaleY[i], batch.ScaleZ[i]));
+			transform = glm::translate(transform, glm::vec3(batch.PositionX[i], batch.PositionY[i], batch.PositionZ[i]));
+
+			std::memcpy(batch.Destinations[i], &transform, sizeof(transform));
+		}
+	}
+
+	void ComposeTransforms(const TransformBatch& batch, const size_t begin, const size_t end)
+	{
+		size_t i = begin;
+
+		for (; i + 4 <= end; i += 4)
+			ComposeBatch4(batch, i);
+
+		for (; i < end; ++i)
+			ComposeSingle(batch, i);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include "vrender.h"
+
+namespace scene
+{
+	//World transforms in structure of arrays form, each one composed into a matrix at its destination.
+	//Vectors keep their capacity between frames, so steady state batches don't allocate
+	struct TransformBatch
+	{
+		std::vector<float> PositionX;
+		std::vector<float> PositionY;
+		std::vector<float> PositionZ;
+
+		std::vector<float> ScaleX;
+		std::vector<float> ScaleY;
+		std::vector<float> ScaleZ;
+
+		//Rotation axis, normalized while composing, and angle in radians
+		std::vector<float> AxisX;
+		std::vector<float> AxisY;
+		std::vector<float> AxisZ;
+		std::vector<float> Angle;
+
+		//Column major glm::mat4 is written to each, e.g. straight into mapped gpu memory
+		std::vector<uint8_t*> Destinations;
+
+		inline void Clear()
+		{
+			PositionX.clear();
+			PositionY.clear();
+			PositionZ.clear();
+
+			ScaleX.clear();
+			ScaleY.clear();
+			ScaleZ.clear();
+
+			AxisX.clear();
+			AxisY.clear();
+			AxisZ.clear();
+			Angle.clear();
+
+			Destinations.clear();
+		}
+
+		inline void Push(const glm::vec3& position, const glm::vec3& scale, const glm::vec4& rotation, uint8_t* destination)
+		{
+			PositionX.push_back(position.x);
+			PositionY.push_back(position.y);
+			PositionZ.push_back(position.z);
+
+			ScaleX.push_back(scale.x);
+			ScaleY.push_back(scale.y);
+			ScaleZ.push_back(scale.z);
+
+			AxisX.push_back(rotation.x);
+			AxisY.push_back(rotation.y);
+			AxisZ.push_back(rotation.z);
+			Angle.push_back(rotation.w);
+
+			Destinations.push_back(destination);
+		}
+
+		inline size_t Size() const
+		{
+			return Destinations.size();
+		}
+	};
+
+	//Same matrices as Node::GetWorldMatrix, rotate * scale * translate, composed 4 transforms at a time
+	//with SSE2 or NEON when available. Ranges of one batch can be composed on different threads
+	void ComposeTransforms(const TransformBatch& batch, const size_t begin, const size_t end);
+
+	inline void ComposeTransforms(const TransformBatch& batch)
+	{
+		ComposeTransforms(batch, 0, batch.Size());
+	}
+}
\ No newline at end of file
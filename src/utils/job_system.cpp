@@ -0,0 +1,348 @@
+#include "job_system.h"
+
+#include "timer.h"
+
+namespace utils
+{
+	namespace
+	{
+		thread_local const JobSystem* CurrentSystem = nullptr;
+		thread_local uint32_t CurrentWorkerIndex = 0;
+	}
+
+	bool JobSystem::JobQueue::Push(const Job& job)
+	{
+		int64_t bottom = Bottom.load(std::memory_order_relaxed);
+		int64_t top = Top.load(std::memory_order_acquire);
+
+		if (bottom - top >= MaxWorkerJobs)
+			return false;
+
+		Jobs[bottom & (MaxWorkerJobs - 1)] = job;
+
+		std::atomic_thread_fence(std::memory_order_release);
+		Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	bool JobSystem::JobQueue::Pop(Job& job)
+	{
+		int64_t bottom = Bottom.load(std::memory_order_relaxed) - 1;
+		Bottom.store(bottom, std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = Top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		job = Jobs[bottom & (MaxWorkerJobs - 1)];
+
+		if (top != bottom)
+			return true;
+
+		//Last job, races with thieves for it
+		bool taken = Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+		return taken;
+	}
+
+	bool JobSystem::JobQueue::Steal(Job& job)
+	{
+		int64_t top = Top.load(std::memory_order_acquire);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = Bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+			return false;
+
+		job = Jobs[top & (MaxWorkerJobs - 1)];
+
+		return Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	void JobSystem::Setup(const uint32_t threadsCount, const uint32_t attachedThreadsCount)
+	{
+		uint32_t count = threadsCount;
+		if (count == 0)
+			count = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+
+		Stop = false;
+
+		FirstAttachedWorker = count + 1;
+		AttachedThreadsCount = 0;
+
+		Workers.resize(count + 1 + attachedThreadsCount);
+		for (uint32_t i = 0; i < Workers.size(); ++i)
+		{
+			Workers[i] = std::make_unique<Worker>();
+			Workers[i]->RandomState = 0x9e3779b9u * (i + 1);
+		}
+
+		CurrentSystem = this;
+		CurrentWorkerIndex = 0;
+
+		for (uint32_t i = 1; i < FirstAttachedWorker; ++i)
+			Threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+
+	bool JobSystem::AttachThread()
+	{
+		uint32_t index = FirstAttachedWorker + AttachedThreadsCount.fetch_add(1);
+		if (index >= Workers.size())
+			return false;
+
+		CurrentSystem = this;
+		CurrentWorkerIndex = index;
+
+		return true;
+	}
+
+	void JobSystem::Cleanup()
+	{
+		{
+			std::lock_guard<std::mutex> lock(SleepMutex);
+			Stop = true;
+		}
+
+		SleepCondition.notify_all();
+
+		for (auto& t : Threads)
+			t.join();
+
+		Threads.clear();
+		Workers.clear();
+
+		if (CurrentSystem == this)
+			CurrentSystem = nullptr;
+	}
+
+	JobSystem::Worker* JobSystem::GetCurrentWorker() const
+	{
+		if (CurrentSystem != this)
+			return nullptr;
+
+		return Workers[CurrentWorkerIndex].get();
+	}
+
+	void JobSystem::Schedule(const Job& job, JobCounter& counter, JobCounter* dependency)
+	{
+		Job scheduled = job;
+		scheduled.Counter = &counter;
+
+		counter.Value.fetch_add(1, std::memory_order_relaxed);
+
+		if (dependency)
+		{
+			//Last job of the dependency clears it under the same lock, so the job is either parked or pushed here
+			std::lock_guard<std::mutex> lock(dependency->WaitingMutex);
+
+			if (dependency->Value.load(std::memory_order_acquire) > 0)
+			{
+				dependency->Waiting.push_back(scheduled);
+				return;
+			}
+		}
+
+		Push(scheduled);
+	}
+
+	void JobSystem::Push(const Job& job)
+	{
+		Worker* worker = GetCurrentWorker();
+
+		//Threads outside of the pool have no queue
+		if (!worker)
+		{
+			Execute(job);
+			return;
+		}
+
+		QueuedJobs.fetch_add(1);
+
+		if (!worker->Queue.Push(job))
+		{
+			QueuedJobs.fetch_sub(1);
+			Execute(job);
+			return;
+		}
+
+		if (SleepingWorkers.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(SleepMutex);
+			SleepCondition.notify_one();
+		}
+	}
+
+	bool JobSystem::FindJob(Worker& worker, Job& job)
+	{
+		if (worker.Queue.Pop(job))
+		{
+			QueuedJobs.fetch_sub(1);
+			return true;
+		}
+
+		if (Workers.size() < 2)
+			return false;
+
+		//Xorshift, victims are picked randomly so thieves don't pile up on the same queue
+		worker.RandomState ^= worker.RandomState << 13;
+		worker.RandomState ^= worker.RandomState >> 17;
+		worker.RandomState ^= worker.RandomState << 5;
+
+		size_t first = worker.RandomState % Workers.size();
+
+		for (size_t i = 0; i < Workers.size(); ++i)
+		{
+			auto& victim = *Workers[(first + i) % Workers.size()];
+			if (&victim == &worker)
+				continue;
+
+			if (victim.Queue.Steal(job))
+			{
+				QueuedJobs.fetch_sub(1);
+				worker.Steals.fetch_add(1, std::memory_order_relaxed);
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void JobSystem::Execute(const Job& job)
+	{
+		job.Function(job.Data, job.Begin, job.End);
+
+		if (Worker* worker = GetCurrentWorker())
+			worker->Jobs.fetch_add(1, std::memory_order_relaxed);
+
+		auto& counter = *job.Counter;
+
+		uint32_t value = counter.Value.load(std::memory_order_relaxed);
+		while (value > 1)
+		{
+			if (counter.Value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+				return;
+		}
+
+		//Likely the last job, releases the parked ones. Waiters take the lock before returning,
+		//so the counter outlives it
+		std::lock_guard<std::mutex> lock(counter.WaitingMutex);
+
+		if (counter.Value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		for (const auto& j : counter.Waiting)
+			Push(j);
+
+		counter.Waiting.clear();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		Worker* worker = GetCurrentWorker();
+		uint64_t idleBegin = 0;
+
+		while (!counter.IsDone())
+		{
+			Job job;
+			if (worker && FindJob(*worker, job))
+			{
+				if (idleBegin)
+				{
+					worker->IdleTime.fetch_add(GetSteadyTime() - idleBegin, std::memory_order_relaxed);
+					idleBegin = 0;
+				}
+
+				Execute(job);
+			}
+			else
+			{
+				if (!idleBegin)
+					idleBegin = GetSteadyTime();
+
+				std::this_thread::yield();
+			}
+		}
+
+		if (worker && idleBegin)
+			worker->IdleTime.fetch_add(GetSteadyTime() - idleBegin, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(counter.WaitingMutex);
+	}
+
+	void JobSystem::WorkerLoop(const uint32_t index)
+	{
+		CurrentSystem = this;
+		CurrentWorkerIndex = index;
+
+		auto& worker = *Workers[index];
+
+		while (!Stop.load(std::memory_order_relaxed))
+		{
+			Job job;
+			if (FindJob(worker, job))
+			{
+				Execute(job);
+				continue;
+			}
+
+			uint64_t idleBegin = GetSteadyTime();
+
+			bool found = false;
+			for (uint32_t i = 0; i < WorkerSpinCount && !found; ++i)
+			{
+				std::this_thread::yield();
+				found = FindJob(worker, job);
+			}
+
+			if (!found)
+			{
+				std::unique_lock<std::mutex> lock(SleepMutex);
+
+				SleepingWorkers.fetch_add(1);
+				SleepCondition.wait(lock, [&]() { return QueuedJobs.load() > 0 || Stop.load(); });
+				SleepingWorkers.fetch_sub(1);
+			}
+
+			worker.IdleTime.fetch_add(GetSteadyTime() - idleBegin, std::memory_order_relaxed);
+
+			if (found)
+				Execute(job);
+		}
+	}
+
+	std::vector<WorkerStats> JobSystem::GetStats() const
+	{
+		std::vector<WorkerStats> stats;
+
+		for (const auto& w : Workers)
+		{
+			WorkerStats s;
+			s.Jobs = w->Jobs.load(std::memory_order_relaxed);
+			s.Steals = w->Steals.load(std::memory_order_relaxed);
+			s.IdleTime = w->IdleTime.load(std::memory_order_relaxed);
+
+			stats.push_back(s);
+		}
+
+		return stats;
+	}
+
+	void JobSystem::ResetStats()
+	{
+		for (auto& w : Workers)
+		{
+			w->Jobs.store(0, std::memory_order_relaxed);
+			w->Steals.store(0, std::memory_order_relaxed);
+			w->IdleTime.store(0, std::memory_order_relaxed);
+		}
+	}
+}
\ No newline at end of file
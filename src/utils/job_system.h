@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils
+{
+	//Jobs past the capacity of a worker queue run inline on the submitting thread
+	constexpr uint32_t MaxWorkerJobs = 4096;
+
+	//Tries to find work before an idle worker thread goes to sleep
+	constexpr uint32_t WorkerSpinCount = 64;
+
+	class JobCounter;
+
+	//Plain data so queues never allocate, the callable is owned by the submitter
+	struct Job
+	{
+		void (*Function)(const void* data, const uint32_t begin, const uint32_t end);
+		const void* Data;
+
+		uint32_t Begin;
+		uint32_t End;
+
+		JobCounter* Counter;
+	};
+
+	//Number of unfinished jobs signaling it. Jobs scheduled after a counter are parked on it
+	//and pushed by the worker finishing its last job
+	class JobCounter
+	{
+		friend class JobSystem;
+	private:
+		std::atomic<uint32_t> Value = 0;
+
+		std::mutex WaitingMutex;
+		//Keeps its capacity, so reused counters don't allocate
+		std::vector<Job> Waiting;
+	public:
+		inline bool IsDone() const
+		{
+			return Value.load(std::memory_order_acquire) == 0;
+		}
+	};
+
+	struct WorkerStats
+	{
+		uint64_t Jobs = 0;
+		uint64_t Steals = 0;
+		//Nanoseconds spent without a job, sleeping included
+		uint64_t IdleTime = 0;
+	};
+
+	//Work stealing pool, every worker owns a deque it pushes and pops at the bottom while others steal
+	//from the top. The thread calling Setup becomes worker 0 and runs jobs while it waits
+	class JobSystem
+	{
+	private:
+		//Chase-Lev deque with a fixed capacity
+		class JobQueue
+		{
+		private:
+			Job Jobs[MaxWorkerJobs];
+
+			alignas(64) std::atomic<int64_t> Top = 0;
+			alignas(64) std::atomic<int64_t> Bottom = 0;
+		public:
+			//Owner only
+			bool Push(const Job& job);
+			bool Pop(Job& job);
+
+			bool Steal(Job& job);
+		};
+
+		struct alignas(64) Worker
+		{
+			JobQueue Queue;
+
+			std::atomic<uint64_t> Jobs = 0;
+			std::atomic<uint64_t> Steals = 0;
+			std::atomic<uint64_t> IdleTime = 0;
+
+			uint32_t RandomState;
+		};
+
+		std::vector<std::unique_ptr<Worker>> Workers;
+		std::vector<std::thread> Threads;
+
+		//Workers past the pool threads are claimed by AttachThread
+		std::atomic<uint32_t> AttachedThreadsCount = 0;
+		uint32_t FirstAttachedWorker;
+
+		//Pushed but not yet taken jobs, sleeping workers wake up when it's above zero
+		std::atomic<uint32_t> QueuedJobs = 0;
+		std::atomic<uint32_t> SleepingWorkers = 0;
+		std::atomic<bool> Stop = false;
+
+		std::mutex SleepMutex;
+		std::condition_variable SleepCondition;
+
+		//Worker of the calling thread, nullptr for threads outside of the pool
+		Worker* GetCurrentWorker() const;
+
+		void Push(const Job& job);
+		bool FindJob(Worker& worker, Job& job);
+		void Execute(const Job& job);
+
+		void WorkerLoop(const uint32_t index);
+
+		template<typename F>
+		static void Invoke(const void* data, const uint32_t begin, const uint32_t end)
+		{
+			(*static_cast<const F*>(data))(begin, end);
+		}
+
+		template<typename F>
+		static void InvokeSingle(const void* data, const uint32_t, const uint32_t)
+		{
+			(*static_cast<const F*>(data))();
+		}
+	public:
+		//Zero picks one worker per hardware thread besides the calling one. Attached threads are long lived
+		//threads outside of the pool that schedule jobs, e.g. the render thread
+		void Setup(const uint32_t threadsCount = 0, const uint32_t attachedThreadsCount = 0);
+
+		//Makes the calling thread a worker with its own queue, so its jobs are stolen instead of running inline.
+		//Fails once all slots reserved in Setup are taken
+		bool AttachThread();
+
+		void Cleanup();
+
+		//Schedules a job signaling the counter, once the dependency is done if it's passed.
+		//The function has to outlive the job, e.g. waited on in the same scope
+		void Schedule(const Job& job, JobCounter& counter, JobCounter* dependency = nullptr);
+
+		template<typename F>
+		inline void Run(JobCounter& counter, const F& func, JobCounter* dependency = nullptr)
+		{
+			Schedule({ &InvokeSingle<F>, &func, 0, 0, nullptr }, counter, dependency);
+		}
+
+		template<typename F>
+		void Run(JobCounter& counter, const F&& func, JobCounter* dependency = nullptr) = delete;
+
+		//Splits [0, count) into ranges of the grain size, func is called as func(begin, end)
+		template<typename F>
+		inline void ParallelFor(JobCounter& counter, const uint32_t count, const uint32_t grain, const F& func,
+								JobCounter* dependency = nullptr)
+		{
+			uint32_t step = grain ? grain : 1;
+
+			for (uint32_t begin = 0; begin < count; begin += step)
+				Schedule({ &Invoke<F>, &func, begin, std::min(count, begin + step), nullptr }, counter, dependency);
+		}
+
+		template<typename F>
+		void ParallelFor(JobCounter& counter, const uint32_t count, const uint32_t grain, const F&& func,
+						 JobCounter* dependency = nullptr) = delete;
+
+		//Blocking version, the calling thread takes part
+		template<typename F>
+		inline void ParallelFor(const uint32_t count, const uint32_t grain, const F& func)
+		{
+			//Nothing to split, skips the queues
+			if (count <= grain)
+			{
+				if (count)
+					func(0u, count);
+
+				return;
+			}
+
+			JobCounter counter;
+			ParallelFor(counter, count, grain, func);
+			Wait(counter);
+		}
+
+		//Runs other jobs until the counter is done
+		void Wait(JobCounter& counter);
+
+		inline uint32_t GetWorkersCount() const
+		{
+			return Workers.size();
+		}
+
+		//Indexed by worker, the first is the thread that called Setup and attached threads are the last
+		std::vector<WorkerStats> GetStats() const;
+
+		void ResetStats();
+	};
+}
\ No newline at end of file
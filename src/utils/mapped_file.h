@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace utils
+{
+	//Read only mapping of a whole file. Nothing is read up front, the OS pages the data in on first touch
+	//and can drop it again under memory pressure
+	class MappedFile
+	{
+	private:
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		inline ~MappedFile()
+		{
+			Close();
+		}
+
+		//Unmaps the previous file, false when the file can't be opened or is empty
+		bool Open(const std::string& path);
+		void Close();
+
+		inline bool IsOpen() const
+		{
+			return Data != nullptr;
+		}
+
+		//Mappings start at a page boundary, so offsets aligned in the file are aligned in memory
+		inline const uint8_t* GetData() const
+		{
+			return Data;
+		}
+
+		inline size_t GetSize() const
+		{
+			return Size;
+		}
+	};
+}
\ No newline at end of file
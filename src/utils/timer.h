@@ -1,8 +1,16 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
 
 namespace utils
 {
+	//Nanoseconds of the steady clock, for timestamps compared across threads
+	inline uint64_t GetSteadyTime()
+	{
+		auto time = std::chrono::steady_clock::now().time_since_epoch();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+	}
+
 	class Timer
 	{
 	private:
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace utils
+{
+	//Complete event of the chrome trace format, times in nanoseconds. Name has to outlive the event
+	struct TraceEvent
+	{
+		const char* Name;
+		uint64_t Begin;
+		uint64_t End;
+
+		uint32_t Process;
+		uint32_t Thread;
+	};
+
+	//Output opens in chrome://tracing, timestamps are shifted so the earliest event starts at zero
+	inline bool WriteChromeTrace(const std::string& filepath, const std::vector<TraceEvent>& events)
+	{
+		std::ofstream file(filepath, std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		uint64_t origin = UINT64_MAX;
+		for (const auto& e : events)
+			origin = std::min(origin, e.Begin);
+
+		file << std::fixed << std::setprecision(3);
+		file << "{\"traceEvents\":[";
+
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			const auto& e = events[i];
+
+			if (i > 0)
+				file << ",";
+
+			//Trace format expects microseconds
+			file << "\n{\"name\":\"" << e.Name << "\",\"ph\":\"X\""
+				 << ",\"ts\":" << (e.Begin - origin) / 1000.0
+				 << ",\"dur\":" << (e.End - e.Begin) / 1000.0
+				 << ",\"pid\":" << e.Process
+				 << ",\"tid\":" << e.Thread << "}";
+		}
+
+		file << "\n],\"displayTimeUnit\":\"ms\"}";
+
+		return file.good();
+	}
+}
\ No newline at end of file
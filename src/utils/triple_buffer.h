@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace utils
+{
+	//Lock-free handoff of the latest value from one producer to one consumer. The producer writes its back buffer
+	//and swaps it with the middle one, the consumer swaps its front buffer with the middle one when it's fresh.
+	//Neither side ever waits, a value the consumer didn't get to is replaced by the next one
+	template<typename T>
+	class TripleBuffer
+	{
+	private:
+		//Marks the middle buffer as published and not yet consumed
+		static constexpr uint8_t FreshBit = 4;
+
+		T Buffers[3];
+
+		std::atomic<uint8_t> Middle = 1;
+
+		//Owned by the producer and the consumer respectively
+		uint8_t Back = 0;
+		uint8_t Front = 2;
+	public:
+		//Producer only, keeps whatever it held a few publishes ago so containers can reuse their memory
+		inline T& GetWriteBuffer()
+		{
+			return Buffers[Back];
+		}
+
+		//Producer only
+		inline void Publish()
+		{
+			uint8_t previous = Middle.exchange(Back | FreshBit, std::memory_order_acq_rel);
+			Back = previous & ~FreshBit;
+		}
+
+		inline bool HasFresh() const
+		{
+			return Middle.load(std::memory_order_acquire) & FreshBit;
+		}
+
+		//Consumer only, false when nothing was published since the last call
+		inline bool Consume()
+		{
+			if (!HasFresh())
+				return false;
+
+			uint8_t previous = Middle.exchange(Front, std::memory_order_acq_rel);
+			Front = previous & ~FreshBit;
+
+			return true;
+		}
+
+		//Consumer only, valid until the next Consume
+		inline const T& GetReadBuffer() const
+		{
+			return Buffers[Front];
+		}
+	};
+}
\ No newline at end of file
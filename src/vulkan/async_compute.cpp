@@ -0,0 +1,177 @@
+#include "async_compute.h"
+
+#include "helpers.h"
+
+namespace vk
+{
+	bool AsyncCompute::Setup(vk::VulkanApp& app, const VkSemaphore graphicsTimeline)
+	{
+		App = &app;
+		GraphicsTimeline = graphicsTimeline;
+
+		auto timelineRes = CreateTimelineSemaphore(app);
+		if (!timelineRes)
+			return false;
+
+		Timeline = *timelineRes;
+
+		return Timer.Setup(app, app.QueueFamilies.Compute, ComputeTimerSlots)
+			&& Profiler.Setup(app, app.QueueFamilies.Compute, ComputeTimerSlots, ComputeProfilerScopes);
+	}
+
+	void AsyncCompute::Cleanup()
+	{
+		Wait(SubmittedValue);
+
+		DeletionQueue.FlushAll();
+
+		if (!FreeCommandBuffers.empty())
+			vkFreeCommandBuffers(App->Device, App->CommandPoolCQ, FreeCommandBuffers.size(), FreeCommandBuffers.data());
+
+		FreeCommandBuffers.clear();
+
+		Timer.Cleanup();
+		Profiler.Cleanup();
+
+		vkDestroySemaphore(App->Device, Timeline, nullptr);
+	}
+
+	uint64_t AsyncCompute::Submit(const std::function<void(const VkCommandBuffer)>& record, const uint64_t waitGraphicsValue)
+	{
+		uint64_t value = SubmittedValue + 1;
+		uint32_t timerSlot = value % Timer.GetSlotsCount();
+
+		//Job that used the same timer slot has to be done and read back before its queries are reset
+		if (value > Timer.GetSlotsCount())
+			Wait(value - Timer.GetSlotsCount());
+
+		VkCommandBuffer cmd;
+
+		if (!FreeCommandBuffers.empty())
+		{
+			cmd = FreeCommandBuffers.back();
+			FreeCommandBuffers.pop_back();
+
+			vkResetCommandBuffer(cmd, 0);
+		}
+		else
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = App->CommandPoolCQ;
+			allocInfo.commandBufferCount = 1;
+
+			auto res = vkAllocateCommandBuffers(App->Device, &allocInfo, &cmd);
+			ASSERT(res == VK_SUCCESS, "Couldn't allocate compute command buffer!");
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(cmd, &beginInfo);
+
+		Timer.Begin(cmd, timerSlot);
+		Profiler.BeginFrame(cmd, timerSlot);
+
+		//Jobs often consume results of the previous ones, queue order alone doesn't make them visible
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+							 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		record(cmd);
+
+		Timer.End(cmd, timerSlot);
+
+		vkEndCommandBuffer(cmd);
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = 1;
+		timelineInfo.pWaitSemaphoreValues = &waitGraphicsValue;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &value;
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = waitGraphicsValue > 0 ? 1 : 0;
+		submitInfo.pWaitSemaphores = &GraphicsTimeline;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &cmd;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &Timeline;
+
+		if (waitGraphicsValue == 0)
+			timelineInfo.waitSemaphoreValueCount = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(App->QueueMutex);
+
+			auto res = vkQueueSubmit(App->ComputeQueue, 1, &submitInfo, VK_NULL_HANDLE);
+			ASSERT(res == VK_SUCCESS, "Couldn't submit compute job!");
+		}
+
+		SubmittedValue = value;
+		InFlight.push_back({ cmd, value });
+
+		Profiler.Submit(timerSlot);
+
+		return value;
+	}
+
+	void AsyncCompute::Poll()
+	{
+		vkGetSemaphoreCounterValue(App->Device, Timeline, &CompletedValue);
+
+		size_t keepCount = 0;
+
+		for (size_t i = 0; i < InFlight.size(); ++i)
+		{
+			if (IsComplete(InFlight[i].Value))
+			{
+				auto time = Timer.Resolve(InFlight[i].Value % Timer.GetSlotsCount());
+				if (time)
+					LastJobTime = *time;
+
+				FreeCommandBuffers.push_back(InFlight[i].CommandBuffer);
+				continue;
+			}
+
+			if (keepCount != i)
+				InFlight[keepCount] = InFlight[i];
+
+			++keepCount;
+		}
+
+		InFlight.resize(keepCount);
+
+		DeletionQueue.Flush(CompletedValue);
+
+		Profiler.Collect();
+	}
+
+	void AsyncCompute::Wait(const uint64_t value)
+	{
+		if (IsComplete(value))
+			return;
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &Timeline;
+		waitInfo.pValues = &value;
+
+		vkWaitSemaphores(App->Device, &waitInfo, UINT64_MAX);
+
+		Poll();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include "vrender.h"
+
+#include "vulkan_app.h"
+#include "deletion_queue.h"
+#include "queue_timer.h"
+#include "gpu_profiler.h"
+
+namespace vk
+{
+	struct ComputeJob
+	{
+		VkCommandBuffer CommandBuffer;
+		uint64_t Value;
+	};
+
+	constexpr uint32_t ComputeTimerSlots = 32;
+	constexpr uint32_t ComputeProfilerScopes = 256;
+
+	//Submits compute jobs to the compute queue, each job signals the next value of the compute timeline.
+	//Jobs can wait for a value of the graphics timeline and graphics submissions wait for compute values,
+	//so nothing blocks on the cpu and compute overlaps rendering
+	class AsyncCompute
+	{
+	private:
+		VkSemaphore Timeline;
+		VkSemaphore GraphicsTimeline;
+
+		uint64_t SubmittedValue = 0;
+		uint64_t CompletedValue = 0;
+
+		std::vector<ComputeJob> InFlight;
+		std::vector<VkCommandBuffer> FreeCommandBuffers;
+
+		vk::DeletionQueue DeletionQueue;
+
+		vk::QueueTimer Timer;
+		QueueTimeRange LastJobTime;
+
+		vk::GpuProfiler Profiler;
+
+		vk::VulkanApp* App;
+	public:
+		bool Setup(vk::VulkanApp& app, const VkSemaphore graphicsTimeline);
+
+		void Cleanup();
+
+		//Job starts after the graphics timeline reaches the given value, 0 means no dependency.
+		//Returns the compute timeline value signaled when the job is finished
+		uint64_t Submit(const std::function<void(const VkCommandBuffer)>& record, const uint64_t waitGraphicsValue = 0);
+
+		void Poll();
+
+		void Wait(const uint64_t value);
+
+		//Resource is destroyed once all compute jobs submitted so far are finished
+		inline void DeferCleanup(std::function<void()>&& cleanup)
+		{
+			DeletionQueue.Push(SubmittedValue, std::move(cleanup));
+		}
+
+		inline bool IsComplete(const uint64_t value) const
+		{
+			return value <= CompletedValue;
+		}
+
+		inline VkSemaphore GetTimeline() const
+		{
+			return Timeline;
+		}
+
+		inline uint64_t GetSubmittedValue() const
+		{
+			return SubmittedValue;
+		}
+
+		inline QueueTimeRange GetLastJobTime() const
+		{
+			return LastJobTime;
+		}
+
+		//Record functions open scopes on it, each job is read back once it's finished
+		inline vk::GpuProfiler& GetProfiler()
+		{
+			return Profiler;
+		}
+
+		inline const vk::GpuProfiler& GetProfiler() const
+		{
+			return Profiler;
+		}
+	};
+}
\ No newline at end of file
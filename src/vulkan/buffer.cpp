@@ -4,7 +4,8 @@
 
 namespace vk
 {
-	void Buffer::Setup(vk::VulkanApp& app, const VkBufferUsageFlags usageFlags, const size_t stride, const size_t elementsCount)
+	void Buffer::Setup(vk::VulkanApp& app, const VkBufferUsageFlags usageFlags, const size_t stride, const size_t elementsCount,
+					   const VkMemoryPropertyFlags memoryFlags)
 	{
 		VulkanApp = &app;
 
@@ -26,9 +27,7 @@ namespace vk
 		VkMemoryAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(*VulkanApp, memRequirements.memoryTypeBits, 
-												   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-												   | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		allocInfo.memoryTypeIndex = FindMemoryType(*VulkanApp, memRequirements.memoryTypeBits, memoryFlags);
 
 		res = vkAllocateMemory(VulkanApp->Device, &allocInfo, nullptr, &BufferMemory);
 		ASSERT(res == VK_SUCCESS, "Couldn't allocate buffer memory!");
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstring>
 #include "vrender.h"
 #include "vulkan/vulkan_app.h"
 
@@ -15,7 +16,8 @@ namespace vk
 		size_t ElementsCount;
 		size_t Stride;
 	public:
-		void Setup(vk::VulkanApp& app, const VkBufferUsageFlags usageFlags, const size_t stride, const size_t elementsCount);
+		void Setup(vk::VulkanApp& app, const VkBufferUsageFlags usageFlags, const size_t stride, const size_t elementsCount,
+				   const VkMemoryPropertyFlags memoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
 		inline void Update(void* data, const size_t elementsCount)
 		{
@@ -27,7 +29,7 @@ namespace vk
 
 			void* mapPtr;
 			vkMapMemory(VulkanApp->Device, BufferMemory, 0, Stride * elementsCount, 0, &mapPtr);
-			memcpy(mapPtr, data, Stride * elementsCount);
+			std::memcpy(mapPtr, data, Stride * elementsCount);
 			vkUnmapMemory(VulkanApp->Device, BufferMemory);
 		}
 
@@ -51,5 +53,10 @@ namespace vk
 		{
 			return Stride;
 		}
+
+		inline size_t GetSize() const
+		{
+			return Stride * ElementsCount;
+		}
 	};
 }
\ No newline at end of file
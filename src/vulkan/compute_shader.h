@@ -14,15 +14,15 @@ namespace vk
 	public:
 		void Setup(vk::VulkanApp& app, const std::string& filepath);
 
-		inline void Cleanup()
+		inline void Cleanup() const
 		{
 			vkDestroyShaderModule(App->Device, Module, nullptr);
 		}
 
-		inline void ComputeShader::Dispatch(const VkCommandBuffer commandBuffer,
-											const uint32_t workGroupsX,
-											const uint32_t workGroupsY,
-											const uint32_t workGroupsZ) const
+		inline void Dispatch(const VkCommandBuffer commandBuffer,
+							 const uint32_t workGroupsX,
+							 const uint32_t workGroupsY,
+							 const uint32_t workGroupsZ) const
 		{
 			vkCmdDispatch(commandBuffer, workGroupsX, workGroupsY, workGroupsZ);
 		}
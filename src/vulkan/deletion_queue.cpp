@@ -0,0 +1,42 @@
+#include "deletion_queue.h"
+
+namespace vk
+{
+	void DeletionQueue::Flush(const uint64_t completedFrame)
+	{
+		//Destroy callbacks may push new deletions, so finished ones are moved out first
+		std::vector<PendingDeletion> finished;
+		size_t keepCount = 0;
+
+		for (size_t i = 0; i < Pending.size(); ++i)
+		{
+			if (Pending[i].Frame <= completedFrame)
+			{
+				finished.push_back(std::move(Pending[i]));
+				continue;
+			}
+
+			if (keepCount != i)
+				Pending[keepCount] = std::move(Pending[i]);
+
+			++keepCount;
+		}
+
+		Pending.resize(keepCount);
+
+		for (auto& f : finished)
+			f.Destroy();
+	}
+
+	void DeletionQueue::FlushAll()
+	{
+		while (!Pending.empty())
+		{
+			auto finished = std::move(Pending);
+			Pending.clear();
+
+			for (auto& f : finished)
+				f.Destroy();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+namespace vk
+{
+	struct PendingDeletion
+	{
+		uint64_t Frame;
+		std::function<void()> Destroy;
+	};
+
+	//Holds gpu resources until the frame that last used them is finished by the gpu
+	class DeletionQueue
+	{
+	private:
+		std::vector<PendingDeletion> Pending;
+	public:
+		inline void Push(const uint64_t lastUsedFrame, std::function<void()>&& destroy)
+		{
+			Pending.push_back({ lastUsedFrame, std::move(destroy) });
+		}
+
+		void Flush(const uint64_t completedFrame);
+
+		void FlushAll();
+
+		inline size_t GetPendingCount() const
+		{
+			return Pending.size();
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "gpu_profiler.h"
+
+namespace vk
+{
+	bool GpuProfiler::Setup(vk::VulkanApp& app, const uint32_t queueFamily, const uint32_t slotsCount, const uint32_t maxScopes)
+	{
+		App = &app;
+		QueueFamily = queueFamily;
+		MaxScopes = maxScopes;
+		TimestampPeriod = app.DeviceProperties.limits.timestampPeriod;
+
+		Slots.resize(slotsCount);
+		Timestamps.resize(MaxScopes * 2);
+
+		//Collecting samples then doesn't allocate while frames are measured
+		TraceEvents.reserve(MaxGpuTraceEvents);
+
+		uint32_t queuesCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(app.PhysicalDevice, &queuesCount, nullptr);
+
+		std::vector<VkQueueFamilyProperties> properties(queuesCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(app.PhysicalDevice, &queuesCount, &properties[0]);
+
+		uint32_t validBits = properties[queueFamily].timestampValidBits;
+
+		//Queue can't write timestamps, profiler stays disabled
+		if (validBits == 0)
+		{
+			LOGW("Queue family %d doesn't support timestamps!", queueFamily);
+			return true;
+		}
+
+		ValidBitsMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = slotsCount * MaxScopes * 2;
+
+		return vkCreateQueryPool(app.Device, &poolInfo, nullptr, &QueryPool) == VK_SUCCESS;
+	}
+
+	void GpuProfiler::Cleanup() const
+	{
+		if (IsEnabled())
+			vkDestroyQueryPool(App->Device, QueryPool, nullptr);
+	}
+
+	void GpuProfiler::BeginFrame(const VkCommandBuffer commandBuffer, const uint32_t slot)
+	{
+		RecordingSlot = slot;
+
+		auto& s = Slots[slot];
+		s.Scopes.clear();
+
+		if (s.Pending)
+		{
+			Submitted.erase(std::find(Submitted.begin(), Submitted.end(), slot));
+			s.Pending = false;
+		}
+
+		if (IsEnabled())
+			vkCmdResetQueryPool(commandBuffer, QueryPool, GetFirstQuery(slot), MaxScopes * 2);
+	}
+
+	uint32_t GpuProfiler::Begin(const VkCommandBuffer commandBuffer, const char* name)
+	{
+		auto& s = Slots[RecordingSlot];
+
+		if (!IsEnabled() || s.Scopes.size() >= MaxScopes)
+			return UINT32_MAX;
+
+		uint32_t scope = s.Scopes.size();
+		s.Scopes.push_back(name);
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, QueryPool,
+							GetFirstQuery(RecordingSlot) + scope * 2);
+
+		return scope;
+	}
+
+	void GpuProfiler::End(const VkCommandBuffer commandBuffer, const uint32_t scope) const
+	{
+		if (scope == UINT32_MAX)
+			return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, QueryPool,
+							GetFirstQuery(RecordingSlot) + scope * 2 + 1);
+	}
+
+	void GpuProfiler::Submit(const uint32_t slot)
+	{
+		auto& s = Slots[slot];
+
+		if (!IsEnabled() || s.Scopes.empty() || s.Pending)
+			return;
+
+		s.Pending = true;
+		Submitted.push_back(slot);
+	}
+
+	void GpuProfiler::Collect()
+	{
+		size_t collected = 0;
+
+		for (; collected < Submitted.size(); ++collected)
+		{
+			uint32_t slot = Submitted[collected];
+			auto& s = Slots[slot];
+
+			uint32_t queriesCount = s.Scopes.size() * 2;
+
+			//Slots finish in submission order, so the first unfinished one ends the read back
+			auto res = vkGetQueryPoolResults(App->Device, QueryPool, GetFirstQuery(slot), queriesCount,
+											 queriesCount * sizeof(uint64_t), Timestamps.data(),
+											 sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+			if (res != VK_SUCCESS)
+				break;
+
+			for (size_t i = 0; i < s.Scopes.size(); ++i)
+			{
+				uint64_t begin = static_cast<uint64_t>((Timestamps[i * 2] & ValidBitsMask) * TimestampPeriod);
+				uint64_t end = static_cast<uint64_t>((Timestamps[i * 2 + 1] & ValidBitsMask) * TimestampPeriod);
+
+				AddSample(s.Scopes[i], begin, std::max(begin, end));
+			}
+
+			s.Pending = false;
+		}
+
+		Submitted.erase(Submitted.begin(), Submitted.begin() + collected);
+	}
+
+	void GpuProfiler::AddSample(const char* name, const uint64_t begin, const uint64_t end)
+	{
+		auto& history = Histories[name];
+
+		float ms = (end - begin) / 1e6f;
+
+		if (history.Samples.size() < GpuProfilerHistory)
+			history.Samples.push_back(ms);
+		else
+			history.Samples[history.Next] = ms;
+
+		history.Next = (history.Next + 1) % GpuProfilerHistory;
+
+		if (TraceEvents.size() < MaxGpuTraceEvents)
+			TraceEvents.push_back({ name, begin, end, 1, QueueFamily });
+	}
+
+	inline GpuScopeStats ComputeStats(const std::string& name, std::vector<float> samples)
+	{
+		GpuScopeStats stats;
+		stats.Name = name;
+		stats.SamplesCount = samples.size();
+
+		if (samples.empty())
+			return stats;
+
+		std::sort(samples.begin(), samples.end());
+
+		auto percentile = [&](const float p)
+		{
+			size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5f);
+			return samples[index];
+		};
+
+		float sum = 0.0f;
+		for (auto s : samples)
+			sum += s;
+
+		stats.Average = sum / samples.size();
+		stats.P50 = percentile(0.50f);
+		stats.P95 = percentile(0.95f);
+		stats.P99 = percentile(0.99f);
+
+		return stats;
+	}
+
+	std::optional<GpuScopeStats> GpuProfiler::GetStats(const std::string& name) const
+	{
+		auto it = Histories.find(name);
+		if (it == Histories.end())
+			return std::nullopt;
+
+		return ComputeStats(name, it->second.Samples);
+	}
+
+	std::vector<GpuScopeStats> GpuProfiler::GetAllStats() const
+	{
+		std::vector<GpuScopeStats> stats;
+		stats.reserve(Histories.size());
+
+		for (const auto& [name, history] : Histories)
+			stats.push_back(ComputeStats(name, history.Samples));
+
+		return stats;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include "vrender.h"
+
+#include <optional>
+#include <unordered_map>
+
+#include "vulkan_app.h"
+#include "utils/trace.h"
+
+namespace vk
+{
+	constexpr uint32_t GpuProfilerHistory = 128;
+	constexpr size_t MaxGpuTraceEvents = 1 << 16;
+
+	//Milliseconds over the last GpuProfilerHistory samples of a scope
+	struct GpuScopeStats
+	{
+		std::string Name;
+
+		float Average = 0.0f;
+		float P50 = 0.0f;
+		float P95 = 0.0f;
+		float P99 = 0.0f;
+
+		uint32_t SamplesCount = 0;
+	};
+
+	//Timestamp pairs around named scopes of command buffers recorded for one queue family.
+	//Every in flight command buffer records into its own slot, results are read back once the gpu
+	//has written them, so nothing ever waits on the gpu
+	class GpuProfiler
+	{
+	private:
+		struct Slot
+		{
+			//Names have to outlive the profiler, e.g. string literals or frame graph pass names
+			std::vector<const char*> Scopes;
+			bool Pending = false;
+		};
+
+		struct History
+		{
+			std::vector<float> Samples;
+			uint32_t Next = 0;
+		};
+
+		VkQueryPool QueryPool = VK_NULL_HANDLE;
+		uint32_t MaxScopes;
+
+		uint64_t ValidBitsMask;
+		float TimestampPeriod;
+
+		uint32_t QueueFamily;
+
+		std::vector<Slot> Slots;
+		uint32_t RecordingSlot = 0;
+
+		//Submitted slots, oldest first
+		std::vector<uint32_t> Submitted;
+		std::vector<uint64_t> Timestamps;
+
+		std::unordered_map<std::string, History> Histories;
+		std::vector<utils::TraceEvent> TraceEvents;
+
+		vk::VulkanApp* App;
+
+		inline uint32_t GetFirstQuery(const uint32_t slot) const
+		{
+			return slot * MaxScopes * 2;
+		}
+
+		void AddSample(const char* name, const uint64_t begin, const uint64_t end);
+	public:
+		bool Setup(vk::VulkanApp& app, const uint32_t queueFamily, const uint32_t slotsCount, const uint32_t maxScopes);
+
+		void Cleanup() const;
+
+		//Has to be recorded outside of render passes, before any scope of the slot. Results of the slot
+		//that weren't read back yet are dropped
+		void BeginFrame(const VkCommandBuffer commandBuffer, const uint32_t slot);
+
+		//Returns the scope index for End, scopes past MaxScopes are ignored
+		uint32_t Begin(const VkCommandBuffer commandBuffer, const char* name);
+
+		void End(const VkCommandBuffer commandBuffer, const uint32_t scope) const;
+
+		//Slot is read back by Collect once the gpu is done with it
+		void Submit(const uint32_t slot);
+
+		//Doesn't wait, reads back every submitted slot the gpu has finished
+		void Collect();
+
+		std::optional<GpuScopeStats> GetStats(const std::string& name) const;
+
+		std::vector<GpuScopeStats> GetAllStats() const;
+
+		inline const std::vector<utils::TraceEvent>& GetTraceEvents() const
+		{
+			return TraceEvents;
+		}
+
+		inline bool IsEnabled() const
+		{
+			return QueryPool != VK_NULL_HANDLE;
+		}
+	};
+
+	//Scope of the slot currently being recorded, ends when it goes out of scope
+	class GpuScope
+	{
+	private:
+		GpuProfiler& Profiler;
+		VkCommandBuffer CommandBuffer;
+		uint32_t Index;
+	public:
+		inline GpuScope(GpuProfiler& profiler, const VkCommandBuffer commandBuffer, const char* name)
+			: Profiler(profiler), CommandBuffer(commandBuffer)
+		{
+			Index = Profiler.Begin(CommandBuffer, name);
+		}
+
+		inline ~GpuScope()
+		{
+			Profiler.End(CommandBuffer, Index);
+		}
+
+		GpuScope(const GpuScope&) = delete;
+		GpuScope& operator=(const GpuScope&) = delete;
+	};
+}
\ No newline at end of file
@@ -4,145 +4,6 @@
 
 namespace vk
 {
-	namespace layout
-	{
-		void SetImageLayoutFromUndefinedToTransfer(const vk::VulkanApp& app, const VkQueue queue,
-												   const VkCommandPool commandPool, const VkImage image, 
-												   const uint8_t mipLevels)
-		{
-			auto cmd = BeginCommands(app, commandPool);
-
-			VkImageMemoryBarrier barrier{};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.image = image;
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = mipLevels;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-								 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-			EndCommands(app, commandPool, cmd, queue);
-		}
-
-		void SetImageLayoutFromUndefinedToGraphicsShader(const vk::VulkanApp& app, const VkQueue queue,
-														 const VkCommandPool commandPool, const VkImage image, 
-														 const uint8_t mipLevels)
-		{
-			auto cmd = BeginCommands(app, commandPool);
-
-			VkImageMemoryBarrier barrier{};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.image = image;
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = mipLevels;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-				0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-			EndCommands(app, commandPool, cmd, queue);
-		}
-
-		void SetImageLayoutFromTransferToGraphicsShader(const vk::VulkanApp& app, const VkQueue queue,
-										                const VkCommandPool commandPool, const VkImage image, 
-														const uint8_t mipLevels)
-		{
-			auto cmd = BeginCommands(app, commandPool);
-
-			VkImageMemoryBarrier barrier{};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.image = image;
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = mipLevels;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-							     0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-			EndCommands(app, commandPool, cmd, queue);
-		}
-
-		void SetImageLayoutFromTransferToComputeRead(const vk::VulkanApp& app, const VkQueue queue,
-													 const VkCommandPool commandPool, const VkImage image, 
-													 const uint8_t mipLevels)
-		{
-			auto cmd = BeginCommands(app, commandPool);
-
-			VkImageMemoryBarrier barrier{};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.image = image;
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = mipLevels;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-				0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-			EndCommands(app, commandPool, cmd, queue);
-		}
-
-		void SetCubeImageLayoutFromComputeWriteToGraphicsShader(const vk::VulkanApp& app, const VkQueue queue,
-															    const VkCommandPool commandPool, const VkImage image, 
-																const uint8_t mipLevels)
-		{
-			auto cmd = BeginCommands(app, commandPool);
-
-			VkImageMemoryBarrier imageMemoryBarrier = {};
-			imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-
-			imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-			imageMemoryBarrier.image = image;
-			imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
-			imageMemoryBarrier.subresourceRange.levelCount = mipLevels;
-			imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
-			imageMemoryBarrier.subresourceRange.layerCount = 6;
-			imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-			imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-			imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-								 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-
-			EndCommands(app, commandPool, cmd, queue);
-		}
-	}
-
 	std::optional<std::vector<char>> ReadShader(const std::string& filename)
 	{
 		std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -217,8 +78,17 @@ namespace vk
 	{
 		auto commandBuffer = BeginCommands(app, app.CommandPoolGQ);
 
+		CmdCopyBufferToImage(commandBuffer, buffer, image, width, height);
+
+		EndCommands(app, app.CommandPoolGQ, commandBuffer, app.GraphicsQueue);
+	}
+
+	void CmdCopyBufferToImage(const VkCommandBuffer commandBuffer, const VkBuffer buffer,
+							  const VkImage image, const uint16_t width, const uint16_t height,
+							  const VkDeviceSize bufferOffset, const uint16_t rowOffset)
+	{
 		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
+		region.bufferOffset = bufferOffset;
 		region.bufferRowLength = 0;
 		region.bufferImageHeight = 0;
 
@@ -227,12 +97,29 @@ namespace vk
 		region.imageSubresource.baseArrayLayer = 0;
 		region.imageSubresource.layerCount = 1;
 
-		region.imageOffset = { 0, 0, 0 };
+		region.imageOffset = { 0, rowOffset, 0 };
 		region.imageExtent = { width, height, 1 };
 
 		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
 
-		EndCommands(app, app.CommandPoolGQ, commandBuffer, app.GraphicsQueue);
+	std::optional<VkSemaphore> CreateTimelineSemaphore(const VulkanApp& app, const uint64_t initialValue)
+	{
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = initialValue;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		VkSemaphore semaphore;
+
+		if (vkCreateSemaphore(app.Device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+			return std::nullopt;
+
+		return semaphore;
 	}
 
 	std::optional<VkRenderPass> CreateRenderPass(const VulkanApp& app, const std::vector<VkAttachmentDescription>& attachments,
@@ -277,6 +164,33 @@ namespace vk
 		return fbo;
 	}
 
+	std::optional<VkFramebuffer> CreateImagelessFramebuffer(const VulkanApp& app, const VkRenderPass& renderPass,
+															const std::vector<VkFramebufferAttachmentImageInfo>& attachments,
+															const uint16_t width, const uint16_t height)
+	{
+		VkFramebufferAttachmentsCreateInfo attachmentsInfo{};
+		attachmentsInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENTS_CREATE_INFO;
+		attachmentsInfo.attachmentImageInfoCount = attachments.size();
+		attachmentsInfo.pAttachmentImageInfos = attachments.data();
+
+		VkFramebufferCreateInfo fboInfo{};
+		fboInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		fboInfo.pNext = &attachmentsInfo;
+		fboInfo.flags = VK_FRAMEBUFFER_CREATE_IMAGELESS_BIT;
+		fboInfo.renderPass = renderPass;
+		fboInfo.attachmentCount = attachments.size();
+		fboInfo.width = width;
+		fboInfo.height = height;
+		fboInfo.layers = 1;
+
+		VkFramebuffer fbo;
+
+		if (vkCreateFramebuffer(app.Device, &fboInfo, nullptr, &fbo) != VK_SUCCESS)
+			return std::nullopt;
+
+		return fbo;
+	}
+
 	std::optional<Pipeline> CreateComputePipeline(const VulkanApp& app,
 												  const vk::ComputeShader& shader,
 												  const std::vector<VkDescriptorSetLayout>& layouts,
@@ -313,7 +227,8 @@ namespace vk
 												   const VkRenderPass& renderPass,
 												   const vk::Shader& shader,
 												   const std::vector< VkDescriptorSetLayout>& layouts,
-												   const GraphicsStates& states)
+												   const GraphicsStates& states,
+												   const uint32_t subpass)
 	{
 		VkPipelineLayout pipelineLayout;
 
@@ -325,12 +240,13 @@ namespace vk
 		if (vkCreatePipelineLayout(app.Device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 			return std::nullopt;
 
-		//Volatile keyword is needed because compiler optimize out structure members initialization
-		volatile VkGraphicsPipelineCreateInfo pipelineInfo{};
+		auto inputState = shader.GetInputState();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineInfo.stageCount = shader.GetStages().size();
 		pipelineInfo.pStages = shader.GetStages().data();
-		pipelineInfo.pVertexInputState = &shader.GetInputState();
+		pipelineInfo.pVertexInputState = &inputState;
 		pipelineInfo.pInputAssemblyState = &states.Assembly;
 		pipelineInfo.pViewportState = &states.Viewport;
 		pipelineInfo.pRasterizationState = &states.Rasterizer;
@@ -340,12 +256,12 @@ namespace vk
 		pipelineInfo.pDynamicState = &states.DynamicState;
 		pipelineInfo.layout = pipelineLayout;
 		pipelineInfo.renderPass = renderPass;
-		pipelineInfo.subpass = 0;
+		pipelineInfo.subpass = subpass;
 
 
 		VkPipeline pipeline;
 
-		if (vkCreateGraphicsPipelines(app.Device, VK_NULL_HANDLE, 1, const_cast<VkGraphicsPipelineCreateInfo*>(&pipelineInfo), nullptr, &pipeline) != VK_SUCCESS)
+		if (vkCreateGraphicsPipelines(app.Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
 			return std::nullopt;
 
 		return { { pipelineLayout, pipeline } };
@@ -10,25 +10,6 @@
 
 namespace vk
 {
-	namespace layout
-	{
-		void SetImageLayoutFromUndefinedToTransfer(const vk::VulkanApp& app, const VkQueue queue,
-												   const VkCommandPool commandPool, const VkImage image, 
-												   const uint8_t mipLevels = 1);
-		void SetImageLayoutFromUndefinedToGraphicsShader(const vk::VulkanApp& app, const VkQueue queue,
-														 const VkCommandPool commandPool, const VkImage image,
-														 const uint8_t mipLevels = 1);
-		void SetImageLayoutFromTransferToGraphicsShader(const vk::VulkanApp& app, const VkQueue queue,
-														const VkCommandPool commandPool, const VkImage image, 
-													    const uint8_t mipLevels = 1);
-		void SetImageLayoutFromTransferToComputeRead(const vk::VulkanApp& app, const VkQueue queue,
-													 const VkCommandPool commandPool, const VkImage image, 
-													 const uint8_t mipLevels = 1);
-		void SetCubeImageLayoutFromComputeWriteToGraphicsShader(const vk::VulkanApp& app, const VkQueue queue,
-																const VkCommandPool commandPool, const VkImage image, 
-																const uint8_t mipLevels = 1);
-	}
-
 	struct Pipeline
 	{
 		VkPipelineLayout Layout;
@@ -62,8 +43,13 @@ namespace vk
 
 	void CopyBufferToImage(const VulkanApp& app, const VkBuffer buffer, 
 						   const VkImage image, const uint16_t width, const uint16_t height);
+	void CmdCopyBufferToImage(const VkCommandBuffer commandBuffer, const VkBuffer buffer,
+							  const VkImage image, const uint16_t width, const uint16_t height,
+							  const VkDeviceSize bufferOffset = 0, const uint16_t rowOffset = 0);
 
 
+	std::optional<VkSemaphore> CreateTimelineSemaphore(const VulkanApp& app, const uint64_t initialValue = 0);
+
 	std::optional<VkRenderPass> CreateRenderPass(const VulkanApp& app, const std::vector<VkAttachmentDescription>& attachments,
 												 const std::vector<VkSubpassDescription>& subpasses,
 												 const std::vector<VkSubpassDependency>& dependencies);
@@ -72,6 +58,11 @@ namespace vk
 												   const std::vector<VkImageView>& attachments,
 												   const uint16_t width, const uint16_t height);
 
+	//Framebuffer only describes the attachments, views are given when the render pass begins
+	std::optional<VkFramebuffer> CreateImagelessFramebuffer(const VulkanApp& app, const VkRenderPass& renderPass,
+															const std::vector<VkFramebufferAttachmentImageInfo>& attachments,
+															const uint16_t width, const uint16_t height);
+
 	std::optional<Pipeline> CreateComputePipeline(const VulkanApp& app, 
 												  const vk::ComputeShader& shader, 
 												  const std::vector< VkDescriptorSetLayout>& layouts,
@@ -82,7 +73,8 @@ namespace vk
 												   const VkRenderPass& renderPass,
 												   const vk::Shader& shader,
 												   const std::vector<VkDescriptorSetLayout>& layouts,
-												   const GraphicsStates& states);
+												   const GraphicsStates& states,
+												   const uint32_t subpass = 0);
 
 	void RunComputeShader(const VulkanApp& app, const vk::ComputeShader& cs, const Descriptor& descriptor, 
 					      const uint16_t workGroupsX, const uint16_t workGroupsY, const uint16_t workGroupsZ);
@@ -95,6 +87,14 @@ namespace vk
 			return func(cmdBuffer, value);
 	}
 
+	inline void CmdPipelineBarrier2(const VulkanApp& app, const VkCommandBuffer& cmdBuffer,
+									const VkDependencyInfoKHR& dependency)
+	{
+		auto func = (PFN_vkCmdPipelineBarrier2KHR)vkGetInstanceProcAddr(app.Instance, "vkCmdPipelineBarrier2KHR");
+		if (func != nullptr)
+			return func(cmdBuffer, &dependency);
+	}
+
 	inline void CmdSetCullMode(const VulkanApp& app, const VkCommandBuffer& cmdBuffer,
 							   const VkCullModeFlags cullmode)
 	{
@@ -2,6 +2,8 @@
 
 #include "helpers.h"
 
+#include <set>
+
 namespace vk
 {
 	bool Image::Setup(VulkanApp& app, const VkImageType type, const VkImageViewType viewType, const VkFormat format, 
@@ -15,6 +17,10 @@ namespace vk
 		Height = height;
 
 		MipLevels = mipLevels;
+		LayersCount = layersCount;
+
+		States = std::make_shared<ImageStateTracker>();
+		States->Setup(mipLevels, layersCount, viewAspect);
 
 		VkImageCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -32,6 +38,21 @@ namespace vk
 		createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		createInfo.flags = flags;
 
+		//Storage images are written on the compute queue and read on the others,
+		//concurrent sharing saves ownership transfers between them
+		std::set<uint32_t> families = { (uint32_t)app.QueueFamilies.Graphics, (uint32_t)app.QueueFamilies.Compute,
+										(uint32_t)app.QueueFamilies.Transfer };
+		std::vector<uint32_t> familyIndices(families.begin(), families.end());
+
+		Concurrent = (usage & VK_IMAGE_USAGE_STORAGE_BIT) && familyIndices.size() > 1;
+
+		if (Concurrent)
+		{
+			createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			createInfo.queueFamilyIndexCount = familyIndices.size();
+			createInfo.pQueueFamilyIndices = familyIndices.data();
+		}
+
 		if (vkCreateImage(app.Device, &createInfo, nullptr, &Image) != VK_SUCCESS)
 			return false;
 
@@ -1,6 +1,9 @@
 #pragma once
 #include "vrender.h"
 #include "buffer.h"
+#include "image_state.h"
+
+#include <memory>
 
 enum class IC
 {
@@ -61,13 +64,19 @@ namespace vk
 		uint16_t Height;
 
 		uint8_t MipLevels;
+		uint16_t LayersCount;
+
+		bool Concurrent = false;
+
+		//Shared, so copies of the image see each other's transitions
+		std::shared_ptr<ImageStateTracker> States;
 
 		VulkanApp* App;
 	public:
-		bool Image::Setup(VulkanApp& app, const VkImageType type, const VkImageViewType viewType, 
-						  const VkFormat format, const VkImageUsageFlags usage, const VkImageAspectFlags& viewAspect,
-						  const uint16_t width, const uint16_t height, const uint16_t depth, const uint16_t layersCount,
-						  const VkFlags flags, const ImageChannels channels, const uint8_t mipLevels);
+		bool Setup(VulkanApp& app, const VkImageType type, const VkImageViewType viewType, 
+				   const VkFormat format, const VkImageUsageFlags usage, const VkImageAspectFlags& viewAspect,
+				   const uint16_t width, const uint16_t height, const uint16_t depth, const uint16_t layersCount,
+				   const VkFlags flags, const ImageChannels channels, const uint8_t mipLevels);
 
 		void Cleanup() const;
 
@@ -95,5 +104,21 @@ namespace vk
 		{
 			return MipLevels;
 		}
+
+		inline bool IsConcurrent() const
+		{
+			return Concurrent;
+		}
+
+		inline void Transition(BarrierBatch& batch, const ImageUsage usage, const ImageRange& range = {},
+							   const bool discard = false)
+		{
+			States->Transition(Image, batch, usage, range, discard);
+		}
+
+		inline void Assume(const ImageState& state, const ImageRange& range = {})
+		{
+			States->Assume(state, range);
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "image_state.h"
+
+#include "helpers.h"
+
+namespace vk
+{
+	ImageState GetImageUsageState(const ImageUsage usage)
+	{
+		ImageState state;
+
+		switch (usage)
+		{
+		case ImageUsage::Undefined:
+			break;
+		case ImageUsage::TransferSrc:
+			state.Layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			state.Access = VK_ACCESS_TRANSFER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			break;
+		case ImageUsage::TransferDst:
+			state.Layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			state.Access = VK_ACCESS_TRANSFER_WRITE_BIT;
+			state.Stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			break;
+		case ImageUsage::SampledGraphics:
+			state.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			state.Access = VK_ACCESS_SHADER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			break;
+		case ImageUsage::SampledCompute:
+			state.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			state.Access = VK_ACCESS_SHADER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			break;
+		case ImageUsage::StorageRead:
+			state.Layout = VK_IMAGE_LAYOUT_GENERAL;
+			state.Access = VK_ACCESS_SHADER_READ_BIT;
+			state.Stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			break;
+		case ImageUsage::StorageWrite:
+			state.Layout = VK_IMAGE_LAYOUT_GENERAL;
+			state.Access = VK_ACCESS_SHADER_WRITE_BIT;
+			state.Stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			break;
+		case ImageUsage::ColorAttachment:
+			state.Layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			state.Access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			state.Stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			break;
+		case ImageUsage::DepthAttachment:
+			state.Layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			state.Access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			state.Stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			break;
+		case ImageUsage::Present:
+			state.Layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			state.Stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			break;
+		}
+
+		return state;
+	}
+
+	inline VkAccessFlags GetWriteAccess(const VkAccessFlags access)
+	{
+		const VkAccessFlags writeMask = VK_ACCESS_SHADER_WRITE_BIT
+										| VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+										| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+										| VK_ACCESS_TRANSFER_WRITE_BIT
+										| VK_ACCESS_HOST_WRITE_BIT
+										| VK_ACCESS_MEMORY_WRITE_BIT;
+
+		return access & writeMask;
+	}
+
+	void BarrierBatch::Add(const VkImage image, const VkImageAspectFlags aspect, const ImageState& src, const ImageState& dst,
+						   const uint32_t baseMip, const uint32_t mipsCount, const uint32_t layer)
+	{
+		//Same transition of the same mips on the next layer extends the previous barrier
+		if (!ImageBarriers.empty())
+		{
+			auto& last = ImageBarriers.back();
+			const auto& range = last.subresourceRange;
+
+			if (last.image == image
+				&& range.baseMipLevel == baseMip && range.levelCount == mipsCount
+				&& range.baseArrayLayer + range.layerCount == layer
+				&& last.oldLayout == src.Layout && last.newLayout == dst.Layout
+				&& last.srcStageMask == src.Stage && last.srcAccessMask == GetWriteAccess(src.Access)
+				&& last.dstStageMask == dst.Stage && last.dstAccessMask == dst.Access)
+			{
+				++last.subresourceRange.layerCount;
+				return;
+			}
+		}
+
+		VkImageMemoryBarrier2KHR barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		barrier.srcStageMask = src.Stage;
+		//Only writes have to be made available, reads just need the execution dependency
+		barrier.srcAccessMask = GetWriteAccess(src.Access);
+		barrier.dstStageMask = dst.Stage;
+		barrier.dstAccessMask = dst.Access;
+		barrier.oldLayout = src.Layout;
+		barrier.newLayout = dst.Layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = aspect;
+		barrier.subresourceRange.baseMipLevel = baseMip;
+		barrier.subresourceRange.levelCount = mipsCount;
+		barrier.subresourceRange.baseArrayLayer = layer;
+		barrier.subresourceRange.layerCount = 1;
+
+		ImageBarriers.push_back(barrier);
+	}
+
+	void BarrierBatch::Flush(const vk::VulkanApp& app, const VkCommandBuffer commandBuffer)
+	{
+		if (ImageBarriers.empty())
+			return;
+
+		if (app.Features.Synchronization2)
+		{
+			VkDependencyInfoKHR dependency{};
+			dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+			dependency.imageMemoryBarrierCount = ImageBarriers.size();
+			dependency.pImageMemoryBarriers = ImageBarriers.data();
+
+			vk::CmdPipelineBarrier2(app, commandBuffer, dependency);
+		}
+		else
+		{
+			std::vector<VkImageMemoryBarrier> barriers(ImageBarriers.size());
+
+			VkPipelineStageFlags srcStage = 0;
+			VkPipelineStageFlags dstStage = 0;
+
+			for (size_t i = 0; i < ImageBarriers.size(); ++i)
+			{
+				const auto& b = ImageBarriers[i];
+
+				srcStage |= b.srcStageMask;
+				dstStage |= b.dstStageMask;
+
+				barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barriers[i].srcAccessMask = b.srcAccessMask;
+				barriers[i].dstAccessMask = b.dstAccessMask;
+				barriers[i].oldLayout = b.oldLayout;
+				barriers[i].newLayout = b.newLayout;
+				barriers[i].srcQueueFamilyIndex = b.srcQueueFamilyIndex;
+				barriers[i].dstQueueFamilyIndex = b.dstQueueFamilyIndex;
+				barriers[i].image = b.image;
+				barriers[i].subresourceRange = b.subresourceRange;
+			}
+
+			vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr,
+								 barriers.size(), barriers.data());
+		}
+
+		ImageBarriers.clear();
+	}
+
+	void ImageStateTracker::Setup(const uint32_t mipLevels, const uint32_t layersCount, const VkImageAspectFlags aspect)
+	{
+		MipLevels = mipLevels;
+		LayersCount = layersCount;
+		Aspect = aspect;
+
+		States.assign(mipLevels * layersCount, ImageState());
+	}
+
+	void ImageStateTracker::Transition(const VkImage image, BarrierBatch& batch, const ImageUsage usage,
+									   const ImageRange& range, const bool discard)
+	{
+		const auto target = GetImageUsageState(usage);
+
+		const uint32_t mipEnd = range.BaseMip + std::min(range.MipsCount, MipLevels - range.BaseMip);
+		const uint32_t layerEnd = range.BaseLayer + std::min(range.LayersCount, LayersCount - range.BaseLayer);
+
+		for (uint32_t layer = range.BaseLayer; layer < layerEnd; ++layer)
+		{
+			uint32_t mip = range.BaseMip;
+
+			while (mip < mipEnd)
+			{
+				auto& state = GetState(mip, layer);
+
+				bool readOnly = !GetWriteAccess(state.Access) && !GetWriteAccess(target.Access);
+
+				if (state.Layout == target.Layout && readOnly)
+				{
+					state.Access |= target.Access;
+					state.Stage |= target.Stage;
+
+					++mip;
+					continue;
+				}
+
+				auto src = state;
+
+				uint32_t count = 1;
+				while (mip + count < mipEnd && GetState(mip + count, layer) == src)
+					++count;
+
+				if (discard)
+					src.Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+				batch.Add(image, Aspect, src, target, mip, count, layer);
+
+				for (uint32_t i = 0; i < count; ++i)
+					GetState(mip + i, layer) = target;
+
+				mip += count;
+			}
+		}
+	}
+
+	void ImageStateTracker::Assume(const ImageState& state, const ImageRange& range)
+	{
+		const uint32_t mipEnd = range.BaseMip + std::min(range.MipsCount, MipLevels - range.BaseMip);
+		const uint32_t layerEnd = range.BaseLayer + std::min(range.LayersCount, LayersCount - range.BaseLayer);
+
+		for (uint32_t layer = range.BaseLayer; layer < layerEnd; ++layer)
+		{
+			for (uint32_t mip = range.BaseMip; mip < mipEnd; ++mip)
+				GetState(mip, layer) = state;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+#include "vrender.h"
+
+#include "vulkan_app.h"
+
+namespace vk
+{
+	enum class ImageUsage
+	{
+		Undefined,
+		TransferSrc,
+		TransferDst,
+		SampledGraphics,
+		SampledCompute,
+		StorageRead,
+		StorageWrite,
+		ColorAttachment,
+		DepthAttachment,
+		Present
+	};
+
+	struct ImageState
+	{
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkAccessFlags Access = 0;
+		VkPipelineStageFlags Stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	};
+
+	inline bool operator==(const ImageState& a, const ImageState& b)
+	{
+		return a.Layout == b.Layout && a.Access == b.Access && a.Stage == b.Stage;
+	}
+
+	ImageState GetImageUsageState(const ImageUsage usage);
+
+	//Counts are clamped to the image, so the default range covers every mip and layer
+	struct ImageRange
+	{
+		uint32_t BaseMip = 0;
+		uint32_t MipsCount = VK_REMAINING_MIP_LEVELS;
+		uint32_t BaseLayer = 0;
+		uint32_t LayersCount = VK_REMAINING_ARRAY_LAYERS;
+	};
+
+	//Collects image barriers from several transitions and records them with one call
+	class BarrierBatch
+	{
+	private:
+		std::vector<VkImageMemoryBarrier2KHR> ImageBarriers;
+	public:
+		void Add(const VkImage image, const VkImageAspectFlags aspect, const ImageState& src, const ImageState& dst,
+				 const uint32_t baseMip, const uint32_t mipsCount, const uint32_t layer);
+
+		//Uses synchronization2 when the device supports it, otherwise merges the stages of all barriers
+		void Flush(const vk::VulkanApp& app, const VkCommandBuffer commandBuffer);
+
+		inline bool IsEmpty() const
+		{
+			return ImageBarriers.empty();
+		}
+	};
+
+	//Current layout, access and stage of every mip of every layer
+	class ImageStateTracker
+	{
+	private:
+		std::vector<ImageState> States;
+
+		uint32_t MipLevels;
+		uint32_t LayersCount;
+		VkImageAspectFlags Aspect;
+
+		inline ImageState& GetState(const uint32_t mip, const uint32_t layer)
+		{
+			return States[layer * MipLevels + mip];
+		}
+	public:
+		void Setup(const uint32_t mipLevels, const uint32_t layersCount, const VkImageAspectFlags aspect);
+
+		//Reads in the same layout only extend the state, anything else adds a barrier for each run of mips with equal state.
+		//Discard drops the old content, e.g. before the whole image is overwritten
+		void Transition(const VkImage image, BarrierBatch& batch, const ImageUsage usage,
+						const ImageRange& range, const bool discard);
+
+		//For transitions done outside of the tracker, e.g. queue ownership transfers
+		void Assume(const ImageState& state, const ImageRange& range);
+
+		inline ImageState Get(const uint32_t mip, const uint32_t layer) const
+		{
+			return States[layer * MipLevels + mip];
+		}
+	};
+}
\ No newline at end of file
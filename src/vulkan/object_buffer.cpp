@@ -0,0 +1,98 @@
+#include "object_buffer.h"
+
+#include "helpers.h"
+
+namespace vk
+{
+	void ObjectBuffer::Setup(vk::VulkanApp& app, const VkDeviceSize elementSize, const uint32_t copiesCount,
+							 const uint32_t slotsPerChunk)
+	{
+		VulkanApp = &app;
+
+		ElementSize = elementSize;
+		SlotsPerChunk = slotsPerChunk;
+		CopiesCount = copiesCount;
+
+		//Descriptors can only point at offsets with the device alignment
+		VkDeviceSize alignment = std::max<VkDeviceSize>(app.DeviceProperties.limits.minUniformBufferOffsetAlignment, 1);
+		Stride = (elementSize + alignment - 1) / alignment * alignment;
+	}
+
+	void ObjectBuffer::Cleanup() const
+	{
+		for (const auto& c : Chunks)
+		{
+			vkUnmapMemory(VulkanApp->Device, c.BufferMemory);
+
+			vkDestroyBuffer(VulkanApp->Device, c.BufferH, nullptr);
+			vkFreeMemory(VulkanApp->Device, c.BufferMemory, nullptr);
+		}
+	}
+
+	bool ObjectBuffer::AddChunk()
+	{
+		PROFILE_ZONE("ObjectBuffer::AddChunk");
+
+		Chunk chunk;
+
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = Stride * SlotsPerChunk * CopiesCount;
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(VulkanApp->Device, &bufferCreateInfo, nullptr, &chunk.BufferH) != VK_SUCCESS)
+			return false;
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(VulkanApp->Device, chunk.BufferH, &memRequirements);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memRequirements.size;
+		allocInfo.memoryTypeIndex = FindMemoryType(*VulkanApp, memRequirements.memoryTypeBits,
+												   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+												   | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		if (vkAllocateMemory(VulkanApp->Device, &allocInfo, nullptr, &chunk.BufferMemory) != VK_SUCCESS)
+		{
+			vkDestroyBuffer(VulkanApp->Device, chunk.BufferH, nullptr);
+			return false;
+		}
+
+		vkBindBufferMemory(VulkanApp->Device, chunk.BufferH, chunk.BufferMemory, 0);
+
+		void* mapPtr;
+		if (vkMapMemory(VulkanApp->Device, chunk.BufferMemory, 0, VK_WHOLE_SIZE, 0, &mapPtr) != VK_SUCCESS)
+		{
+			vkDestroyBuffer(VulkanApp->Device, chunk.BufferH, nullptr);
+			vkFreeMemory(VulkanApp->Device, chunk.BufferMemory, nullptr);
+			return false;
+		}
+
+		chunk.Mapped = static_cast<uint8_t*>(mapPtr);
+
+		Chunks.push_back(chunk);
+		SlotsCount += SlotsPerChunk;
+
+		//Handed out lowest first
+		for (uint32_t i = SlotsCount; i > SlotsCount - SlotsPerChunk; --i)
+			FreeSlots.push_back(i - 1);
+
+		return true;
+	}
+
+	std::optional<uint32_t> ObjectBuffer::Allocate()
+	{
+		if (FreeSlots.empty() && !AddChunk())
+		{
+			LOGE("Couldn't allocate object buffer chunk!");
+			return std::nullopt;
+		}
+
+		uint32_t slot = FreeSlots.back();
+		FreeSlots.pop_back();
+
+		return slot;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include "vrender.h"
+
+#include <optional>
+
+#include "vulkan_app.h"
+
+namespace vk
+{
+	constexpr uint32_t ObjectBufferChunkSlots = 4096;
+
+	//Persistently mapped uniform memory with one aligned slot per object, written directly from the cpu.
+	//Every slot has a number of copies, e.g. one per swapchain image, so frames in flight read their own.
+	//Grows in chunks that never move, so descriptors pointing into a slot stay valid
+	class ObjectBuffer
+	{
+	private:
+		struct Chunk
+		{
+			VkBuffer BufferH;
+			VkDeviceMemory BufferMemory;
+			uint8_t* Mapped;
+		};
+
+		std::vector<Chunk> Chunks;
+		std::vector<uint32_t> FreeSlots;
+
+		uint32_t SlotsCount = 0;
+		uint32_t SlotsPerChunk;
+		uint32_t CopiesCount;
+
+		VkDeviceSize ElementSize;
+		VkDeviceSize Stride;
+
+		vk::VulkanApp* VulkanApp;
+
+		bool AddChunk();
+	public:
+		void Setup(vk::VulkanApp& app, const VkDeviceSize elementSize, const uint32_t copiesCount,
+				   const uint32_t slotsPerChunk = ObjectBufferChunkSlots);
+
+		void Cleanup() const;
+
+		std::optional<uint32_t> Allocate();
+
+		//Slot can be handed out again right away, callers make sure the gpu is done with it
+		inline void Release(const uint32_t slot)
+		{
+			FreeSlots.push_back(slot);
+		}
+
+		//Copies of a chunk's slots follow each other
+		inline VkDeviceSize GetSlotOffset(const uint32_t slot, const uint32_t copy) const
+		{
+			return (copy * SlotsPerChunk + slot % SlotsPerChunk) * Stride;
+		}
+
+		inline uint8_t* GetSlotData(const uint32_t slot, const uint32_t copy) const
+		{
+			return Chunks[slot / SlotsPerChunk].Mapped + GetSlotOffset(slot, copy);
+		}
+
+		inline VkDescriptorBufferInfo GetBufferInfo(const uint32_t slot, const uint32_t copy) const
+		{
+			VkDescriptorBufferInfo info{};
+			info.buffer = Chunks[slot / SlotsPerChunk].BufferH;
+			info.offset = GetSlotOffset(slot, copy);
+			info.range = ElementSize;
+
+			return info;
+		}
+
+		inline uint32_t GetCopiesCount() const
+		{
+			return CopiesCount;
+		}
+
+		inline VkDeviceSize GetStride() const
+		{
+			return Stride;
+		}
+
+		inline uint32_t GetAllocatedCount() const
+		{
+			return SlotsCount - FreeSlots.size();
+		}
+	};
+}
\ No newline at end of file
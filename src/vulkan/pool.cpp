@@ -52,6 +52,8 @@ namespace vk
 			ASSERT(PushDescriptorPool(), "Couldn't create descriptor pool!");
 			LastlyUsedPoolId++;
 
+			allocInfo.descriptorPool = DescriptorPools[LastlyUsedPoolId];
+
 			auto res = vkAllocateDescriptorSets(App->Device, &allocInfo, &descriptors[0]);
 			ASSERT(res == VK_SUCCESS, "Error in descriptor set allocation!");
 		}
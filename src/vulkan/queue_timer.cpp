@@ -0,0 +1,78 @@
+#include "queue_timer.h"
+
+namespace vk
+{
+	bool QueueTimer::Setup(vk::VulkanApp& app, const uint32_t queueFamily, const uint32_t slotsCount)
+	{
+		App = &app;
+		SlotsCount = slotsCount;
+		TimestampPeriod = app.DeviceProperties.limits.timestampPeriod;
+
+		uint32_t queuesCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(app.PhysicalDevice, &queuesCount, nullptr);
+
+		std::vector<VkQueueFamilyProperties> properties(queuesCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(app.PhysicalDevice, &queuesCount, &properties[0]);
+
+		uint32_t validBits = properties[queueFamily].timestampValidBits;
+
+		//Queue can't write timestamps, timer stays disabled
+		if (validBits == 0)
+		{
+			LOGW("Queue family %d doesn't support timestamps!", queueFamily);
+			return true;
+		}
+
+		ValidBitsMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = SlotsCount * 2;
+
+		return vkCreateQueryPool(app.Device, &poolInfo, nullptr, &QueryPool) == VK_SUCCESS;
+	}
+
+	void QueueTimer::Cleanup() const
+	{
+		if (IsEnabled())
+			vkDestroyQueryPool(App->Device, QueryPool, nullptr);
+	}
+
+	void QueueTimer::Begin(const VkCommandBuffer commandBuffer, const uint32_t slot) const
+	{
+		if (!IsEnabled())
+			return;
+
+		vkCmdResetQueryPool(commandBuffer, QueryPool, slot * 2, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, QueryPool, slot * 2);
+	}
+
+	void QueueTimer::End(const VkCommandBuffer commandBuffer, const uint32_t slot) const
+	{
+		if (!IsEnabled())
+			return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, QueryPool, slot * 2 + 1);
+	}
+
+	std::optional<QueueTimeRange> QueueTimer::Resolve(const uint32_t slot) const
+	{
+		if (!IsEnabled())
+			return std::nullopt;
+
+		uint64_t timestamps[2];
+
+		auto res = vkGetQueryPoolResults(App->Device, QueryPool, slot * 2, 2, sizeof(timestamps), timestamps,
+										 sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+		if (res != VK_SUCCESS)
+			return std::nullopt;
+
+		QueueTimeRange range;
+		range.Begin = static_cast<uint64_t>((timestamps[0] & ValidBitsMask) * TimestampPeriod);
+		range.End = static_cast<uint64_t>((timestamps[1] & ValidBitsMask) * TimestampPeriod);
+
+		return range;
+	}
+}
\ No newline at end of file
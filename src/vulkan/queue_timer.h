@@ -0,0 +1,59 @@
+#pragma once
+#include "vrender.h"
+
+#include <optional>
+
+#include "vulkan_app.h"
+
+namespace vk
+{
+	//Gpu time in nanoseconds, queues of one device share the same time domain
+	struct QueueTimeRange
+	{
+		uint64_t Begin = 0;
+		uint64_t End = 0;
+	};
+
+	inline uint64_t GetOverlap(const QueueTimeRange& a, const QueueTimeRange& b)
+	{
+		uint64_t begin = std::max(a.Begin, b.Begin);
+		uint64_t end = std::min(a.End, b.End);
+
+		return end > begin ? end - begin : 0;
+	}
+
+	//Writes a pair of timestamps around the work recorded into a command buffer, each in flight
+	//command buffer needs its own slot
+	class QueueTimer
+	{
+	private:
+		VkQueryPool QueryPool = VK_NULL_HANDLE;
+		uint32_t SlotsCount;
+
+		uint64_t ValidBitsMask;
+		float TimestampPeriod;
+
+		vk::VulkanApp* App;
+	public:
+		bool Setup(vk::VulkanApp& app, const uint32_t queueFamily, const uint32_t slotsCount);
+
+		void Cleanup() const;
+
+		void Begin(const VkCommandBuffer commandBuffer, const uint32_t slot) const;
+
+		void End(const VkCommandBuffer commandBuffer, const uint32_t slot) const;
+
+		//Doesn't wait, returns nothing until the gpu has written both timestamps
+		std::optional<QueueTimeRange> Resolve(const uint32_t slot) const;
+
+		inline bool IsEnabled() const
+		{
+			return QueryPool != VK_NULL_HANDLE;
+		}
+
+		inline uint32_t GetSlotsCount() const
+		{
+			return SlotsCount;
+		}
+	};
+}
\ No newline at end of file
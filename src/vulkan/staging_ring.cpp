@@ -0,0 +1,95 @@
+#include "staging_ring.h"
+
+#include "helpers.h"
+
+namespace vk
+{
+	bool StagingRing::Setup(vk::VulkanApp& app, const VkDeviceSize capacity)
+	{
+		VulkanApp = &app;
+		Capacity = capacity;
+
+		VkBufferCreateInfo bufferCreateInfo{};
+		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCreateInfo.size = Capacity;
+		bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(app.Device, &bufferCreateInfo, nullptr, &BufferH) != VK_SUCCESS)
+			return false;
+
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(app.Device, BufferH, &memRequirements);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memRequirements.size;
+		allocInfo.memoryTypeIndex = FindMemoryType(app, memRequirements.memoryTypeBits,
+												   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+												   | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		if (vkAllocateMemory(app.Device, &allocInfo, nullptr, &BufferMemory) != VK_SUCCESS)
+			return false;
+
+		vkBindBufferMemory(app.Device, BufferH, BufferMemory, 0);
+
+		void* mapPtr;
+		if (vkMapMemory(app.Device, BufferMemory, 0, Capacity, 0, &mapPtr) != VK_SUCCESS)
+			return false;
+
+		Mapped = static_cast<uint8_t*>(mapPtr);
+
+		return true;
+	}
+
+	void StagingRing::Cleanup() const
+	{
+		vkUnmapMemory(VulkanApp->Device, BufferMemory);
+
+		vkDestroyBuffer(VulkanApp->Device, BufferH, nullptr);
+		vkFreeMemory(VulkanApp->Device, BufferMemory, nullptr);
+	}
+
+	std::optional<StagingRegion> StagingRing::Allocate(const VkDeviceSize size, const VkDeviceSize alignment, const uint64_t ticket)
+	{
+		if (size == 0 || size > Capacity)
+			return std::nullopt;
+
+		VkDeviceSize freeSize = Capacity - Used;
+
+		VkDeviceSize offset = (Head + alignment - 1) / alignment * alignment;
+		VkDeviceSize bytes = offset - Head + size;
+
+		//Tail of the buffer is too small, skip it and start from the beginning
+		if (offset + size > Capacity)
+		{
+			offset = 0;
+			bytes = Capacity - Head + size;
+		}
+
+		if (bytes > freeSize)
+			return std::nullopt;
+
+		Head = offset + size;
+		Used += bytes;
+
+		if (!Usages.empty() && Usages.back().Ticket == ticket)
+			Usages.back().Bytes += bytes;
+		else
+			Usages.push_back({ ticket, bytes });
+
+		return StagingRegion{ offset, size, Mapped + offset };
+	}
+
+	void StagingRing::Release(const uint64_t completedTicket)
+	{
+		while (!Usages.empty() && Usages.front().Ticket <= completedTicket)
+		{
+			Used -= Usages.front().Bytes;
+			Usages.pop_front();
+		}
+
+		if (Used == 0)
+			Head = 0;
+	}
+}
\ No newline at end of file
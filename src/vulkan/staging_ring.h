@@ -0,0 +1,67 @@
+#pragma once
+#include "vrender.h"
+
+#include <deque>
+#include <optional>
+
+#include "vulkan_app.h"
+
+namespace vk
+{
+	constexpr VkDeviceSize StagingRingSize = 32 * 1024 * 1024;
+
+	struct StagingRegion
+	{
+		VkDeviceSize Offset;
+		VkDeviceSize Size;
+		void* Data;
+	};
+
+	//Persistently mapped staging buffer, regions are handed out in order and released in the same order
+	//once the upload that used them is completed
+	class StagingRing
+	{
+	private:
+		struct RegionUsage
+		{
+			uint64_t Ticket;
+			VkDeviceSize Bytes;
+		};
+
+		VkBuffer BufferH;
+		VkDeviceMemory BufferMemory;
+		uint8_t* Mapped;
+
+		VkDeviceSize Capacity;
+		VkDeviceSize Head = 0;
+		VkDeviceSize Used = 0;
+
+		std::deque<RegionUsage> Usages;
+
+		vk::VulkanApp* VulkanApp;
+	public:
+		bool Setup(vk::VulkanApp& app, const VkDeviceSize capacity = StagingRingSize);
+
+		void Cleanup() const;
+
+		//Fails if there is no free space left until older regions are released
+		std::optional<StagingRegion> Allocate(const VkDeviceSize size, const VkDeviceSize alignment, const uint64_t ticket);
+
+		void Release(const uint64_t completedTicket);
+
+		inline VkBuffer GetHandler() const
+		{
+			return BufferH;
+		}
+
+		inline VkDeviceSize GetCapacity() const
+		{
+			return Capacity;
+		}
+
+		inline VkDeviceSize GetUsedSize() const
+		{
+			return Used;
+		}
+	};
+}
\ No newline at end of file
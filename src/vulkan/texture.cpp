@@ -1,23 +1,11 @@
 #include "texture.h"
 
-#include "vulkan/buffer.h"
 #include "vulkan/helpers.h"
 
 namespace vk
 {
-	bool Texture::Setup(vk::VulkanApp& app, const uint16_t width, const uint16_t height,
-						const TextureImageInfo& imageInfo, const TextureParams& params,
-						const uint16_t depth, const uint16_t layersCount, const uint8_t mipLevels)
-	{ 
-		App = &app;
-
-		if (!Image.Setup(app, imageInfo.Type, imageInfo.ViewType, imageInfo.Format,
-						 imageInfo.UsageFlags, imageInfo.ViewAspect,
-						 width, height, depth, layersCount, imageInfo.CreateFlags, imageInfo.Channels, mipLevels))
-		{
-			return false;
-		}
-
+	std::optional<VkSampler> CreateSampler(const vk::VulkanApp& app, const TextureParams& params)
+	{
 		VkSamplerCreateInfo samplerCreateInfo{};
 		samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
 		samplerCreateInfo.magFilter = params.MagFilter;
@@ -36,9 +24,32 @@ namespace vk
 		samplerCreateInfo.minLod = 0.0f;
 		samplerCreateInfo.maxLod = 0.0f;
 
-		if (vkCreateSampler(app.Device, &samplerCreateInfo, nullptr, &Sampler) != VK_SUCCESS)
+		VkSampler sampler;
+		if (vkCreateSampler(app.Device, &samplerCreateInfo, nullptr, &sampler) != VK_SUCCESS)
+			return std::nullopt;
+
+		return sampler;
+	}
+
+	bool Texture::Setup(vk::VulkanApp& app, const uint16_t width, const uint16_t height,
+						const TextureImageInfo& imageInfo, const TextureParams& params,
+						const uint16_t depth, const uint16_t layersCount, const uint8_t mipLevels)
+	{ 
+		App = &app;
+
+		if (!Image.Setup(app, imageInfo.Type, imageInfo.ViewType, imageInfo.Format,
+						 imageInfo.UsageFlags, imageInfo.ViewAspect,
+						 width, height, depth, layersCount, imageInfo.CreateFlags, imageInfo.Channels, mipLevels))
+		{
+			return false;
+		}
+
+		auto samplerRes = CreateSampler(app, params);
+		if (!samplerRes)
 			return false;
 
+		Sampler = *samplerRes;
+
 
 		VkDescriptorImageInfo info{};
 		info.imageLayout = imageInfo.Layout;
@@ -51,17 +62,34 @@ namespace vk
 		return true;
 	}
 
-	void Texture::Update(void* data, const size_t pixelStride)
+	void Texture::Update(vk::UploadContext& uploads, void* data, const size_t pixelStride,
+						 const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess)
 	{
-		Buffer buffer;
-		buffer.Setup(*App, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, pixelStride, Image.GetWidth() * Image.GetHeight());
+		const size_t rowSize = pixelStride * Image.GetWidth();
+		const uint16_t rowsPerChunk = std::max<size_t>(1, std::min<size_t>(uploads.GetMaxChunkSize() / rowSize, Image.GetHeight()));
+
+		const auto* src = static_cast<const uint8_t*>(data);
+
+		//Whole image is overwritten, the old content doesn't have to be preserved
+		BarrierBatch batch;
+		Image.Transition(batch, ImageUsage::TransferDst, {}, true);
+		batch.Flush(*App, uploads.GetCommandBuffer());
 
-		buffer.Update(data, Image.GetWidth() * Image.GetHeight());
+		//Rows are streamed through the staging ring in chunks
+		for (uint32_t row = 0; row < Image.GetHeight(); row += rowsPerChunk)
+		{
+			uint16_t rowsCount = std::min<uint32_t>(rowsPerChunk, Image.GetHeight() - row);
+
+			auto region = uploads.AllocateStaging(rowSize * rowsCount, pixelStride * 4);
+			memcpy(region.Data, src + rowSize * row, rowSize * rowsCount);
+
+			CmdCopyBufferToImage(uploads.GetCommandBuffer(), uploads.GetStagingBuffer(), Image.GetHandler(),
+								 Image.GetWidth(), rowsCount, region.Offset, row);
+		}
 
-		layout::SetImageLayoutFromUndefinedToTransfer(*App, App->GraphicsQueue, App->CommandPoolGQ, Image.GetHandler());
-		CopyBufferToImage(*App, buffer.GetHandler(), Image.GetHandler(), Image.GetWidth(), Image.GetHeight());
+		uploads.HandOffImage(Image.GetHandler(), Image.GetMipLevels(), 1, ImageInfo.Layout, dstStage, dstAccess, Image.IsConcurrent());
 
-		buffer.Cleanup();
+		Image.Assume({ ImageInfo.Layout, dstAccess, dstStage });
 	}
 
 	void TextureDescriptor::Create(vk::VulkanApp& app, DescriptorPoolManager& pm, const VkDescriptorType type)
@@ -4,6 +4,7 @@
 #include "image.h"
 #include "descriptor.h"
 #include "pool.h"
+#include "upload_context.h"
 
 namespace vk
 {	
@@ -27,6 +28,8 @@ namespace vk
 		ImageChannels Channels;
 	};
 
+	std::optional<VkSampler> CreateSampler(const vk::VulkanApp& app, const TextureParams& params);
+
 	class Texture
 	{
 	private:
@@ -49,13 +52,16 @@ namespace vk
 			Image.Cleanup();
 		}
 
-		void Update(void* data, const size_t pixelStride);
+		//Only records the copy, the data is on the gpu in the texture layout once the upload batch is finished
+		void Update(vk::UploadContext& uploads, void* data, const size_t pixelStride,
+					const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess);
 
-		inline void SetLayout(const VkQueue queue, const VkCommandPool commandPool,
-						      void(*layoutFunc)(const vk::VulkanApp&, const VkQueue, const VkCommandPool, const VkImage, const uint8_t))
+		//Records the barriers right away, batch the image directly to combine several transitions
+		inline void Transition(const VkCommandBuffer commandBuffer, const ImageUsage usage)
 		{
-			if (layoutFunc)
-				layoutFunc(*App, queue, commandPool, Image.GetHandler(), Image.GetMipLevels());
+			BarrierBatch batch;
+			Image.Transition(batch, usage);
+			batch.Flush(*App, commandBuffer);
 		}
 
 		inline vk::Image GetImage() const
@@ -102,6 +108,21 @@ namespace vk
 			ImageInfos.ImageInfos.push_back(texture.GetInfo());
 		}
 
+		//For images not owned by a texture, e.g. frame graph attachments
+		inline void LinkImage(const VkDescriptorImageInfo& info, const uint8_t bindId,
+							  const VkShaderStageFlags stages = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT)
+		{
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = bindId;
+			layoutBinding.descriptorCount = 1;
+			layoutBinding.pImmutableSamplers = nullptr;
+			layoutBinding.stageFlags = stages;
+
+			ImageInfos.LayoutBindInfos.push_back({ layoutBinding });
+
+			ImageInfos.ImageInfos.push_back(info);
+		}
+
 		inline Descriptor GetDescriptorInfo() const
 		{
 			return DescriptorInfo;
@@ -50,7 +50,7 @@ namespace vk
 				descriptorWrite.dstArrayElement = 0;
 				descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 				descriptorWrite.descriptorCount = 1;
-				descriptorWrite.pBufferInfo = UboInfos.BufferInfos[i].data();
+				descriptorWrite.pBufferInfo = &UboInfos.BufferInfos[i][j];
 
 				vkUpdateDescriptorSets(app.Device, 1, &descriptorWrite, 0, nullptr);
 			}
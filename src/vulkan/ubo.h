@@ -71,6 +71,12 @@ namespace vk
 		{
 			return Type;
 		}
+
+		//Never set up, e.g. the material ubo of a shader without one
+		inline bool IsEmpty() const
+		{
+			return Buffers.empty();
+		}
 	};
 
 	class UboDescriptor
@@ -122,6 +128,30 @@ namespace vk
 			UboInfos.BufferInfos.push_back(ubo.GetBufferInfos());
 		}
 
+		//Ranges of buffers owned elsewhere, one per swapchain image, e.g. the copies of an object buffer slot.
+		//Behaves like a dynamic ubo
+		inline void LinkBuffers(const std::vector<VkDescriptorBufferInfo>& bufferInfos, const uint8_t bindId)
+		{
+			if (UboInfos.BufferInfos.empty())
+				FirstBufferType = UboType::Dynamic;
+
+			if (FirstBufferType != UboType::Dynamic)
+			{
+				LOGE("Invalid descriptor ubo formed, all buffers types must be the same!");
+				return;
+			}
+
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = bindId;
+			layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			layoutBinding.descriptorCount = 1;
+			layoutBinding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+
+			UboInfos.LayoutBindInfos.push_back({ layoutBinding });
+
+			UboInfos.BufferInfos.push_back(bufferInfos);
+		}
+
 		inline Descriptor GetDescriptorInfo() const
 		{
 			return DescriptorInfo;
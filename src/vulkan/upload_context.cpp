@@ -0,0 +1,346 @@
+#include "upload_context.h"
+#include <cstring>
+
+namespace vk
+{
+	bool UploadContext::AcquireBatch(UploadBatch& batch)
+	{
+		if (!FreeBatches.empty())
+		{
+			batch = std::move(FreeBatches.back());
+			FreeBatches.pop_back();
+
+			vkResetCommandBuffer(batch.CommandBuffer, 0);
+			vkResetFences(App->Device, 1, &batch.Fence);
+
+			if (DedicatedTransfer)
+				vkResetCommandBuffer(batch.AcquireCommandBuffer, 0);
+
+			return true;
+		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = TransferPool;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(App->Device, &allocInfo, &batch.CommandBuffer) != VK_SUCCESS)
+			return false;
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkCreateFence(App->Device, &fenceInfo, nullptr, &batch.Fence) != VK_SUCCESS)
+			return false;
+
+		if (DedicatedTransfer)
+		{
+			allocInfo.commandPool = GraphicsPool;
+
+			if (vkAllocateCommandBuffers(App->Device, &allocInfo, &batch.AcquireCommandBuffer) != VK_SUCCESS)
+				return false;
+
+			VkSemaphoreCreateInfo semaphoreInfo{};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			if (vkCreateSemaphore(App->Device, &semaphoreInfo, nullptr, &batch.TransferFinished) != VK_SUCCESS)
+				return false;
+		}
+
+		return true;
+	}
+
+	void UploadContext::RetireBatch(UploadBatch& batch)
+	{
+		CompletedTicket = std::max(CompletedTicket, batch.Ticket);
+
+		Ring.Release(CompletedTicket);
+
+		FreeBatches.push_back(std::move(batch));
+	}
+
+	bool UploadContext::Setup(vk::VulkanApp& app)
+	{
+		App = &app;
+		DedicatedTransfer = HasDedicatedTransferQueue(app);
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = app.QueueFamilies.Transfer;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(app.Device, &poolInfo, nullptr, &TransferPool) != VK_SUCCESS)
+			return false;
+
+		if (DedicatedTransfer)
+		{
+			poolInfo.queueFamilyIndex = app.QueueFamilies.Graphics;
+
+			if (vkCreateCommandPool(app.Device, &poolInfo, nullptr, &GraphicsPool) != VK_SUCCESS)
+				return false;
+		}
+
+		return Ring.Setup(app);
+	}
+
+	void UploadContext::Cleanup()
+	{
+		WaitAll();
+
+		//Command buffers go with their pools
+		for (const auto& b : FreeBatches)
+		{
+			vkDestroyFence(App->Device, b.Fence, nullptr);
+
+			if (DedicatedTransfer)
+				vkDestroySemaphore(App->Device, b.TransferFinished, nullptr);
+		}
+
+		FreeBatches.clear();
+
+		vkDestroyCommandPool(App->Device, TransferPool, nullptr);
+		vkDestroyCommandPool(App->Device, GraphicsPool, nullptr);
+
+		Ring.Cleanup();
+	}
+
+	VkCommandBuffer UploadContext::GetCommandBuffer()
+	{
+		if (IsRecording)
+			return Recording.CommandBuffer;
+
+		auto res = AcquireBatch(Recording);
+		ASSERT(res, "Couldn't allocate upload batch!");
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(Recording.CommandBuffer, &beginInfo);
+
+		if (DedicatedTransfer)
+			vkBeginCommandBuffer(Recording.AcquireCommandBuffer, &beginInfo);
+
+		IsRecording = true;
+
+		return Recording.CommandBuffer;
+	}
+
+	void UploadContext::HandOffImage(const VkImage image, const uint8_t mipLevels, const uint32_t layersCount, const VkImageLayout layout,
+									 const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess, const bool concurrent)
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = layersCount;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+
+		if (!DedicatedTransfer)
+		{
+			vkCmdPipelineBarrier(GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+								 0, 0, nullptr, 0, nullptr, 1, &barrier);
+			return;
+		}
+
+		//Semaphore wait on the graphics queue makes the transition visible there
+		if (concurrent)
+		{
+			barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+								 0, 0, nullptr, 0, nullptr, 1, &barrier);
+			return;
+		}
+
+		barrier.srcQueueFamilyIndex = App->QueueFamilies.Transfer;
+		barrier.dstQueueFamilyIndex = App->QueueFamilies.Graphics;
+
+		//Release half, destination access is ignored on the transfer queue
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+							 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		//Acquire half repeats the same layout transition on the graphics queue
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(Recording.AcquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage,
+							 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	void UploadContext::HandOffBuffer(const VkBuffer buffer, const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess)
+	{
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+
+		if (!DedicatedTransfer)
+		{
+			vkCmdPipelineBarrier(GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+								 0, 0, nullptr, 1, &barrier, 0, nullptr);
+			return;
+		}
+
+		barrier.srcQueueFamilyIndex = App->QueueFamilies.Transfer;
+		barrier.dstQueueFamilyIndex = App->QueueFamilies.Graphics;
+
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+							 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(Recording.AcquireCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage,
+							 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	uint64_t UploadContext::Submit()
+	{
+		if (!IsRecording)
+			return SubmittedTicket;
+
+		vkEndCommandBuffer(Recording.CommandBuffer);
+
+		std::lock_guard<std::mutex> lock(App->QueueMutex);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &Recording.CommandBuffer;
+
+		if (!DedicatedTransfer)
+		{
+			auto res = vkQueueSubmit(App->TransferQueue, 1, &submitInfo, Recording.Fence);
+			ASSERT(res == VK_SUCCESS, "Couldn't submit upload batch!");
+		}
+		else
+		{
+			vkEndCommandBuffer(Recording.AcquireCommandBuffer);
+
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &Recording.TransferFinished;
+
+			auto res = vkQueueSubmit(App->TransferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+			ASSERT(res == VK_SUCCESS, "Couldn't submit upload batch!");
+
+			//Graphics work submitted after this waits for the transfer through queue order
+			VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			VkSubmitInfo acquireInfo{};
+			acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			acquireInfo.waitSemaphoreCount = 1;
+			acquireInfo.pWaitSemaphores = &Recording.TransferFinished;
+			acquireInfo.pWaitDstStageMask = &waitStage;
+			acquireInfo.commandBufferCount = 1;
+			acquireInfo.pCommandBuffers = &Recording.AcquireCommandBuffer;
+
+			res = vkQueueSubmit(App->GraphicsQueue, 1, &acquireInfo, Recording.Fence);
+			ASSERT(res == VK_SUCCESS, "Couldn't submit upload ownership acquire!");
+		}
+
+		Recording.Ticket = ++SubmittedTicket;
+
+		InFlight.push_back(std::move(Recording));
+		Recording = {};
+		IsRecording = false;
+
+		return SubmittedTicket;
+	}
+
+	void UploadContext::Poll()
+	{
+		size_t keepCount = 0;
+
+		for (size_t i = 0; i < InFlight.size(); ++i)
+		{
+			if (vkGetFenceStatus(App->Device, InFlight[i].Fence) == VK_SUCCESS)
+			{
+				RetireBatch(InFlight[i]);
+				continue;
+			}
+
+			if (keepCount != i)
+				InFlight[keepCount] = std::move(InFlight[i]);
+
+			++keepCount;
+		}
+
+		InFlight.resize(keepCount);
+	}
+
+	void UploadContext::Wait(const uint64_t ticket)
+	{
+		if (IsComplete(ticket))
+			return;
+
+		if (ticket > SubmittedTicket)
+			Submit();
+
+		std::vector<VkFence> fences;
+		for (const auto& b : InFlight)
+		{
+			if (b.Ticket <= ticket)
+				fences.push_back(b.Fence);
+		}
+
+		if (!fences.empty())
+			vkWaitForFences(App->Device, fences.size(), fences.data(), VK_TRUE, UINT64_MAX);
+
+		Poll();
+	}
+
+	StagingRegion UploadContext::AllocateStaging(const VkDeviceSize size, const VkDeviceSize alignment)
+	{
+		ASSERT(size <= Ring.GetCapacity(), "Staging allocation is bigger than the ring!");
+
+		while (true)
+		{
+			//Region is tagged with the recorded batch, so it has to exist before allocation
+			GetCommandBuffer();
+
+			auto region = Ring.Allocate(size, alignment, SubmittedTicket + 1);
+			if (region)
+				return *region;
+
+			Submit();
+			Wait(InFlight.front().Ticket);
+		}
+	}
+
+	void UploadContext::UploadBuffer(const vk::Buffer& buffer, const void* data, const VkDeviceSize size,
+									 const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess)
+	{
+		const auto* src = static_cast<const uint8_t*>(data);
+
+		for (VkDeviceSize offset = 0; offset < size; offset += GetMaxChunkSize())
+		{
+			VkDeviceSize chunkSize = std::min(GetMaxChunkSize(), size - offset);
+
+			auto region = AllocateStaging(chunkSize, 4);
+			std::memcpy(region.Data, src + offset, chunkSize);
+
+			VkBufferCopy copy{};
+			copy.srcOffset = region.Offset;
+			copy.dstOffset = offset;
+			copy.size = chunkSize;
+
+			vkCmdCopyBuffer(GetCommandBuffer(), Ring.GetHandler(), buffer.GetHandler(), 1, &copy);
+		}
+
+		HandOffBuffer(buffer.GetHandler(), dstStage, dstAccess);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+#include "vrender.h"
+
+#include "vulkan_app.h"
+#include "buffer.h"
+#include "staging_ring.h"
+
+namespace vk
+{
+	struct UploadBatch
+	{
+		VkCommandBuffer CommandBuffer;
+		VkFence Fence;
+
+		//With a dedicated transfer queue ownership is acquired by a graphics queue submission
+		//that waits for the transfer one
+		VkCommandBuffer AcquireCommandBuffer = VK_NULL_HANDLE;
+		VkSemaphore TransferFinished = VK_NULL_HANDLE;
+
+		uint64_t Ticket = 0;
+	};
+
+	//Records copies and layout transitions into one command buffer and submits them with a single fence.
+	//Every submission gets a ticket, callers can poll it instead of waiting on the queue. Command pools are
+	//its own, so contexts used on different threads don't need to synchronize recording
+	class UploadContext
+	{
+	private:
+		UploadBatch Recording;
+		bool IsRecording = false;
+
+		std::vector<UploadBatch> InFlight;
+		std::vector<UploadBatch> FreeBatches;
+
+		vk::StagingRing Ring;
+
+		uint64_t SubmittedTicket = 0;
+		uint64_t CompletedTicket = 0;
+
+		bool DedicatedTransfer;
+
+		VkCommandPool TransferPool = VK_NULL_HANDLE;
+		//Ownership acquires, only with a dedicated transfer queue
+		VkCommandPool GraphicsPool = VK_NULL_HANDLE;
+
+		vk::VulkanApp* App;
+
+		[[nodiscard]]
+		bool AcquireBatch(UploadBatch& batch);
+
+		void RetireBatch(UploadBatch& batch);
+	public:
+		//Uploads run on the transfer queue, which falls back to the graphics one when the device has no dedicated family
+		bool Setup(vk::VulkanApp& app);
+
+		void Cleanup();
+
+		//Begins a new batch if nothing is being recorded, the buffer may be executed on the transfer queue
+		VkCommandBuffer GetCommandBuffer();
+
+		//Executed on the graphics queue after the transfer work of the same batch
+		inline VkCommandBuffer GetGraphicsCommandBuffer()
+		{
+			GetCommandBuffer();
+
+			return DedicatedTransfer ? Recording.AcquireCommandBuffer : Recording.CommandBuffer;
+		}
+
+		//Transitions an image written with transfer commands and hands it to the graphics queue family,
+		//concurrent images only need the transition
+		void HandOffImage(const VkImage image, const uint8_t mipLevels, const uint32_t layersCount, const VkImageLayout layout,
+						  const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess, const bool concurrent = false);
+
+		void HandOffBuffer(const VkBuffer buffer, const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess);
+
+		//Region stays valid until the batch it's recorded into is finished. When the ring is full
+		//the current batch is submitted and the oldest one waited, so staging memory never grows
+		StagingRegion AllocateStaging(const VkDeviceSize size, const VkDeviceSize alignment);
+
+		//Large uploads are split into chunks of this size to stream through the ring
+		inline VkDeviceSize GetMaxChunkSize() const
+		{
+			return Ring.GetCapacity() / 4;
+		}
+
+		inline VkBuffer GetStagingBuffer() const
+		{
+			return Ring.GetHandler();
+		}
+
+		void UploadBuffer(const vk::Buffer& buffer, const void* data, const VkDeviceSize size,
+						  const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess);
+
+		//Returns the ticket of the submitted batch, or the last one if there was nothing to submit
+		uint64_t Submit();
+
+		void Poll();
+
+		void Wait(const uint64_t ticket);
+
+		inline void WaitAll()
+		{
+			Wait(Submit());
+		}
+
+		inline bool IsComplete(const uint64_t ticket) const
+		{
+			return ticket <= CompletedTicket;
+		}
+
+		//Ticket the currently recorded work will get after submission
+		inline uint64_t GetPendingTicket() const
+		{
+			return IsRecording ? SubmittedTicket + 1 : SubmittedTicket;
+		}
+	};
+}
\ No newline at end of file
@@ -21,7 +21,6 @@ namespace vk
 
 	const std::vector<const char*> DesiredDeviceExtensions =
 	{
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 		VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME
 	};
 
@@ -85,20 +84,24 @@ namespace vk
 		VkApplicationInfo appInfo{};
 		appInfo.pApplicationName = "";
 		appInfo.pEngineName = "";
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = VK_API_VERSION_1_2;
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
 		appInfo.pNext = nullptr;
 
-		uint32_t extensionsCount = 0;
-		auto&& glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionsCount);
+		std::vector<const char*> desiredExtensions = DesiredInstanceExtensions;
 
-		if (!glfwExtensions)
-			return false;
+		if (!app.Headless)
+		{
+			uint32_t extensionsCount = 0;
+			auto&& glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionsCount);
 
-		std::vector<const char*> desiredExtensions(glfwExtensions, glfwExtensions + extensionsCount);
-		desiredExtensions.insert(desiredExtensions.begin(), DesiredInstanceExtensions.begin(), DesiredInstanceExtensions.end());
+			if (!glfwExtensions)
+				return false;
+
+			desiredExtensions.insert(desiredExtensions.end(), glfwExtensions, glfwExtensions + extensionsCount);
+		}
 
 		if constexpr (EnableValidationLayers)
 			desiredExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -195,8 +198,10 @@ namespace vk
 			if (properties[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
 				qf.Compute = i;
 
-			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(pd, i, app.Surface, &presentSupport);
+			//Headless apps never present, the graphics queue stands in
+			VkBool32 presentSupport = app.Headless && (properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT);
+			if (!app.Headless)
+				vkGetPhysicalDeviceSurfaceSupportKHR(pd, i, app.Surface, &presentSupport);
 			if (presentSupport)
 				qf.Present = i;
 
@@ -207,11 +212,46 @@ namespace vk
 				break;
 			}
 		}
+
+		for (size_t i = 0; i < properties.size(); ++i)
+		{
+			if ((properties[i].queueFlags & VK_QUEUE_TRANSFER_BIT)
+				&& !(properties[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+			{
+				qf.Transfer = i;
+				break;
+			}
+		}
+
+		//Compute family without graphics runs in parallel with rendering
+		for (size_t i = 0; i < properties.size(); ++i)
+		{
+			if ((properties[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
+				&& !(properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				qf.Compute = i;
+				break;
+			}
+		}
+
+		//Graphics queues always support transfers
+		if (qf.Transfer == -1)
+			qf.Transfer = qf.Graphics;
 		
 		return qf;
 	}
 
-	bool CheckDeviceExtensions(VkPhysicalDevice pd)
+	std::vector<const char*> GetRequiredDeviceExtensions(const VulkanApp& app)
+	{
+		std::vector<const char*> extensions = DesiredDeviceExtensions;
+
+		if (!app.Headless)
+			extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+		return extensions;
+	}
+
+	bool CheckDeviceExtensions(const VulkanApp& app, VkPhysicalDevice pd)
 	{
 		uint32_t extensionsCount = 0;
 		vkEnumerateDeviceExtensionProperties(pd, nullptr, &extensionsCount, nullptr);
@@ -219,7 +259,8 @@ namespace vk
 		std::vector<VkExtensionProperties> availableExtensions(extensionsCount);
 		vkEnumerateDeviceExtensionProperties(pd, nullptr, &extensionsCount, &availableExtensions[0]);
 
-		std::set<std::string> requiredExtensions(DesiredDeviceExtensions.begin(), DesiredDeviceExtensions.end());
+		auto desiredExtensions = GetRequiredDeviceExtensions(app);
+		std::set<std::string> requiredExtensions(desiredExtensions.begin(), desiredExtensions.end());
 
 		for (const auto& e : availableExtensions)
 			requiredExtensions.erase(e.extensionName);
@@ -227,6 +268,23 @@ namespace vk
 		return requiredExtensions.empty();
 	}
 
+	bool IsDeviceExtensionAvailable(VkPhysicalDevice pd, const char* name)
+	{
+		uint32_t extensionsCount = 0;
+		vkEnumerateDeviceExtensionProperties(pd, nullptr, &extensionsCount, nullptr);
+
+		std::vector<VkExtensionProperties> availableExtensions(extensionsCount);
+		vkEnumerateDeviceExtensionProperties(pd, nullptr, &extensionsCount, &availableExtensions[0]);
+
+		for (const auto& e : availableExtensions)
+		{
+			if (strcmp(e.extensionName, name) == 0)
+				return true;
+		}
+
+		return false;
+	}
+
 	struct SwapChainDetails
 	{
 		VkSurfaceCapabilitiesKHR Capabilities;
@@ -262,14 +320,23 @@ namespace vk
 		VkPhysicalDeviceFeatures deviceFeatures;
 		vkGetPhysicalDeviceFeatures(pd, &deviceFeatures);
 
-		auto details = QuerySwapChainDetails(app, pd);
-		bool swapChainValid = !(details.PresentModes.empty() && details.Formats.empty());
+		bool swapChainValid = app.Headless;
+		if (!app.Headless)
+		{
+			auto details = QuerySwapChainDetails(app, pd);
+			swapChainValid = !(details.PresentModes.empty() && details.Formats.empty());
+		}
 
 		auto qf = FindVulkanQueueFamilies(app, pd);
-		bool queueFamiliesValid = qf.Graphics != -1 & qf.Present != -1;
+		bool queueFamiliesValid = qf.Graphics != -1 & qf.Present != -1 & qf.Compute != -1;
+
+		//Timeline semaphores are core since 1.2
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(pd, &properties);
 		
 		return queueFamiliesValid
-			   && CheckDeviceExtensions(pd)
+			   && properties.apiVersion >= VK_API_VERSION_1_2
+			   && CheckDeviceExtensions(app, pd)
 			   && swapChainValid
 			   && deviceFeatures.samplerAnisotropy;
 	}
@@ -300,7 +367,8 @@ namespace vk
 		app.QueueFamilies = FindVulkanQueueFamilies(app, app.PhysicalDevice);
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<int32_t> queueFamiliesSet = { app.QueueFamilies.Graphics, app.QueueFamilies.Present };
+		std::set<int32_t> queueFamiliesSet = { app.QueueFamilies.Graphics, app.QueueFamilies.Present,
+											   app.QueueFamilies.Compute, app.QueueFamilies.Transfer };
 
 		float queuePriority = 1.0f;
 
@@ -321,14 +389,52 @@ namespace vk
 		VkPhysicalDeviceExtendedDynamicStateFeaturesEXT dynamicState{};
 		dynamicState.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
 		dynamicState.extendedDynamicState = VK_TRUE;
+
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphore{};
+		timelineSemaphore.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timelineSemaphore.timelineSemaphore = VK_TRUE;
+
+		dynamicState.pNext = &timelineSemaphore;
+
+		//Optional features, queried first and enabled with the same structures
+		VkPhysicalDeviceImagelessFramebufferFeatures imagelessFramebuffer{};
+		imagelessFramebuffer.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGELESS_FRAMEBUFFER_FEATURES;
+
+		VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2{};
+		synchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+		std::vector<const char*> deviceExtensions = GetRequiredDeviceExtensions(app);
+
+		bool hasSynchronization2 = IsDeviceExtensionAvailable(app.PhysicalDevice, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+		imagelessFramebuffer.pNext = hasSynchronization2 ? &synchronization2 : nullptr;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures{};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &imagelessFramebuffer;
+
+		vkGetPhysicalDeviceFeatures2(app.PhysicalDevice, &supportedFeatures);
+
+		app.Features.ImagelessFramebuffer = imagelessFramebuffer.imagelessFramebuffer;
+		app.Features.Synchronization2 = hasSynchronization2 && synchronization2.synchronization2;
+
+		if (app.Features.Synchronization2)
+			deviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+		app.Features.MemoryBudget = IsDeviceExtensionAvailable(app.PhysicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		if (app.Features.MemoryBudget)
+			deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		timelineSemaphore.pNext = &imagelessFramebuffer;
 		
 		VkDeviceCreateInfo deviceCreateInfo{};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 		deviceCreateInfo.queueCreateInfoCount = queueCreateInfos.size();
 		deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
-		deviceCreateInfo.ppEnabledExtensionNames = DesiredDeviceExtensions.data();
-		deviceCreateInfo.enabledExtensionCount = DesiredDeviceExtensions.size();
+		deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		deviceCreateInfo.enabledExtensionCount = deviceExtensions.size();
 		deviceCreateInfo.pNext = &dynamicState;
 
 		if (vkCreateDevice(app.PhysicalDevice, &deviceCreateInfo, nullptr, &app.Device) != VK_SUCCESS)
@@ -337,6 +443,7 @@ namespace vk
 		vkGetDeviceQueue(app.Device, app.QueueFamilies.Graphics, 0, &app.GraphicsQueue);
 		vkGetDeviceQueue(app.Device, app.QueueFamilies.Compute, 0, &app.ComputeQueue);
 		vkGetDeviceQueue(app.Device, app.QueueFamilies.Present, 0, &app.PresentQueue);
+		vkGetDeviceQueue(app.Device, app.QueueFamilies.Transfer, 0, &app.TransferQueue);
 
 		vkGetPhysicalDeviceProperties(app.PhysicalDevice, &app.DeviceProperties);
 
@@ -360,6 +467,18 @@ namespace vk
 			if (vkCreateCommandPool(app.Device, &poolInfo, nullptr, &app.CommandPoolCQ) != VK_SUCCESS)
 				return false;
 		}
+
+		{
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = app.QueueFamilies.Transfer;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+			if (vkCreateCommandPool(app.Device, &poolInfo, nullptr, &app.CommandPoolTQ) != VK_SUCCESS)
+				return false;
+		}
+
+		return true;
 	}
 
 	VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& formats)
@@ -544,8 +663,79 @@ namespace vk
 		return true;
 	}
 
-	bool SetupVulkanApp(const uint16_t width, const uint16_t height, VulkanApp& app)
+	bool CreateHeadlessImages(VulkanApp& app, const VkExtent2D& extent)
 	{
+		CreateDepthImage(app, extent);
+
+		app.SwapChainFormat = VK_FORMAT_B8G8R8A8_SRGB;
+		app.SwapChainExtent = extent;
+
+		app.SwapChainImages.resize(HeadlessImagesCount);
+		app.SwapChainImageViews.resize(HeadlessImagesCount);
+		app.HeadlessImagesMemory.resize(HeadlessImagesCount);
+
+		for (size_t i = 0; i < HeadlessImagesCount; ++i)
+		{
+			VkImageCreateInfo imageCreateInfo{};
+			imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.format = app.SwapChainFormat;
+			imageCreateInfo.extent = { extent.width, extent.height, 1 };
+			imageCreateInfo.mipLevels = 1;
+			imageCreateInfo.arrayLayers = 1;
+			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+			if (vkCreateImage(app.Device, &imageCreateInfo, nullptr, &app.SwapChainImages[i]) != VK_SUCCESS)
+				return false;
+
+			VkMemoryRequirements imageMemRequirements;
+			vkGetImageMemoryRequirements(app.Device, app.SwapChainImages[i], &imageMemRequirements);
+
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = imageMemRequirements.size;
+			allocInfo.memoryTypeIndex = FindMemoryType(app, imageMemRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			if (vkAllocateMemory(app.Device, &allocInfo, nullptr, &app.HeadlessImagesMemory[i]) != VK_SUCCESS)
+				return false;
+
+			vkBindImageMemory(app.Device, app.SwapChainImages[i], app.HeadlessImagesMemory[i], 0);
+
+			VkImageViewCreateInfo createInfo{};
+			createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			createInfo.image = app.SwapChainImages[i];
+			createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			createInfo.format = app.SwapChainFormat;
+			createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			createInfo.subresourceRange.baseMipLevel = 0;
+			createInfo.subresourceRange.levelCount = 1;
+			createInfo.subresourceRange.baseArrayLayer = 0;
+			createInfo.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(app.Device, &createInfo, nullptr, &app.SwapChainImageViews[i]) != VK_SUCCESS)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool SetupVulkanApp(const uint16_t width, const uint16_t height, VulkanApp& app, const bool headless)
+	{
+		app.Headless = headless;
+
+		if (headless)
+		{
+			if (!CreateVulkanInstance(app))
+				return false;
+
+			if (!SetupDevice(app))
+				return false;
+
+			return CreateHeadlessImages(app, { width, height });
+		}
+
 		if (!glfwInit())
 			return false;
 
@@ -570,10 +760,17 @@ namespace vk
 
 		if (!CreateSwapChain(app))
 			return false;
+
+		return true;
 	}
 
 	void CleanVulkanApp(VulkanApp& app)
 	{
+		vkDeviceWaitIdle(app.Device);
+
+		app.CompletedFrame = app.SubmittedFrame;
+		app.DeletionQueue.FlushAll();
+
 		vkDestroyImageView(app.Device, app.DepthImageView, nullptr);
 		vkDestroyImage(app.Device, app.DepthImage, nullptr);
 		vkFreeMemory(app.Device, app.DepthImageMemory, nullptr);
@@ -581,26 +778,81 @@ namespace vk
 		for (size_t i = 0; i < app.SwapChainImageViews.size(); i++)
 			vkDestroyImageView(app.Device, app.SwapChainImageViews[i], nullptr);
 
-		vkDestroySwapchainKHR(app.Device, app.SwapChain, nullptr);
+		if (app.Headless)
+		{
+			for (size_t i = 0; i < app.SwapChainImages.size(); ++i)
+			{
+				vkDestroyImage(app.Device, app.SwapChainImages[i], nullptr);
+				vkFreeMemory(app.Device, app.HeadlessImagesMemory[i], nullptr);
+			}
+		}
+		else
+		{
+			vkDestroySwapchainKHR(app.Device, app.SwapChain, nullptr);
+		}
 
+		vkDestroyCommandPool(app.Device, app.CommandPoolTQ, nullptr);
 		vkDestroyCommandPool(app.Device, app.CommandPoolCQ, nullptr);
 		vkDestroyCommandPool(app.Device, app.CommandPoolGQ, nullptr);
 
 		vkDestroyDevice(app.Device, nullptr);
 
-		vkDestroySurfaceKHR(app.Instance, app.Surface, nullptr);
+		if (!app.Headless)
+			vkDestroySurfaceKHR(app.Instance, app.Surface, nullptr);
 
 		DestroyDebugUtilsMessengerEXT(app.Instance, app.DebugMessenger, nullptr);
 
 		vkDestroyInstance(app.Instance, nullptr);
 
-		glfwDestroyWindow(app.GlfwWindow);
+		if (!app.Headless)
+		{
+			glfwDestroyWindow(app.GlfwWindow);
+
+			glfwTerminate();
+		}
+	}
 
-		glfwTerminate();
+	void CompleteFrames(VulkanApp& app, const uint64_t completedFrame)
+	{
+		if (completedFrame > app.CompletedFrame)
+			app.CompletedFrame = completedFrame;
+
+		app.DeletionQueue.Flush(app.CompletedFrame);
 	}
 
+	std::optional<DeviceMemoryUsage> GetDeviceMemoryUsage(const VulkanApp& app)
+	{
+		if (!app.Features.MemoryBudget)
+			return std::nullopt;
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budget;
+
+		vkGetPhysicalDeviceMemoryProperties2(app.PhysicalDevice, &properties);
+
+		DeviceMemoryUsage usage;
+		for (uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount; ++i)
+		{
+			usage.Used += budget.heapUsage[i];
+			usage.Budget += budget.heapBudget[i];
+		}
+
+		return usage;
+	}
+
+	//Headless apps have no window to close, they are driven frame by frame by the caller
 	void RunVulkanApp(VulkanApp& app, const std::function<void()>& callback)
 	{
+		if (app.Headless)
+		{
+			LOGE("Headless app can't run until its window is closed!");
+			return;
+		}
+
 		while (!glfwWindowShouldClose(app.GlfwWindow))
 		{
 			glfwPollEvents();
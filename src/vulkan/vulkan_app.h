@@ -1,6 +1,11 @@
 #pragma once
 #include "vrender.h"
 
+#include <optional>
+#include <mutex>
+
+#include "deletion_queue.h"
+
 namespace vk
 {
 	struct VulkanQueueFamilies
@@ -8,33 +13,62 @@ namespace vk
 		int32_t Graphics = -1;
 		int32_t Compute = -1;
 		int32_t Present = -1;
+		//Transfer only family if the device has one, otherwise the graphics one
+		int32_t Transfer = -1;
+	};
+
+	//Enabled only when the device supports them
+	struct VulkanOptionalFeatures
+	{
+		bool ImagelessFramebuffer = false;
+		bool Synchronization2 = false;
+		bool MemoryBudget = false;
 	};
 
+	struct DeviceMemoryUsage
+	{
+		VkDeviceSize Used = 0;
+		VkDeviceSize Budget = 0;
+	};
+
+	//Headless apps render into as many offscreen images as a swapchain would have
+	constexpr uint32_t HeadlessImagesCount = 2;
+
 	struct VulkanApp
 	{
-		GLFWwindow* GlfwWindow;
+		//No window, surface or swapchain, swapchain images are plain offscreen images
+		bool Headless = false;
+
+		GLFWwindow* GlfwWindow = nullptr;
 
 		VkInstance Instance;
 
 		VkDebugUtilsMessengerEXT DebugMessenger;
 
-		VkSurfaceKHR Surface;
+		VkSurfaceKHR Surface = VK_NULL_HANDLE;
 
-		VkPhysicalDevice PhysicalDevice;
+		VkPhysicalDevice PhysicalDevice = VK_NULL_HANDLE;
 		VkDevice Device;
 
 		VkPhysicalDeviceProperties DeviceProperties;
+		VulkanOptionalFeatures Features;
 
 		VulkanQueueFamilies QueueFamilies;
 
 		VkQueue GraphicsQueue;
 		VkQueue ComputeQueue;
 		VkQueue PresentQueue;
+		VkQueue TransferQueue;
+
+		//Queues may alias each other and uploads are submitted from loading threads as well, so every
+		//submission and present holds it
+		std::mutex QueueMutex;
 
 		VkCommandPool CommandPoolGQ;
 		VkCommandPool CommandPoolCQ;
+		VkCommandPool CommandPoolTQ;
 
-		VkSwapchainKHR SwapChain;
+		VkSwapchainKHR SwapChain = VK_NULL_HANDLE;
 
 		VkImage DepthImage;
 		VkDeviceMemory DepthImageMemory;
@@ -47,10 +81,33 @@ namespace vk
 
 		std::vector<VkImage> SwapChainImages;
 		std::vector<VkImageView> SwapChainImageViews;
+		std::vector<VkDeviceMemory> HeadlessImagesMemory;
+
+		//Frame counters work as a timeline, resources tagged with a frame are freed once it's completed
+		uint64_t SubmittedFrame = 0;
+		uint64_t CompletedFrame = 0;
+
+		vk::DeletionQueue DeletionQueue;
 	};
 
-	bool API SetupVulkanApp(const uint16_t width, const uint16_t height, VulkanApp& app);
+	bool API SetupVulkanApp(const uint16_t width, const uint16_t height, VulkanApp& app, const bool headless = false);
 	void API CleanVulkanApp(VulkanApp& app);
 
 	void API RunVulkanApp(VulkanApp& app, const std::function<void()>& callback);
+
+	//Tag resource with the last frame recording it, usually SubmittedFrame + 1 while the current frame is still being built
+	inline void DeferCleanup(VulkanApp& app, const uint64_t lastUsedFrame, std::function<void()>&& cleanup)
+	{
+		app.DeletionQueue.Push(lastUsedFrame, std::move(cleanup));
+	}
+
+	void API CompleteFrames(VulkanApp& app, const uint64_t completedFrame);
+
+	//Summed over all heaps, nothing without VK_EXT_memory_budget
+	std::optional<DeviceMemoryUsage> API GetDeviceMemoryUsage(const VulkanApp& app);
+
+	inline bool HasDedicatedTransferQueue(const VulkanApp& app)
+	{
+		return app.QueueFamilies.Transfer != app.QueueFamilies.Graphics;
+	}
 }
\ No newline at end of file